@@ -0,0 +1,87 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include <LuaCpp/LuaHeaders.hpp>
+
+/**
+ * @brief A registered benchmark
+ */
+struct Benchmark
+{
+	const char* name;
+	void (*function)();
+};
+
+inline std::vector<Benchmark>& getBenchmarks()
+{
+	static std::vector<Benchmark> benchmarks;
+	return benchmarks;
+}
+
+struct BenchmarkRegistration
+{
+	BenchmarkRegistration(const char* name, void (*function)())
+	{
+		Benchmark bench = { name, function };
+		getBenchmarks().push_back(bench);
+	}
+};
+
+/**
+ * @brief Defines a benchmark function which is run by the benchmark executable
+ */
+#define BENCHMARK(name) \
+	void bench_##name(); \
+	static BenchmarkRegistration bench_registration_##name(#name, &bench_##name); \
+	void bench_##name()
+
+/**
+ * @brief Runs @c function @c iterations times and prints the time per iteration.
+ *
+ * @return double The time per iteration in nanoseconds
+ */
+template<typename Function>
+double measure(const char* label, size_t iterations, Function function)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (size_t i = 0; i < iterations; ++i)
+	{
+		function();
+	}
+
+	std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+
+	double nsPerIteration = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+
+	std::printf("  %-40s %12.1f ns/op\n", label, nsPerIteration);
+
+	return nsPerIteration;
+}
+
+/**
+ * @brief Owns a lua state with the standard libraries for the duration of a benchmark
+ */
+class BenchState
+{
+public:
+	lua_State* L;
+
+	BenchState()
+	{
+		L = luaL_newstate();
+		luaL_openlibs(L);
+	}
+
+	~BenchState()
+	{
+		lua_close(L);
+	}
+};
+
+#endif // BENCH_UTIL_H
@@ -0,0 +1,28 @@
+
+#include "BenchUtil.hpp"
+
+#include "LuaCpp/LuaFunction.hpp"
+
+using namespace luacpp;
+
+BENCHMARK(BudgetHookOverhead)
+{
+	BenchState state;
+
+	LuaFunction func = LuaFunction::createFromCode(state.L, "local x = 0; for i = 1, 100000 do x = x + i end; return x");
+
+	measure("no budget", 200, [&]() { func.call(); });
+
+	const int intervals[] = { 10, 100, 1000, 10000 };
+	for (int interval : intervals)
+	{
+		ExecutionBudget budget;
+		budget.maxTime = std::chrono::seconds(10);
+		budget.checkInterval = interval;
+
+		char label[64];
+		std::snprintf(label, sizeof(label), "budget, check interval %d", interval);
+
+		measure(label, 200, [&]() { func.callWithBudget(budget); });
+	}
+}
@@ -0,0 +1,31 @@
+
+#include "BenchUtil.hpp"
+
+#include "LuaCpp/LuaFunction.hpp"
+
+using namespace luacpp;
+
+namespace
+{
+	int messageHandler(lua_State* L)
+	{
+		return 1;
+	}
+}
+
+BENCHMARK(ErrorHandlerHappyPath)
+{
+	BenchState state;
+
+	LuaFunction func = LuaFunction::createFromCode(state.L, "return 1");
+
+	measure("no error handler", 1000000, [&]() { func.call(); });
+
+	func.setTracebackHandler(true);
+
+	measure("traceback handler", 1000000, [&]() { func.call(); });
+
+	func.setErrorFunction(LuaFunction::createFromCFunction(state.L, &messageHandler));
+
+	measure("error function from registry", 1000000, [&]() { func.call(); });
+}
@@ -0,0 +1,56 @@
+
+#include "BenchUtil.hpp"
+
+#include "LuaCpp/LuaJson.hpp"
+#include "LuaCpp/LuaTable.hpp"
+
+using namespace luacpp;
+
+namespace
+{
+	std::string createPayload()
+	{
+		std::string text = "{\"items\":[";
+
+		for (int i = 0; i < 1000; ++i)
+		{
+			if (i > 0)
+			{
+				text += ",";
+			}
+
+			text += "{\"id\":" + std::to_string(i) + ",\"name\":\"item " + std::to_string(i) +
+				"\",\"price\":12.75,\"tags\":[\"a\",\"b\",\"c\"],\"available\":true}";
+		}
+
+		text += "]}";
+
+		return text;
+	}
+}
+
+BENCHMARK(Json)
+{
+	BenchState state;
+
+	std::string text = createPayload();
+
+	LuaValue value = json::decode(state.L, text);
+
+	const size_t iterations = 100;
+
+	measure("json::decode, 1000 records", iterations, [&]() { json::decode(state.L, text); });
+	measure("json::encode, 1000 records", iterations, [&]() { json::encode(value); });
+
+	std::string output;
+	output.reserve(text.size());
+
+	measure("json::encode into reused buffer", iterations, [&]()
+	{
+		output.clear();
+
+		value.pushValue();
+		json::encode(state.L, -1, output);
+		lua_pop(state.L, 1);
+	});
+}
@@ -0,0 +1,87 @@
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "BenchUtil.hpp"
+
+#include "LuaCpp/LuaMsgPack.hpp"
+#include "LuaCpp/LuaJson.hpp"
+#include "LuaCpp/LuaUtil.hpp"
+
+using namespace luacpp;
+
+BENCHMARK(MsgPackRecord)
+{
+	BenchState state;
+
+	// A flat record with string fields, the shape util::tableListPairs can handle
+	luaL_dostring(state.L,
+		"local record = {}\n"
+		"for i = 1, 100 do record['field' .. i] = 'value ' .. i end\n"
+		"return record\n");
+
+	LuaTable record = convert::popValue<LuaTable>(state.L);
+
+	const size_t iterations = 10000;
+
+	std::vector<std::pair<std::string, std::string>> pairs;
+
+	measure("tableListPairs + pairsToTable", iterations, [&]()
+	{
+		util::tableListPairs(record, pairs);
+		util::pairsToTable(state.L, pairs);
+	});
+
+	measure("json encode + decode", iterations, [&]()
+	{
+		json::decode(state.L, json::encode(record));
+	});
+
+	measure("msgpack encode + decode", iterations, [&]()
+	{
+		msgpack::decode(state.L, msgpack::encode(record));
+	});
+}
+
+BENCHMARK(MsgPackPayload)
+{
+	BenchState state;
+
+	luaL_dostring(state.L,
+		"local items = {}\n"
+		"for i = 1, 1000 do\n"
+		"	items[i] = { id = i, name = 'item ' .. i, price = 12.75, tags = { 'a', 'b', 'c' }, available = true }\n"
+		"end\n"
+		"return { items = items }\n");
+
+	LuaValue payload = convert::popValue<LuaValue>(state.L);
+
+	std::string jsonText = json::encode(payload);
+	std::string packed = msgpack::encode(payload);
+
+	std::printf("  %-40s %12u bytes\n", "json size", static_cast<unsigned int>(jsonText.size()));
+	std::printf("  %-40s %12u bytes\n", "msgpack size", static_cast<unsigned int>(packed.size()));
+
+	const size_t iterations = 100;
+
+	measure("json::encode", iterations, [&]() { json::encode(payload); });
+	measure("msgpack::encode", iterations, [&]() { msgpack::encode(payload); });
+	measure("json::decode", iterations, [&]() { json::decode(state.L, jsonText); });
+	measure("msgpack::decode", iterations, [&]() { msgpack::decode(state.L, packed); });
+
+	measure("msgpack::StreamDecoder, 1 KiB pieces", iterations, [&]()
+	{
+		msgpack::StreamDecoder decoder;
+
+		for (size_t offset = 0; offset < packed.size(); offset += 1024)
+		{
+			decoder.feed(packed.data() + offset, std::min<size_t>(1024, packed.size() - offset));
+
+			while (decoder.next(state.L))
+			{
+				lua_pop(state.L, 1);
+			}
+		}
+	});
+}
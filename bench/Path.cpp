@@ -0,0 +1,37 @@
+
+#include "BenchUtil.hpp"
+
+#include "LuaCpp/LuaPath.hpp"
+
+using namespace luacpp;
+
+BENCHMARK(PathLookup)
+{
+	BenchState state;
+
+	luaL_dostring(state.L, "settings = { render = { shadows = { quality = 3 } } }");
+
+	lua_getglobal(state.L, "settings");
+	LuaTable settings = convert::popValue<LuaTable>(state.L);
+
+	LuaPath path = LuaPath::create(state.L, "render.shadows.quality");
+
+	const size_t iterations = 1000000;
+
+	measure("nested LuaTable::getValue", iterations, [&]()
+	{
+		LuaTable render = settings.getValue<LuaTable>("render");
+		LuaTable shadows = render.getValue<LuaTable>("shadows");
+		shadows.getValue<int>("quality");
+	});
+
+	measure("LuaPath::getValue", iterations, [&]()
+	{
+		path.getValue<int>(settings);
+	});
+
+	measure("LuaPath::setValue", iterations, [&]()
+	{
+		path.setValue(settings, 4);
+	});
+}
@@ -0,0 +1,54 @@
+
+#include "BenchUtil.hpp"
+
+#include "LuaCpp/LuaSerialize.hpp"
+#include "LuaCpp/LuaFunction.hpp"
+
+using namespace luacpp;
+
+namespace
+{
+	// Builds a table similar to typical script state: records with a few fields in an array
+	const char* const createState =
+		"local state = { players = {} }\n"
+		"for i = 1, 1000 do\n"
+		"	state.players[i] = { name = 'player' .. i, level = i % 50, health = 100.5, alive = true, "
+		"		position = { x = i * 1.5, y = i * 2, z = 0 } }\n"
+		"end\n"
+		"return state\n";
+
+	// A serializer written in lua which produces lua code, this is what serialize replaces
+	const char* const luaSerializer =
+		"local function write(value, out)\n"
+		"	local t = type(value)\n"
+		"	if t == 'table' then\n"
+		"		out[#out + 1] = '{'\n"
+		"		for k, v in pairs(value) do\n"
+		"			out[#out + 1] = '['; write(k, out); out[#out + 1] = ']='; write(v, out); out[#out + 1] = ','\n"
+		"		end\n"
+		"		out[#out + 1] = '}'\n"
+		"	elseif t == 'string' then\n"
+		"		out[#out + 1] = string.format('%q', value)\n"
+		"	else\n"
+		"		out[#out + 1] = tostring(value)\n"
+		"	end\n"
+		"end\n"
+		"return function(value) local out = {}; write(value, out); return table.concat(out) end\n";
+}
+
+BENCHMARK(Serialize)
+{
+	BenchState state;
+
+	LuaValue value = LuaFunction::createFromCode(state.L, createState).callTyped<LuaValue>();
+	LuaFunction serializer = LuaFunction::createFromCode(state.L, luaSerializer).callTyped<LuaFunction>();
+
+	std::string data = serialize::toString(value);
+	std::printf("  %-40s %12u bytes\n", "serialized size", static_cast<unsigned int>(data.size()));
+
+	const size_t iterations = 100;
+
+	measure("serialize in lua", iterations, [&]() { serializer.callTyped<std::string>(value); });
+	measure("serialize::toString", iterations, [&]() { serialize::toString(value); });
+	measure("serialize::read", iterations, [&]() { serialize::read(state.L, data); });
+}
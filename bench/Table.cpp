@@ -0,0 +1,145 @@
+
+#include <cstdlib>
+#include <vector>
+
+#include "BenchUtil.hpp"
+
+#include "LuaCpp/LuaTable.hpp"
+#include "LuaCpp/LuaUtil.hpp"
+
+using namespace luacpp;
+
+namespace
+{
+	const int FIELD_COUNT = 50;
+
+	const char* const fieldNames[FIELD_COUNT] = {
+		"f00", "f01", "f02", "f03", "f04", "f05", "f06", "f07", "f08", "f09",
+		"f10", "f11", "f12", "f13", "f14", "f15", "f16", "f17", "f18", "f19",
+		"f20", "f21", "f22", "f23", "f24", "f25", "f26", "f27", "f28", "f29",
+		"f30", "f31", "f32", "f33", "f34", "f35", "f36", "f37", "f38", "f39",
+		"f40", "f41", "f42", "f43", "f44", "f45", "f46", "f47", "f48", "f49",
+	};
+
+	size_t allocationCount = 0;
+
+	/**
+	 * @brief A lua allocator which counts the allocations and reallocations
+	 */
+	void* countingAlloc(void* ud, void* ptr, size_t osize, size_t nsize)
+	{
+		if (nsize == 0)
+		{
+			std::free(ptr);
+			return nullptr;
+		}
+
+		++allocationCount;
+
+		return std::realloc(ptr, nsize);
+	}
+
+	/**
+	 * @brief Prints the number of allocations done by @c function
+	 */
+	template<typename Function>
+	void countAllocations(const char* label, Function function)
+	{
+		size_t before = allocationCount;
+
+		function();
+
+		std::printf("  %-40s %12u allocs\n", label, static_cast<unsigned int>(allocationCount - before));
+	}
+}
+
+BENCHMARK(TableRecordFill)
+{
+	BenchState state;
+
+	LuaTable table = LuaTable::create(state.L);
+
+	const size_t iterations = 100000;
+
+	measure("addValue, 50 fields", iterations, [&]()
+	{
+		for (int i = 0; i < FIELD_COUNT; ++i)
+		{
+			table.addValue(fieldNames[i], i);
+		}
+	});
+
+	measure("Accessor::set, 50 fields", iterations, [&]()
+	{
+		LuaTable::Accessor access(table);
+
+		for (int i = 0; i < FIELD_COUNT; ++i)
+		{
+			access.set(fieldNames[i], i);
+		}
+	});
+
+	measure("getValue, 50 fields", iterations, [&]()
+	{
+		int value;
+
+		for (int i = 0; i < FIELD_COUNT; ++i)
+		{
+			table.getValue(fieldNames[i], value);
+		}
+	});
+
+	measure("Accessor::get, 50 fields", iterations, [&]()
+	{
+		LuaTable::Accessor access(table);
+		int value;
+
+		for (int i = 0; i < FIELD_COUNT; ++i)
+		{
+			access.get(fieldNames[i], value);
+		}
+	});
+}
+
+BENCHMARK(TableCreateSized)
+{
+	lua_State* L = lua_newstate(&countingAlloc, nullptr);
+
+	const int elementCount = 1000;
+	const size_t iterations = 1000;
+
+	std::vector<double> values(elementCount, 1.0);
+
+	auto fillArray = [&](LuaTable& table)
+	{
+		LuaTable::Accessor access(table);
+
+		for (int i = 1; i <= elementCount; ++i)
+		{
+			access.rawSetI(i, 1.0);
+		}
+	};
+
+	auto fillRecord = [&](LuaTable& table)
+	{
+		LuaTable::Accessor access(table);
+
+		for (int i = 0; i < FIELD_COUNT; ++i)
+		{
+			access.rawSet(fieldNames[i], i);
+		}
+	};
+
+	countAllocations("array, unsized", [&]() { LuaTable table = LuaTable::create(L); fillArray(table); });
+	countAllocations("array, sized", [&]() { LuaTable table = LuaTable::create(L, elementCount, 0); fillArray(table); });
+	countAllocations("record, unsized", [&]() { LuaTable table = LuaTable::create(L); fillRecord(table); });
+	countAllocations("record, sized", [&]() { LuaTable table = LuaTable::create(L, 0, FIELD_COUNT); fillRecord(table); });
+	countAllocations("util::listToTable", [&]() { util::listToTable(L, values); });
+
+	measure("array, unsized", iterations, [&]() { LuaTable table = LuaTable::create(L); fillArray(table); });
+	measure("array, sized", iterations, [&]() { LuaTable table = LuaTable::create(L, elementCount, 0); fillArray(table); });
+	measure("record, unsized", iterations, [&]() { LuaTable table = LuaTable::create(L); fillRecord(table); });
+	measure("record, sized", iterations, [&]() { LuaTable table = LuaTable::create(L, 0, FIELD_COUNT); fillRecord(table); });
+
+	lua_close(L);
+}
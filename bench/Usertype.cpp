@@ -0,0 +1,53 @@
+
+#include "BenchUtil.hpp"
+
+#include "LuaCpp/LuaUsertype.hpp"
+
+using namespace luacpp;
+
+namespace
+{
+	struct Accumulator
+	{
+		double sum;
+
+		Accumulator() : sum(0.0) {}
+
+		double add(double value) { sum += value; return sum; }
+	};
+
+	double addFree(double a, double b)
+	{
+		return a + b;
+	}
+}
+
+BENCHMARK(UsertypeMethodCall)
+{
+	BenchState state;
+
+	Usertype<Accumulator>(state.L, "Accumulator").addMethod("add", &Accumulator::add);
+
+	Usertype<Accumulator>::push(state.L, Accumulator());
+	lua_setglobal(state.L, "accumulator");
+
+	lua_pushcfunction(state.L, (&bind::wrap<decltype(addFree), &addFree>));
+	lua_setglobal(state.L, "addFree");
+
+	const int iterations = 1000000;
+
+	LuaFunction emptyLoop = LuaFunction::createFromCode(state.L,
+		"for i = 1, 1000000 do end");
+	LuaFunction methodLoop = LuaFunction::createFromCode(state.L,
+		"local a = accumulator; for i = 1, 1000000 do a:add(i) end");
+	LuaFunction functionLoop = LuaFunction::createFromCode(state.L,
+		"local f = addFree; for i = 1, 1000000 do f(i, i) end");
+
+	// Every loop runs a million iterations, the time of the empty loop is subtracted from the others
+	double loop = measure("empty loop", 5, [&]() { emptyLoop.call(); });
+	double method = measure("method call loop", 5, [&]() { methodLoop.call(); });
+	double function = measure("bound function loop", 5, [&]() { functionLoop.call(); });
+
+	std::printf("  %-40s %12.1f ns/op\n", "method call", (method - loop) / iterations);
+	std::printf("  %-40s %12.1f ns/op\n", "bound function call", (function - loop) / iterations);
+}
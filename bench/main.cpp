@@ -0,0 +1,23 @@
+
+#include <cstring>
+
+#include "BenchUtil.hpp"
+
+int main(int argc, char** argv)
+{
+	// An optional argument selects the benchmarks containing it in their name
+	const char* filter = argc > 1 ? argv[1] : nullptr;
+
+	for (const Benchmark& bench : getBenchmarks())
+	{
+		if (filter != nullptr && std::strstr(bench.name, filter) == nullptr)
+		{
+			continue;
+		}
+
+		std::printf("%s\n", bench.name);
+		bench.function();
+	}
+
+	return 0;
+}
@@ -3,6 +3,8 @@
 #define LUA_ARGS_H
 #pragma once
 
+#include <string>
+#include <utility>
 #include <type_traits>
 
 #include "LuaCpp/LuaHeaders.hpp"
@@ -82,6 +84,223 @@ namespace luacpp
 		{
 			return getArgsInternal(L, false, 1, lua_gettop(L), target, args...);
 		}
+
+		/**
+		 * @brief The outcome of checkArgs
+		 */
+		struct ArgumentStatus
+		{
+			int index; //!< The stack index of the first bad argument, 0 if all arguments are valid
+			const char* expected; //!< The name of the expected type, @c nullptr if all arguments are valid
+
+			ArgumentStatus() : index(0), expected(nullptr) {}
+
+			bool isOk() const { return index == 0; }
+		};
+
+		/**
+		 * @brief An argument which gets a default value if it is none or nil. Created with defaultValue().
+		 */
+		template<typename T>
+		struct DefaultArgument
+		{
+			T& target;
+			T value;
+		};
+
+		/**
+		 * @brief Marks an argument of checkArgs as optional.
+		 *
+		 * @param target The location of the value
+		 * @param value The value which is used if the argument is missing or nil
+		 * @return luacpp::args::DefaultArgument<T> The argument
+		 */
+		template<typename T, typename Default>
+		inline DefaultArgument<T> defaultValue(T& target, Default&& value)
+		{
+			return DefaultArgument<T>{ target, T(std::forward<Default>(value)) };
+		}
+
+		/**
+		 * @brief Reads an argument without throwing, may be specialized for other types.
+		 * The generic version uses convert::popValue and catches its exception.
+		 */
+		template<typename T, typename Enable = void>
+		struct ArgumentReader
+		{
+			static const char* expected() { return "value"; }
+
+			static bool read(lua_State* L, int index, T& target)
+			{
+				return !lua_isnone(L, index) && convert::popValue(L, target, index, false);
+			}
+		};
+
+		template<typename T>
+		struct ArgumentReader<T, typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value>::type>
+		{
+			static const char* expected() { return "number"; }
+
+			static bool read(lua_State* L, int index, T& target)
+			{
+				if (!lua_isnumber(L, index))
+				{
+					return false;
+				}
+
+				target = static_cast<T>(lua_tonumber(L, index));
+				return true;
+			}
+		};
+
+		template<>
+		struct ArgumentReader<bool>
+		{
+			static const char* expected() { return "boolean"; }
+
+			static bool read(lua_State* L, int index, bool& target)
+			{
+				if (!lua_isboolean(L, index))
+				{
+					return false;
+				}
+
+				target = lua_toboolean(L, index) != 0;
+				return true;
+			}
+		};
+
+		template<>
+		struct ArgumentReader<std::string>
+		{
+			static const char* expected() { return "string"; }
+
+			static bool read(lua_State* L, int index, std::string& target)
+			{
+				size_t length;
+				const char* str = lua_isstring(L, index) ? lua_tolstring(L, index, &length) : nullptr;
+
+				if (str == nullptr)
+				{
+					return false;
+				}
+
+				target.assign(str, length);
+				return true;
+			}
+		};
+
+		/**
+		 * @brief Strings can be read without copying, the pointer is valid until the value is removed from the stack
+		 */
+		template<>
+		struct ArgumentReader<const char*>
+		{
+			static const char* expected() { return "string"; }
+
+			static bool read(lua_State* L, int index, const char*& target)
+			{
+				if (!lua_isstring(L, index))
+				{
+					return false;
+				}
+
+				target = lua_tostring(L, index);
+				return true;
+			}
+		};
+
+		template<typename T>
+		struct ArgumentReader<DefaultArgument<T>>
+		{
+			static const char* expected() { return ArgumentReader<T>::expected(); }
+
+			static bool read(lua_State* L, int index, DefaultArgument<T>& argument)
+			{
+				if (lua_isnoneornil(L, index))
+				{
+					argument.target = argument.value;
+					return true;
+				}
+
+				return ArgumentReader<T>::read(L, index, argument.target);
+			}
+		};
+
+		template<typename T>
+		inline bool readArgument(lua_State* L, int index, T& target, ArgumentStatus& status)
+		{
+			if (ArgumentReader<T>::read(L, index, target))
+			{
+				return true;
+			}
+
+			status.index = index;
+			status.expected = ArgumentReader<T>::expected();
+
+			return false;
+		}
+
+		template<typename... Targets, size_t... Indices>
+		inline ArgumentStatus checkArgsInternal(lua_State* L, std::index_sequence<Indices...>, Targets&... targets)
+		{
+			ArgumentStatus status;
+
+			// Initializer lists are evaluated in order, reading stops at the first bad argument
+			const bool results[] = { true, (status.isOk() && readArgument(L, static_cast<int>(Indices) + 1, targets, status))... };
+			(void)results;
+
+			return status;
+		}
+
+		/**
+		 * @brief Reads the arguments of a lua_CFunction without throwing exceptions.
+		 *
+		 * Reads the values at the stack positions 1 to the number of targets. Unlike getArgs() the arguments are
+		 * only checked with the lua API and errors are reported through the returned status. Wrap a target with
+		 * defaultValue() to make it optional. Values of types without a specialized ArgumentReader are converted
+		 * with convert::popValue.
+		 *
+		 * @code
+		 * int scale(lua_State* L)
+		 * {
+		 * 	double value;
+		 * 	double factor;
+		 * 	args::ArgumentStatus status = args::checkArgs(L, value, args::defaultValue(factor, 2.0));
+		 *
+		 * 	if (!status.isOk())
+		 * 	{
+		 * 		return args::raiseError(L, status);
+		 * 	}
+		 * 	...
+		 * }
+		 * @endcode
+		 *
+		 * @param L The lua state
+		 * @param targets The locations of the values
+		 * @return luacpp::args::ArgumentStatus The position and the expected type of the first bad argument
+		 */
+		template<typename... Targets>
+		inline ArgumentStatus checkArgs(lua_State* L, Targets&&... targets)
+		{
+			return checkArgsInternal(L, std::index_sequence_for<Targets...>(), targets...);
+		}
+
+		/**
+		 * @brief Raises a lua error for a failed checkArgs with luaL_argerror.
+		 * This does not return, as it leaves the function with longjmp no object with a destructor, e.g. a
+		 * std::string, may be alive in the calling function.
+		 *
+		 * @param L The lua state
+		 * @param status The failed status
+		 * @return int Never returns, the return type allows writing <tt>return raiseError(L, status);</tt>
+		 */
+		inline int raiseError(lua_State* L, const ArgumentStatus& status)
+		{
+			const char* message = lua_pushfstring(L, "%s expected, got %s", status.expected, luaL_typename(L, status.index));
+
+			return luaL_argerror(L, status.index, message);
+		}
 	}
 }
 
@@ -0,0 +1,264 @@
+#ifndef LUA_ARRAY_VIEW_H
+#define LUA_ARRAY_VIEW_H
+#pragma once
+
+#include <new>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#include "LuaCpp/LuaHeaders.hpp"
+#include "LuaCpp/LuaException.hpp"
+
+#include <boost/smart_ptr.hpp>
+
+namespace luacpp
+{
+	namespace detail
+	{
+		template<typename T>
+		struct ArrayViewTag
+		{
+			static char tag;
+		};
+
+		template<typename T>
+		char ArrayViewTag<T>::tag = 0;
+
+		template<typename T>
+		struct ArrayViewData
+		{
+			const void* tag; //!< Identifies the element type, must be the first member
+			T* data;
+			size_t length;
+			bool readOnly;
+			boost::shared_ptr<void> owner; //!< Keeps the buffer alive, may be empty
+		};
+	}
+
+	/**
+	 * @brief Exposes a contiguous C++ buffer of numbers to lua without copying it.
+	 *
+	 * The view is a userdata which stores a pointer to the buffer and its length. Lua code reads and writes the
+	 * elements in place with the index operator using indices starting at 1, the @c # operator returns the
+	 * length. Accessing an index outside of the buffer raises an error and so does assigning to a read-only view.
+	 * Integer elements only accept numbers which they can represent exactly.
+	 *
+	 * The buffer must stay valid as long as lua can access the view. Either the caller guarantees this or an
+	 * owner is passed which is kept alive until the view is collected.
+	 *
+	 * @tparam T The element type, must be an arithmetic type
+	 */
+	template<typename T>
+	class ArrayView
+	{
+		static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value,
+			"Array views are only supported for numbers!");
+
+	public:
+		/**
+		 * @brief Pushes a view of the buffer.
+		 *
+		 * @param L The lua state
+		 * @param data The first element of the buffer
+		 * @param length The number of elements
+		 * @param readOnly @c true if lua may not modify the buffer
+		 * @param owner An object which is kept alive as long as the view exists, may be empty
+		 */
+		static void push(lua_State* L, T* data, size_t length, bool readOnly = false,
+			const boost::shared_ptr<void>& owner = boost::shared_ptr<void>())
+		{
+			void* memory = lua_newuserdata(L, sizeof(detail::ArrayViewData<T>));
+
+			detail::ArrayViewData<T>* view = new (memory) detail::ArrayViewData<T>();
+			view->tag = &detail::ArrayViewTag<T>::tag;
+			view->data = data;
+			view->length = length;
+			view->readOnly = readOnly;
+			view->owner = owner;
+
+			pushMetatable(L);
+			lua_setmetatable(L, -2);
+		}
+
+		/**
+		 * @brief Pushes a read-only view of the buffer. See push().
+		 */
+		static void push(lua_State* L, const T* data, size_t length,
+			const boost::shared_ptr<void>& owner = boost::shared_ptr<void>())
+		{
+			push(L, const_cast<T*>(data), length, true, owner);
+		}
+
+		/**
+		 * @brief Gets the buffer of the view at the given stack position.
+		 *
+		 * @param L The lua state
+		 * @param index The stack position
+		 * @param length Receives the number of elements, may be @c nullptr
+		 * @return T* The buffer or @c nullptr if the value is no view with this element type
+		 */
+		static T* get(lua_State* L, int index, size_t* length = nullptr)
+		{
+			detail::ArrayViewData<T>* view = toView(L, index);
+
+			if (view == nullptr)
+			{
+				return nullptr;
+			}
+
+			if (length != nullptr)
+			{
+				*length = view->length;
+			}
+
+			return view->data;
+		}
+
+	private:
+		static detail::ArrayViewData<T>* toView(lua_State* L, int index)
+		{
+			if (lua_type(L, index) != LUA_TUSERDATA || lua_objlen(L, index) != sizeof(detail::ArrayViewData<T>))
+			{
+				return nullptr;
+			}
+
+			detail::ArrayViewData<T>* view = static_cast<detail::ArrayViewData<T>*>(lua_touserdata(L, index));
+
+			if (view->tag != &detail::ArrayViewTag<T>::tag)
+			{
+				return nullptr;
+			}
+
+			return view;
+		}
+
+		/**
+		 * @brief Pushes the metatable of this element type, it is created once per state
+		 */
+		static void pushMetatable(lua_State* L)
+		{
+			lua_pushlightuserdata(L, &detail::ArrayViewTag<T>::tag);
+			lua_rawget(L, LUA_REGISTRYINDEX);
+
+			if (!lua_isnil(L, -1))
+			{
+				return;
+			}
+
+			lua_pop(L, 1);
+
+			lua_createtable(L, 0, 5);
+
+			lua_pushcfunction(L, &ArrayView::index);
+			lua_setfield(L, -2, "__index");
+
+			lua_pushcfunction(L, &ArrayView::newIndex);
+			lua_setfield(L, -2, "__newindex");
+
+			lua_pushcfunction(L, &ArrayView::length);
+			lua_setfield(L, -2, "__len");
+
+			lua_pushcfunction(L, &ArrayView::collect);
+			lua_setfield(L, -2, "__gc");
+
+			lua_pushboolean(L, 0);
+			lua_setfield(L, -2, "__metatable");
+
+			lua_pushlightuserdata(L, &detail::ArrayViewTag<T>::tag);
+			lua_pushvalue(L, -2);
+			lua_rawset(L, LUA_REGISTRYINDEX);
+		}
+
+		/**
+		 * @brief Checks the key at stack position 2 and returns the zero based position of the element
+		 */
+		static size_t checkPosition(lua_State* L, detail::ArrayViewData<T>* view)
+		{
+			lua_Number key = luaL_checknumber(L, 2);
+
+			if (key < 1 || key > static_cast<lua_Number>(view->length) || std::floor(key) != key)
+			{
+				luaL_error(L, "array index %f out of range (length %d)", key, static_cast<int>(view->length));
+			}
+
+			return static_cast<size_t>(key) - 1;
+		}
+
+		/**
+		 * @brief Checks that the number at the given stack position can be stored in an integer element
+		 */
+		static T checkValue(lua_State* L, int stackIndex, std::true_type)
+		{
+			lua_Number value = luaL_checknumber(L, stackIndex);
+
+			// The limits are powers of two so they are exact as floating point numbers
+			lua_Number upper = std::ldexp(static_cast<lua_Number>(1), std::numeric_limits<T>::digits);
+			lua_Number lower = std::numeric_limits<T>::is_signed ? -upper : 0;
+
+			if (!(value >= lower && value < upper) || std::floor(value) != value)
+			{
+				luaL_argerror(L, stackIndex, "number has no exact representation in the array element type");
+			}
+
+			return static_cast<T>(value);
+		}
+
+		static T checkValue(lua_State* L, int stackIndex, std::false_type)
+		{
+			return static_cast<T>(luaL_checknumber(L, stackIndex));
+		}
+
+		static int index(lua_State* L)
+		{
+			detail::ArrayViewData<T>* view = toView(L, 1);
+
+			size_t position = checkPosition(L, view);
+
+			lua_pushnumber(L, static_cast<lua_Number>(view->data[position]));
+
+			return 1;
+		}
+
+		static int newIndex(lua_State* L)
+		{
+			detail::ArrayViewData<T>* view = toView(L, 1);
+
+			if (view->readOnly)
+			{
+				return luaL_error(L, "attempt to modify a read-only array");
+			}
+
+			size_t position = checkPosition(L, view);
+
+			view->data[position] = checkValue(L, 3, std::is_integral<T>());
+
+			return 0;
+		}
+
+		static int length(lua_State* L)
+		{
+			lua_pushnumber(L, static_cast<lua_Number>(toView(L, 1)->length));
+
+			return 1;
+		}
+
+		static int collect(lua_State* L)
+		{
+			detail::ArrayViewData<T>* view = toView(L, 1);
+
+			if (view != nullptr)
+			{
+				typedef detail::ArrayViewData<T> ViewData;
+
+				// Releases the owner
+				view->tag = nullptr;
+				view->~ViewData();
+			}
+
+			return 0;
+		}
+	};
+}
+
+#endif // LUA_ARRAY_VIEW_H
@@ -0,0 +1,568 @@
+#ifndef LUA_BIND_H
+#define LUA_BIND_H
+#pragma once
+
+#include <new>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <exception>
+#include <functional>
+#include <type_traits>
+
+#include "LuaCpp/LuaHeaders.hpp"
+#include "LuaCpp/LuaException.hpp"
+#include "LuaCpp/LuaConvert.hpp"
+#include "LuaCpp/LuaFunction.hpp"
+
+namespace luacpp
+{
+	/**
+	 * @brief Generates lua_CFunctions from C++ functions.
+	 *
+	 * The arguments are converted with convert::popValue in the order of the parameters and the return
+	 * value is pushed with convert::pushValue. A std::tuple is returned as multiple values. When an argument
+	 * can not be converted or the function throws, the error is raised with lua_error after all C++ objects
+	 * of the call have been destroyed so no exception crosses the lua C boundary.
+	 *
+	 * Arguments in excess of the parameters are ignored. The bound function must not raise lua errors itself
+	 * as that would skip the destructors of the converted arguments.
+	 *
+	 * Parameters which are const references are converted to values, so a class which has no
+	 * convert::Converter can not be passed that way. Usertypes are passed as pointers or non-const references.
+	 */
+	namespace bind
+	{
+		namespace detail
+		{
+			/**
+			 * @brief Thrown when an argument of a bound function can not be converted
+			 */
+			class ArgumentError : public LuaException
+			{
+			public:
+				ArgumentError(int index, const std::string& message) throw() : LuaException(message), index(index)
+				{
+				}
+
+				virtual ~ArgumentError() throw()
+				{
+				}
+
+				int getIndex() const { return index; }
+
+			private:
+				int index;
+			};
+
+			/**
+			 * @brief The type in which an argument is stored while the bound function is called.
+			 * Non-const references to classes are stored as std::reference_wrapper and refer to a usertype, see
+			 * LuaUsertype.hpp. All other parameters, including const references, hold a value converted with
+			 * convert::popValue.
+			 */
+			template<typename T>
+			struct ArgumentStorage
+			{
+				typedef typename std::decay<T>::type Type;
+			};
+
+			template<typename T>
+			struct ArgumentStorage<T&>
+			{
+				typedef typename std::conditional<std::is_class<T>::value && !std::is_const<T>::value,
+					std::reference_wrapper<T>, typename std::decay<T>::type>::type Type;
+			};
+
+			template<typename Function>
+			struct FunctionTraits : public FunctionTraits<decltype(&Function::operator())>
+			{
+			};
+
+			template<typename Result, typename... Args>
+			struct FunctionTraits<Result(Args...)>
+			{
+				typedef Result ResultType;
+				typedef std::tuple<typename ArgumentStorage<Args>::Type...> ArgumentTuple;
+			};
+
+			template<typename Result, typename... Args>
+			struct FunctionTraits<Result(*)(Args...)> : public FunctionTraits<Result(Args...)>
+			{
+			};
+
+			template<typename Class, typename Result, typename... Args>
+			struct FunctionTraits<Result(Class::*)(Args...)> : public FunctionTraits<Result(Args...)>
+			{
+			};
+
+			template<typename Class, typename Result, typename... Args>
+			struct FunctionTraits<Result(Class::*)(Args...) const> : public FunctionTraits<Result(Args...)>
+			{
+			};
+
+			/**
+			 * @brief Checks if a lua value has the type of a C++ argument.
+			 * Used for selecting an overload so it only compares the lua_type without converting the value.
+			 * Types which are not known accept any value.
+			 */
+			template<typename T, typename Enable = void>
+			struct ArgumentType
+			{
+				static bool matches(lua_State* L, int index)
+				{
+					return true;
+				}
+			};
+
+			template<typename T>
+			struct ArgumentType<T, typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value>::type>
+			{
+				static bool matches(lua_State* L, int index)
+				{
+					return lua_type(L, index) == LUA_TNUMBER;
+				}
+			};
+
+			template<>
+			struct ArgumentType<bool>
+			{
+				static bool matches(lua_State* L, int index)
+				{
+					return lua_type(L, index) == LUA_TBOOLEAN;
+				}
+			};
+
+			template<>
+			struct ArgumentType<std::string>
+			{
+				static bool matches(lua_State* L, int index)
+				{
+					return lua_type(L, index) == LUA_TSTRING;
+				}
+			};
+
+			template<>
+			struct ArgumentType<LuaTable>
+			{
+				static bool matches(lua_State* L, int index)
+				{
+					return lua_type(L, index) == LUA_TTABLE;
+				}
+			};
+
+			template<>
+			struct ArgumentType<LuaFunction>
+			{
+				static bool matches(lua_State* L, int index)
+				{
+					return lua_type(L, index) == LUA_TFUNCTION;
+				}
+			};
+
+			template<typename Signature>
+			struct ArgumentType<std::function<Signature>>
+			{
+				static bool matches(lua_State* L, int index)
+				{
+					return lua_type(L, index) == LUA_TFUNCTION;
+				}
+			};
+
+			template<>
+			struct ArgumentType<lua_CFunction>
+			{
+				static bool matches(lua_State* L, int index)
+				{
+					return lua_iscfunction(L, index) != 0;
+				}
+			};
+
+			/**
+			 * @brief Converts an argument of a bound function, may be specialized for other kinds of values.
+			 * The second parameter can be used to specialize it for a group of types with std::enable_if.
+			 */
+			template<typename T, typename Enable = void>
+			struct ArgumentConverter
+			{
+				static T get(lua_State* L, int index)
+				{
+					return convert::popValue<T>(L, index, false);
+				}
+
+				static bool matches(lua_State* L, int index)
+				{
+					return ArgumentType<T>::matches(L, index);
+				}
+			};
+
+			/**
+			 * @brief Strings are passed as pointers into lua's memory, the argument stays on the stack during the
+			 * call so the pointer is valid until the function returns.
+			 */
+			template<>
+			struct ArgumentConverter<const char*>
+			{
+				static const char* get(lua_State* L, int index)
+				{
+					if (!lua_isstring(L, index))
+					{
+						throw LuaException("Specified index is no string!");
+					}
+
+					return lua_tostring(L, index);
+				}
+
+				static bool matches(lua_State* L, int index)
+				{
+					return lua_type(L, index) == LUA_TSTRING;
+				}
+			};
+
+			/**
+			 * @brief Pushes the result of a bound function, may be specialized for other kinds of values.
+			 * The second parameter can be used to specialize it for a group of types with std::enable_if.
+			 */
+			template<typename T, typename Enable = void>
+			struct ResultConverter
+			{
+				static int push(lua_State* L, const T& value)
+				{
+					convert::pushValue(L, value);
+					return 1;
+				}
+			};
+
+			/**
+			 * @brief References to usertypes, the specialization is defined in LuaUsertype.hpp which has to be
+			 * included to bind functions with such parameters.
+			 */
+			template<typename T>
+			struct ArgumentConverter<std::reference_wrapper<T>>;
+
+			template<typename... Values>
+			struct ResultConverter<std::tuple<Values...>>
+			{
+				static int push(lua_State* L, const std::tuple<Values...>& values)
+				{
+					return convert::pushTuple(L, values);
+				}
+			};
+
+			template<typename T>
+			T getArgument(lua_State* L, int index)
+			{
+				try
+				{
+					return ArgumentConverter<T>::get(L, index);
+				}
+				catch (const LuaException& err)
+				{
+					throw ArgumentError(index, err.what());
+				}
+			}
+
+			template<typename T>
+			int pushResult(lua_State* L, const T& value)
+			{
+				return ResultConverter<typename std::decay<T>::type>::push(L, value);
+			}
+
+			template<typename Result>
+			struct Invoker
+			{
+				template<typename Function, typename Arguments, size_t... Indices>
+				static int invoke(lua_State* L, Function& function, Arguments& arguments, std::index_sequence<Indices...>)
+				{
+					return pushResult(L, function(std::get<Indices>(arguments)...));
+				}
+			};
+
+			template<>
+			struct Invoker<void>
+			{
+				template<typename Function, typename Arguments, size_t... Indices>
+				static int invoke(lua_State* L, Function& function, Arguments& arguments, std::index_sequence<Indices...>)
+				{
+					function(std::get<Indices>(arguments)...);
+					return 0;
+				}
+			};
+
+			template<typename Function, typename... Args, size_t... Indices>
+			int invoke(lua_State* L, Function& function, int offset, std::tuple<Args...>*,
+				std::index_sequence<Indices...> indices)
+			{
+				typedef typename FunctionTraits<Function>::ResultType ResultType;
+
+				// The elements of a braced initializer are evaluated in order so the first bad argument is reported
+				std::tuple<Args...> arguments{ getArgument<Args>(L, offset + static_cast<int>(Indices) + 1)... };
+
+				return Invoker<ResultType>::invoke(L, function, arguments, indices);
+			}
+
+			/**
+			 * @brief Calls the function with the arguments on the stack.
+			 * Exceptions are caught and turned into lua errors once they are out of scope.
+			 *
+			 * @param offset The number of values on the stack before the first argument, e.g. 1 for methods
+			 */
+			template<typename Function>
+			int dispatch(lua_State* L, Function& function, int offset = 0)
+			{
+				typedef typename FunctionTraits<Function>::ArgumentTuple ArgumentTuple;
+
+				int argumentIndex = 0;
+
+				try
+				{
+					return invoke(L, function, offset, static_cast<ArgumentTuple*>(nullptr),
+						std::make_index_sequence<std::tuple_size<ArgumentTuple>::value>());
+				}
+				catch (const ArgumentError& err)
+				{
+					argumentIndex = err.getIndex();
+					lua_pushstring(L, err.what());
+				}
+				catch (const std::exception& err)
+				{
+					lua_pushstring(L, err.what());
+				}
+				catch (...)
+				{
+					lua_pushliteral(L, "Unknown C++ exception!");
+				}
+
+				// Only trivial objects are alive here so leaving with longjmp is safe
+				if (argumentIndex > 0)
+				{
+					return luaL_argerror(L, argumentIndex, lua_tostring(L, -1));
+				}
+
+				return lua_error(L);
+			}
+
+			template<typename Function>
+			struct OverloadMatcher : public OverloadMatcher<typename FunctionTraits<Function>::ArgumentTuple>
+			{
+			};
+
+			template<typename... Args>
+			struct OverloadMatcher<std::tuple<Args...>>
+			{
+				/**
+				 * @brief Checks the number and the types of the arguments
+				 */
+				static bool matches(lua_State* L, int offset, int numArgs)
+				{
+					if (numArgs != static_cast<int>(sizeof...(Args)))
+					{
+						return false;
+					}
+
+					return matchTypes(L, offset, std::index_sequence_for<Args...>());
+				}
+
+			private:
+				template<size_t... Indices>
+				static bool matchTypes(lua_State* L, int offset, std::index_sequence<Indices...>)
+				{
+					const bool matched[] = { true, ArgumentConverter<Args>::matches(L, offset + static_cast<int>(Indices) + 1)... };
+
+					for (bool match : matched)
+					{
+						if (!match)
+						{
+							return false;
+						}
+					}
+
+					return true;
+				}
+			};
+
+			template<size_t Index, typename Overloads>
+			int callOverload(lua_State* L, Overloads& overloads, int offset)
+			{
+				return dispatch(L, std::get<Index>(overloads.functions), offset);
+			}
+
+			template<typename Overloads, typename... Functions, size_t... Indices>
+			int dispatchOverload(lua_State* L, Overloads& overloads, int offset, std::tuple<Functions...>*,
+				std::index_sequence<Indices...>)
+			{
+				typedef bool (*Matcher)(lua_State*, int, int);
+				typedef int (*Caller)(lua_State*, Overloads&, int);
+
+				static const Matcher matchers[] = { &OverloadMatcher<Functions>::matches... };
+				static const Caller callers[] = { &callOverload<Indices, Overloads>... };
+
+				int numArgs = lua_gettop(L) - offset;
+
+				for (size_t i = 0; i < sizeof...(Functions); ++i)
+				{
+					if (matchers[i](L, offset, numArgs))
+					{
+						return callers[i](L, overloads, offset);
+					}
+				}
+
+				return luaL_error(L, "no overload matches the %d given arguments", numArgs);
+			}
+		}
+
+		/**
+		 * @brief A set of functions which are bound as one lua function. Created with overload().
+		 */
+		template<typename... Functions>
+		struct OverloadSet
+		{
+			std::tuple<Functions...> functions;
+		};
+
+		/**
+		 * @brief Creates an overload set which can be passed to pushFunction() or createFunction().
+		 *
+		 * When the function is called the first overload which has as many parameters as there are arguments and
+		 * whose parameter types match the lua types of the arguments is called. Numbers only match numbers and
+		 * strings only match strings, types which are not known to the overload resolution match every value.
+		 * Only the types are compared so no exceptions are thrown and no argument is converted twice.
+		 *
+		 * @param functions Function pointers, lambdas or std::functions
+		 * @return luacpp::bind::OverloadSet<Functions...> The overload set
+		 */
+		template<typename... Functions>
+		OverloadSet<typename std::decay<Functions>::type...> overload(Functions&&... functions)
+		{
+			OverloadSet<typename std::decay<Functions>::type...> overloads = { std::make_tuple(std::forward<Functions>(functions)...) };
+
+			return overloads;
+		}
+
+		namespace detail
+		{
+			template<typename... Functions>
+			int dispatch(lua_State* L, OverloadSet<Functions...>& overloads, int offset = 0)
+			{
+				return dispatchOverload(L, overloads, offset, static_cast<std::tuple<Functions...>*>(nullptr),
+					std::index_sequence_for<Functions...>());
+			}
+
+			template<typename Function>
+			int callStored(lua_State* L)
+			{
+				Function* function = static_cast<Function*>(lua_touserdata(L, lua_upvalueindex(1)));
+
+				return dispatch(L, *function);
+			}
+
+			template<typename Function>
+			int destroyStored(lua_State* L)
+			{
+				static_cast<Function*>(lua_touserdata(L, 1))->~Function();
+
+				return 0;
+			}
+		}
+
+		/**
+		 * @brief A lua_CFunction which calls a function known at compile time.
+		 * No state is needed so it can be used wherever a lua_CFunction is expected:
+		 * @code
+		 * lua_pushcfunction(L, (&bind::wrap<decltype(add), &add>));
+		 * @endcode
+		 *
+		 * @tparam Signature The type of the function
+		 * @tparam function The function
+		 */
+		template<typename Signature, Signature* function>
+		int wrap(lua_State* L)
+		{
+			Signature* pointer = function;
+
+			return detail::dispatch(L, pointer);
+		}
+
+		/**
+		 * @brief Pushes a lua function which calls the given callable.
+		 * The callable is moved into a userdata which is an upvalue of the created C closure, so it is only
+		 * allocated once when the function is created. Its destructor runs when the closure is collected.
+		 *
+		 * @param L The lua state
+		 * @param function A function pointer, lambda or std::function
+		 */
+		template<typename Function>
+		void pushFunction(lua_State* L, Function function)
+		{
+			typedef typename std::decay<Function>::type StoredType;
+
+			static_assert(alignof(StoredType) <= alignof(double) || alignof(StoredType) <= alignof(void*),
+				"The callable needs a stronger alignment than lua userdata provide!");
+
+			void* memory = lua_newuserdata(L, sizeof(StoredType));
+			new (memory) StoredType(std::move(function));
+
+			if (!std::is_trivially_destructible<StoredType>::value)
+			{
+				lua_createtable(L, 0, 1);
+				lua_pushcfunction(L, &detail::destroyStored<StoredType>);
+				lua_setfield(L, -2, "__gc");
+				lua_setmetatable(L, -2);
+			}
+
+			lua_pushcclosure(L, &detail::callStored<StoredType>, 1);
+		}
+
+		/**
+		 * @brief Creates a LuaFunction which calls the given callable. See pushFunction().
+		 *
+		 * @param L The lua state
+		 * @param function A function pointer, lambda or std::function
+		 * @return luacpp::LuaFunction The function object
+		 */
+		template<typename Function>
+		LuaFunction createFunction(lua_State* L, Function function)
+		{
+			pushFunction(L, std::move(function));
+
+			LuaFunction func;
+			func.setReference(LuaReference::create(L));
+
+			lua_pop(L, 1);
+
+			return func;
+		}
+	}
+
+	namespace convert
+	{
+		/**
+		 * @brief Converts between lua functions and std::function.
+		 *
+		 * Popping a function creates a std::function which holds a reference to the lua function and calls it
+		 * with LuaFunction::callTyped, so a call converts the values directly without creating a LuaValueList.
+		 * Pushing a std::function creates a C closure with bind::pushFunction which stores it in a userdata
+		 * that is destroyed by its @c __gc metamethod.
+		 */
+		template<typename Result, typename... Args>
+		struct Converter<std::function<Result(Args...)>>
+		{
+			static void push(lua_State* luaState, const std::function<Result(Args...)>& value)
+			{
+				bind::pushFunction(luaState, value);
+			}
+
+			static std::function<Result(Args...)> pop(lua_State* luaState, int stackPos, bool remove)
+			{
+				LuaFunction function = popValue<LuaFunction>(luaState, stackPos, remove);
+
+				return [function](Args... args) mutable -> Result
+				{
+					return function.template callTyped<Result>(args...);
+				};
+			}
+		};
+	}
+}
+
+#endif // LUA_BIND_H
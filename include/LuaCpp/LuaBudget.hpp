@@ -0,0 +1,129 @@
+#ifndef LUA_BUDGET_H
+#define LUA_BUDGET_H
+#pragma once
+
+#include <cstdint>
+#include <chrono>
+
+#include "LuaCpp/LuaHeaders.hpp"
+#include "LuaCpp/LuaException.hpp"
+
+namespace luacpp
+{
+	/**
+	 * @brief Limits for the execution of lua code.
+	 *
+	 * The limits are checked by a count hook which runs every @c checkInterval instructions so the
+	 * instruction limit is only enforced with that granularity.
+	 */
+	struct ExecutionBudget
+	{
+		typedef std::chrono::steady_clock Clock;
+
+		uint64_t maxInstructions; //!< The maximum number of VM instructions, 0 for no limit
+		Clock::duration maxTime; //!< The maximum wall-clock time, zero for no limit
+		int checkInterval; //!< The number of instructions between two checks
+		bool yieldInCoroutine; //!< Yield instead of raising an error if the code runs inside a coroutine
+
+		ExecutionBudget() : maxInstructions(0), maxTime(Clock::duration::zero()), checkInterval(1000),
+			yieldInCoroutine(false)
+		{
+		}
+	};
+
+	/**
+	 * @brief Thrown when lua code exceeded its ExecutionBudget.
+	 */
+	class BudgetExceededException : public LuaException
+	{
+	public:
+		BudgetExceededException(const std::string& message = "Execution budget exceeded!") throw() : LuaException(message)
+		{
+		}
+
+		virtual ~BudgetExceededException() throw()
+		{
+		}
+	};
+
+	/**
+	 * @brief Enforces an ExecutionBudget on a lua_State while it exists.
+	 *
+	 * Installs a count hook with lua_sethook and restores the previous hook when it is destroyed. A hook
+	 * which was installed before, e.g. by a LuaProfiler, still receives its events. Budgets can be nested, the
+	 * instructions are then counted for all active budgets of the state. When the budget is
+	 * exceeded the hook raises an error every time it runs so the code can not continue by catching it
+	 * with @c pcall. If ExecutionBudget::yieldInCoroutine is set and the code runs inside a coroutine, the
+	 * coroutine yields instead and the budget starts again when it is resumed.
+	 *
+	 * Coroutines inherit the hook when they are created, the budget does not apply to coroutines which
+	 * already existed. When the budget ends, coroutines on which its hook ran get the previous hook back. A
+	 * coroutine which did not run long enough for that removes the hook the next time it runs.
+	 */
+	class ScopedBudget
+	{
+	public:
+		/**
+		 * @brief Installs the budget
+		 *
+		 * @param L The lua state
+		 * @param budget The limits
+		 */
+		ScopedBudget(lua_State* L, const ExecutionBudget& budget);
+
+		/**
+		 * @brief Removes the budget and restores the previous hook.
+		 * Coroutines on which the hook ran get the previous hook back as well.
+		 */
+		~ScopedBudget();
+
+		/**
+		 * @brief Checks if the budget was exceeded.
+		 * @return bool @c true if it was
+		 */
+		bool isExceeded() const { return exceeded; }
+
+		/**
+		 * @brief Gets the number of instructions executed since the budget was installed.
+		 * This is a multiple of the check interval.
+		 *
+		 * @return uint64_t The number of instructions
+		 */
+		uint64_t getInstructions() const { return instructions; }
+
+	private:
+		ScopedBudget(const ScopedBudget&);
+		ScopedBudget& operator=(const ScopedBudget&);
+
+		static void hook(lua_State* L, lua_Debug* ar);
+
+		/**
+		 * @brief Charges the instructions and checks the limits.
+		 * @return bool @c true if this budget is exceeded
+		 */
+		bool charge(int count, ExecutionBudget::Clock::time_point now);
+
+		/**
+		 * @brief Remembers a coroutine which runs with the hook of this budget so the destructor can restore it.
+		 */
+		void addThread(lua_State* L);
+
+		lua_State* luaState;
+		ExecutionBudget budget;
+
+		ScopedBudget* outer;
+		lua_Hook previousHook;
+		int previousMask;
+		int previousCount;
+
+		int threadsRef; //!< A table with the coroutines which ran with the hook of this budget
+
+		ExecutionBudget::Clock::time_point start;
+		uint64_t instructions;
+		uint64_t sliceInstructions;
+		bool restartSlice;
+		bool exceeded;
+	};
+}
+
+#endif // LUA_BUDGET_H
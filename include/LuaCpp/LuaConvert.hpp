@@ -2,11 +2,19 @@
 #define LUAUTIL_H
 #pragma once
 
+#include <string>
+#include <tuple>
+#include <utility>
+
 #include "LuaCpp/LuaHeaders.hpp"
 #include <LuaCpp/LuaException.hpp>
 
 namespace luacpp
 {
+	class LuaValue;
+	class LuaTable;
+	class LuaFunction;
+
 	/**
 	 * @brief Contains functions to convert C++ values to and from lua values.
 	 *
@@ -21,19 +29,63 @@ namespace luacpp
 	 *   - `LuaTable` (only pop, use LuaValue version for pushing)
 	 *   - `LuaFunction` (only pop, use LuaValue version for pushing)
 	 *   - `LuaValue` (this will reference any value at the specified poition)
+	 *   - `std::function` (declared in LuaBind.hpp, see there)
+	 *
+	 * The conversions are implemented by specializations of the Converter class template.
 	 */
 	namespace convert
 	{
+		/**
+		 * @brief Converts values of one C++ type.
+		 *
+		 * For a custom type you need to specialize this template, the second parameter can be used to
+		 * specialize it for a group of types with std::enable_if. The members of the built-in specializations
+		 * are defined in LuaConvert.cpp.
+		 *
+		 * @tparam ValueType The C++ type
+		 */
+		template<class ValueType, class Enable = void>
+		struct Converter
+		{
+			static void push(lua_State* luaState, const ValueType& value);
+
+			static ValueType pop(lua_State* luaState, int stackPos, bool remove);
+		};
+
+		template<> void Converter<double>::push(lua_State* luaState, const double& value);
+		template<> void Converter<float>::push(lua_State* luaState, const float& value);
+		template<> void Converter<int>::push(lua_State* luaState, const int& value);
+		template<> void Converter<size_t>::push(lua_State* luaState, const size_t& value);
+		template<> void Converter<std::string>::push(lua_State* luaState, const std::string& value);
+		template<> void Converter<const char*>::push(lua_State* luaState, const char* const& value);
+		template<> void Converter<bool>::push(lua_State* luaState, const bool& value);
+		template<> void Converter<lua_CFunction>::push(lua_State* luaState, const lua_CFunction& value);
+		template<> void Converter<LuaValue>::push(lua_State* luaState, const LuaValue& value);
+
+		template<> double Converter<double>::pop(lua_State* luaState, int stackPos, bool remove);
+		template<> float Converter<float>::pop(lua_State* luaState, int stackPos, bool remove);
+		template<> int Converter<int>::pop(lua_State* luaState, int stackPos, bool remove);
+		template<> size_t Converter<size_t>::pop(lua_State* luaState, int stackPos, bool remove);
+		template<> std::string Converter<std::string>::pop(lua_State* luaState, int stackPos, bool remove);
+		template<> bool Converter<bool>::pop(lua_State* luaState, int stackPos, bool remove);
+		template<> lua_CFunction Converter<lua_CFunction>::pop(lua_State* luaState, int stackPos, bool remove);
+		template<> LuaTable Converter<LuaTable>::pop(lua_State* luaState, int stackPos, bool remove);
+		template<> LuaFunction Converter<LuaFunction>::pop(lua_State* luaState, int stackPos, bool remove);
+		template<> LuaValue Converter<LuaValue>::pop(lua_State* luaState, int stackPos, bool remove);
+
 		/**
 		 * @brief Pushes the lua value of the given @c value onto the lua stack.
 		 * @param luaState The lua_State to push the values to
 		 * @param value The value which should be pushed.
 		 * 
 		 * @tparam ValueType The type of the value being pushed, for a custom type you
-		 * 	need to specialize this template.
+		 * 	need to specialize Converter.
 		 */
 		template<class ValueType>
-		void pushValue(lua_State* luaState, const ValueType& value);
+		void pushValue(lua_State* luaState, const ValueType& value)
+		{
+			Converter<ValueType>::push(luaState, value);
+		}
 
 		
 		/**
@@ -49,6 +101,47 @@ namespace luacpp
 			pushValue<const char*>(luaState, value);
 		}
 
+		/**
+		 * @brief Pushes all given values onto the lua stack, the first value ends up at the lowest position.
+		 *
+		 * @param luaState The lua_State to push the values to
+		 * @return int The number of values pushed
+		 */
+		inline int pushValues(lua_State* /* luaState */)
+		{
+			return 0;
+		}
+
+		template<typename ValueType, typename... Rest>
+		int pushValues(lua_State* luaState, const ValueType& value, const Rest&... rest)
+		{
+			pushValue(luaState, value);
+
+			return 1 + pushValues(luaState, rest...);
+		}
+
+		namespace detail
+		{
+			template<typename Tuple, size_t... Indices>
+			int pushTuple(lua_State* luaState, const Tuple& values, std::index_sequence<Indices...>)
+			{
+				return pushValues(luaState, std::get<Indices>(values)...);
+			}
+		}
+
+		/**
+		 * @brief Pushes the elements of a tuple onto the lua stack. See pushValues().
+		 *
+		 * @param luaState The lua_State to push the values to
+		 * @param values The tuple containing the values
+		 * @return int The number of values pushed
+		 */
+		template<typename... Args>
+		int pushTuple(lua_State* luaState, const std::tuple<Args...>& values)
+		{
+			return detail::pushTuple(luaState, values, std::index_sequence_for<Args...>());
+		}
+
 		/**
 		* @brief Pops a value or throws an exception.
 		* If the conversion of the lua value fails, this function throws an exception.
@@ -59,7 +152,10 @@ namespace luacpp
 		* @return ValueType The type of value to be poped from the stack, must have a default and copy constructor.
 		*/
 		template<class ValueType>
-		ValueType popValue(lua_State* luaState, int stackPos = -1, bool remove = true);
+		ValueType popValue(lua_State* luaState, int stackPos = -1, bool remove = true)
+		{
+			return Converter<ValueType>::pop(luaState, stackPos, remove);
+		}
 
 		/**
 		 * @brief Pops a value from the lua stack and stors it.
@@ -5,16 +5,187 @@
 #include <vector>
 #include <string>
 #include <functional>
+#include <tuple>
+#include <chrono>
 
 #include "LuaCpp/LuaConvert.hpp"
 #include "LuaCpp/LuaValue.hpp"
 #include "LuaCpp/LuaTable.hpp"
+#include "LuaCpp/LuaBudget.hpp"
+#include "LuaCpp/LuaMetrics.hpp"
 
 namespace luacpp
 {
 	typedef std::vector<LuaValue> LuaValueList;
 	class LuaFunction;
 
+	/**
+	 * @brief The status of a function call
+	 */
+	enum class CallStatus
+	{
+		OK, //!< The call succeeded
+		RUNTIME_ERROR, //!< A runtime error occured (LUA_ERRRUN)
+		MEMORY_ERROR, //!< Lua could not allocate memory (LUA_ERRMEM)
+		ERROR_HANDLER_ERROR //!< The error function failed itself (LUA_ERRERR)
+	};
+
+	/**
+	 * @brief An error which occured while calling a lua function.
+	 *
+	 * Holds a reference to the error object instead of a copy of the message so creating it is cheap.
+	 */
+	class LuaError
+	{
+	public:
+		/**
+		 * @brief Creates an error object for a successful call
+		 */
+		LuaError() : status(CallStatus::OK) {}
+
+		/**
+		 * @brief Initializes the error
+		 *
+		 * @param status The status of the call
+		 * @param value The error object
+		 */
+		LuaError(CallStatus status, const LuaValue& value) : status(status), value(value) {}
+
+		/**
+		 * @brief Gets the status of the call.
+		 * @return luacpp::CallStatus The status
+		 */
+		CallStatus getStatus() const { return status; }
+
+		/**
+		 * @brief Gets the error object.
+		 * If an error function was set this is the value it returned, for example a message with a traceback.
+		 * The value is not valid if the call succeeded.
+		 *
+		 * @return const luacpp::LuaValue& The error object
+		 */
+		const LuaValue& getValue() const { return value; }
+
+		/**
+		 * @brief Converts the error object into a message.
+		 * This never throws, if the error object is no string a message containing its type is returned.
+		 *
+		 * @return std::string The message
+		 */
+		std::string getMessage() const;
+
+	private:
+		CallStatus status;
+		LuaValue value;
+	};
+
+	/**
+	 * @brief The result of LuaFunction::tryCall
+	 *
+	 * Contains either the values returned by the function or the error which occured.
+	 */
+	class LuaCallResult
+	{
+	public:
+		/**
+		 * @brief Checks if the call succeeded.
+		 * @return bool @c true if it did, @c false if an error occured
+		 */
+		bool isOk() const { return error.getStatus() == CallStatus::OK; }
+
+		explicit operator bool() const { return isOk(); }
+
+		/**
+		 * @brief Gets the values returned by the function. Empty if the call failed.
+		 * @return luacpp::LuaValueList& The values
+		 */
+		LuaValueList& getValues() { return values; }
+		const LuaValueList& getValues() const { return values; }
+
+		/**
+		 * @brief Gets the error. Has the status CallStatus::OK if the call succeeded.
+		 * @return const luacpp::LuaError& The error
+		 */
+		const LuaError& getError() const { return error; }
+
+	private:
+		LuaValueList values;
+		LuaError error;
+
+		friend class LuaFunction;
+	};
+
+	/**
+	 * @brief Specifies what LuaFunction::callBatch does when an element of the batch fails.
+	 */
+	enum class BatchErrorPolicy
+	{
+		ABORT, //!< Stop at the first error and throw a LuaException
+		SKIP, //!< Leave the result of the element untouched and continue with the next one
+		RECORD //!< Same as SKIP but the index and the message of the error are stored in the BatchResult
+	};
+
+	/**
+	 * @brief An error which occured while executing one element of a batch.
+	 */
+	struct BatchError
+	{
+		size_t index; //!< The index of the failed element
+		std::string message; //!< The error message
+	};
+
+	/**
+	 * @brief The outcome of LuaFunction::callBatch
+	 */
+	struct BatchResult
+	{
+		size_t succeeded; //!< The number of elements which were executed successfully
+		size_t failed; //!< The number of elements which failed
+		std::vector<BatchError> errors; //!< The errors, only filled with BatchErrorPolicy::RECORD
+
+		BatchResult() : succeeded(0), failed(0) {}
+	};
+
+	namespace detail
+	{
+		/**
+		 * @brief Converts the result of LuaFunction::callTyped
+		 */
+		template<typename ResultType>
+		struct TypedResult
+		{
+			static const int NUM_RESULTS = 1;
+
+			static ResultType get(lua_State* L, int stackTop)
+			{
+				try
+				{
+					ResultType result = convert::popValue<ResultType>(L, -1, false);
+
+					lua_settop(L, stackTop);
+
+					return result;
+				}
+				catch (...)
+				{
+					lua_settop(L, stackTop);
+					throw;
+				}
+			}
+		};
+
+		template<>
+		struct TypedResult<void>
+		{
+			static const int NUM_RESULTS = 0;
+
+			static void get(lua_State* L, int stackTop)
+			{
+				lua_settop(L, stackTop);
+			}
+		};
+	}
+
 	/**
 	 * @brief A reference to lua code.
 	 *
@@ -32,7 +203,8 @@ namespace luacpp
 		 * 
 		 * @param L The lua state
 		 * @param code The actual function code
-		 * @param name The name of the function, for debugging
+		 * @param name The name of the function, for debugging. If chunk instrumentation is enabled in the
+		 * 	MetricsRegistry of the state the function records its calls in the metrics of that name.
 		 * @return luacpp::LuaFunction The function object which can be used for calling that lua function
 		 * 
 		 * @exception LuaException Thrown when the compilation fails with the error as the execption message.
@@ -86,6 +258,49 @@ namespace luacpp
 			errorFunction = errorFunc.getReference();
 		}
 
+		/**
+		 * @brief Specifies if util::traceback is used as the error function.
+		 * The handler is pushed with lua_pushcfunction so unlike setErrorFunction() no registry access is needed
+		 * per call. An error function set with setErrorFunction() takes precedence. Unless this was called, the
+		 * default is taken from util::setDefaultTraceback() when the function gets its reference.
+		 *
+		 * @param enable @c true to append a stack traceback to error messages
+		 */
+		void setTracebackHandler(bool enable)
+		{
+			useTraceback = enable;
+			tracebackSet = true;
+		}
+
+		/**
+		 * @brief Checks if util::traceback is used as the error function.
+		 */
+		bool hasTracebackHandler() const
+		{
+			return useTraceback;
+		}
+
+		/**
+		 * @brief Sets the metrics which record the calls of this function.
+		 * The number of calls, the number of failed calls and the latency of every call through call(),
+		 * tryCall() or callBatch() is recorded. Pass @c nullptr to stop recording.
+		 *
+		 * @param functionMetrics The metrics, usually obtained from MetricsRegistry::get()
+		 */
+		void setMetrics(const FunctionMetricsPtr& functionMetrics)
+		{
+			metrics = functionMetrics;
+		}
+
+		/**
+		 * @brief Gets the metrics of this function.
+		 * @return luacpp::FunctionMetricsPtr The metrics or @c nullptr if the function is not instrumented
+		 */
+		const FunctionMetricsPtr& getMetrics() const
+		{
+			return metrics;
+		}
+
 		/**
 		 * @brief Sets a new reference.
 		 * This overload checks if the passed reference is a function
@@ -114,10 +329,193 @@ namespace luacpp
 		 * @return Same as call().
 		 */
 		LuaValueList operator()(const LuaValueList& arguments = LuaValueList());
+
+		/**
+		 * @brief Calls the function without throwing exceptions.
+		 * Does the same as call() but an error is reported through the returned object instead of
+		 * a thrown LuaException.
+		 *
+		 * @param arguments The arguments passed to the functions. Defaults to none
+		 * @return luacpp::LuaCallResult The values returned by the function or the error
+		 */
+		LuaCallResult tryCall(const LuaValueList& arguments = LuaValueList());
+
+		/**
+		 * @brief Calls the function with C++ values as arguments and converts the first return value.
+		 * The arguments are pushed with convert::pushValue and the result is converted with convert::popValue,
+		 * no LuaValueList is created.
+		 *
+		 * @param arguments The arguments
+		 * @return ResultType The first return value, nothing if ResultType is void
+		 *
+		 * @exception LuaException Thrown if an error occurs while executing the function or if the return value
+		 * 	could not be converted.
+		 */
+		template<typename ResultType = void, typename... Args>
+		ResultType callTyped(const Args&... arguments)
+		{
+			int stackTop = lua_gettop(luaState);
+			int err_idx = pushErrorFunction();
+
+			this->pushValue();
+			int numArgs = convert::pushValues(luaState, arguments...);
+
+			std::chrono::steady_clock::time_point start;
+			if (metrics)
+			{
+				start = std::chrono::steady_clock::now();
+			}
+
+			int err = lua_pcall(luaState, numArgs, detail::TypedResult<ResultType>::NUM_RESULTS, err_idx);
+
+			if (metrics)
+			{
+				recordCall(start, err != 0);
+			}
+
+			if (err)
+			{
+				size_t len;
+				const char* str = lua_tolstring(luaState, -1, &len);
+				std::string message = str ? std::string(str, len) : "Error object is not a string!";
+
+				lua_settop(luaState, stackTop);
+				throw LuaException(message);
+			}
+
+			return detail::TypedResult<ResultType>::get(luaState, stackTop);
+		}
+
+		/**
+		 * @brief Calls the function with limits on the executed instructions and the time.
+		 * A ScopedBudget is active on the state of this function while the function is executed.
+		 *
+		 * @param budget The limits
+		 * @param arguments The arguments passed to the functions. Defaults to none
+		 * @return luacpp::LuaValueList The values returned by the function call
+		 *
+		 * @exception BudgetExceededException Thrown if the function exceeded the budget.
+		 * @exception LuaException Thrown if any other error occured while executing the function.
+		 */
+		LuaValueList callWithBudget(const ExecutionBudget& budget, const LuaValueList& arguments = LuaValueList());
+
+		/**
+		 * @brief Calls the function once for every argument tuple.
+		 * The error function and the function are pushed only once for the whole batch and the stack
+		 * is restored after the last element. Every call passes the elements of one tuple as the arguments
+		 * and converts the first return value into the matching element of @c results. Apart from what
+		 * the conversion of the values needs no memory is allocated per element.
+		 *
+		 * @param arguments Pointer to @c count argument tuples
+		 * @param count The number of elements in the batch
+		 * @param results Pointer to @c count result values
+		 * @param policy Specifies what happens if an element fails. Defaults to BatchErrorPolicy::ABORT
+		 * @return luacpp::BatchResult The number of successful and failed elements
+		 *
+		 * @exception LuaException Thrown with BatchErrorPolicy::ABORT if an element fails, either because
+		 * 	of a lua error or because the return value could not be converted.
+		 */
+		template<typename ResultType, typename... Args>
+		BatchResult callBatch(const std::tuple<Args...>* arguments, size_t count, ResultType* results,
+			BatchErrorPolicy policy = BatchErrorPolicy::ABORT)
+		{
+			BatchResult batch;
+
+			int stackTop = lua_gettop(luaState);
+			int err_idx = pushErrorFunction();
+
+			this->pushValue();
+			int func_idx = lua_gettop(luaState);
+
+			try
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					lua_pushvalue(luaState, func_idx);
+					int numArgs = convert::pushTuple(luaState, arguments[i]);
+
+					std::chrono::steady_clock::time_point start;
+					if (metrics)
+					{
+						start = std::chrono::steady_clock::now();
+					}
+
+					int err = lua_pcall(luaState, numArgs, 1, err_idx);
+
+					// A return value which can not be converted fails the call as well
+					bool succeeded = !err && convert::popValue(luaState, results[i]);
+
+					if (metrics)
+					{
+						recordCall(start, !succeeded);
+					}
+
+					if (succeeded)
+					{
+						++batch.succeeded;
+						continue;
+					}
+
+					++batch.failed;
+
+					if (policy != BatchErrorPolicy::SKIP)
+					{
+						std::string message;
+						if (err)
+						{
+							size_t len;
+							const char* str = lua_tolstring(luaState, -1, &len);
+							message = str ? std::string(str, len) : "Error object is not a string!";
+						}
+						else
+						{
+							message = "Failed to convert return value!";
+						}
+
+						if (policy == BatchErrorPolicy::ABORT)
+						{
+							throw LuaException(message);
+						}
+
+						BatchError error;
+						error.index = i;
+						error.message = message;
+						batch.errors.push_back(error);
+					}
+
+					// Remove the error message or the value which could not be converted
+					lua_settop(luaState, func_idx);
+				}
+			}
+			catch (...)
+			{
+				lua_settop(luaState, stackTop);
+				throw;
+			}
+
+			lua_settop(luaState, stackTop);
+
+			return batch;
+		}
 	private:
+		/**
+		 * @brief Pushes the error function or the traceback handler if one is set.
+		 * @return int The stack index of the error function or 0 if there is none
+		 */
+		int pushErrorFunction();
+
+		/**
+		 * @brief Records a call which started at the given time in the metrics.
+		 */
+		void recordCall(std::chrono::steady_clock::time_point start, bool failed);
+
 		bool isCFunction; //!< @c true to indicate that this is a C-function, mainly used for checking the values
 
 		LuaReferencePtr errorFunction;
+		bool useTraceback; //!< @c true if util::traceback is used when no error function is set
+		bool tracebackSet; //!< @c true if useTraceback was set explicitly and the default does not apply
+
+		FunctionMetricsPtr metrics; //!< Records the calls, @c nullptr if the function is not instrumented
 	};
 }
 
@@ -0,0 +1,95 @@
+#ifndef LUA_JSON_H
+#define LUA_JSON_H
+#pragma once
+
+#include <string>
+
+#include "LuaCpp/LuaHeaders.hpp"
+#include "LuaCpp/LuaException.hpp"
+#include "LuaCpp/LuaValue.hpp"
+
+namespace luacpp
+{
+	/**
+	 * @brief Contains functions to convert between JSON text and lua values.
+	 *
+	 * The conversion works directly on the lua stack. Parsing builds the tables while the text is read and
+	 * writing walks the tables and appends to a string, there is no intermediate document and no references are
+	 * created for nested values.
+	 *
+	 * JSON arrays become tables with the elements at the indices starting with 1 and objects become tables with
+	 * string keys. @c null becomes nil, so a @c null in an array leaves a hole and a @c null value in an object
+	 * is skipped.
+	 */
+	namespace json
+	{
+		/**
+		 * @brief Specifies which tables are written as JSON arrays.
+		 */
+		enum class ArrayDetection
+		{
+			SEQUENCE, //!< Tables whose keys are exactly the numbers 1 to n are arrays
+			LENGTH //!< Tables with a length greater than zero are arrays, other keys are ignored
+		};
+
+		/**
+		 * @brief Options for reading and writing JSON.
+		 */
+		struct Options
+		{
+			ArrayDetection arrayDetection; //!< The rule for writing tables as arrays
+			bool emptyTableAsArray; //!< @c true to write empty tables as @c [] instead of @c {}
+			size_t maxDepth; //!< The maximum nesting depth of arrays and objects
+
+			Options() : arrayDetection(ArrayDetection::SEQUENCE), emptyTableAsArray(false), maxDepth(128) {}
+		};
+
+		/**
+		 * @brief Converts the value at the given stack position to JSON.
+		 *
+		 * Number keys of objects are written as strings. Metatables are ignored.
+		 *
+		 * @param L The lua state
+		 * @param index The stack position of the value
+		 * @param output The string to which the text is appended
+		 * @param options The options
+		 *
+		 * @exception LuaException Thrown when the value contains something which can not be represented in JSON,
+		 * 	e.g. a function, a table key which is no string or number, infinite numbers or when the depth limit
+		 * 	is exceeded. Cyclic tables exceed the depth limit.
+		 */
+		void encode(lua_State* L, int index, std::string& output, const Options& options = Options());
+
+		/**
+		 * @brief Converts a value to JSON. See encode(lua_State*, int, std::string&, const Options&).
+		 *
+		 * @return std::string The JSON text
+		 */
+		std::string encode(const LuaValue& value, const Options& options = Options());
+
+		/**
+		 * @brief Parses JSON text and pushes the value onto the stack.
+		 *
+		 * Arrays and objects with up to a few dozen elements are created with their exact size, larger ones
+		 * grow while they are filled.
+		 *
+		 * @param L The lua state
+		 * @param text The JSON text
+		 * @param length The length of the text
+		 * @param options The options
+		 *
+		 * @exception LuaException Thrown when the text is not valid JSON or exceeds the depth limit. Nothing is
+		 * 	pushed in that case.
+		 */
+		void push(lua_State* L, const char* text, size_t length, const Options& options = Options());
+
+		/**
+		 * @brief Parses JSON text. See push().
+		 *
+		 * @return luacpp::LuaValue The value
+		 */
+		LuaValue decode(lua_State* L, const std::string& text, const Options& options = Options());
+	}
+}
+
+#endif // LUA_JSON_H
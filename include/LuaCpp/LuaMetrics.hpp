@@ -0,0 +1,190 @@
+#ifndef LUA_METRICS_H
+#define LUA_METRICS_H
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "LuaCpp/LuaHeaders.hpp"
+
+#include <boost/smart_ptr.hpp>
+
+namespace luacpp
+{
+	/**
+	 * @brief A lock-free histogram of latencies.
+	 *
+	 * Values are sorted into logarithmic buckets with four sub-buckets per power of two so percentiles
+	 * have a relative error of at most 25%. Recording only uses relaxed atomic increments so it can be
+	 * done concurrently with reading the histogram from another thread.
+	 */
+	class LatencyHistogram
+	{
+	public:
+		static const size_t NUM_BUCKETS = 252;
+
+		LatencyHistogram();
+
+		/**
+		 * @brief Adds a value to the histogram.
+		 * @param nanoseconds The latency
+		 */
+		void record(uint64_t nanoseconds);
+
+		/**
+		 * @brief Gets the total number of recorded values.
+		 */
+		uint64_t getCount() const;
+
+		/**
+		 * @brief Gets a percentile of the recorded values.
+		 *
+		 * @param percentile The percentile between 0 and 1, e.g. 0.99
+		 * @return uint64_t The upper bound of the bucket containing the percentile, 0 if the histogram is empty
+		 */
+		uint64_t getPercentile(double percentile) const;
+
+		/**
+		 * @brief Removes all values.
+		 */
+		void reset();
+
+	private:
+		LatencyHistogram(const LatencyHistogram&);
+		LatencyHistogram& operator=(const LatencyHistogram&);
+
+		static size_t getBucket(uint64_t value);
+
+		static uint64_t getUpperBound(size_t bucket);
+
+		std::atomic<uint64_t> buckets[NUM_BUCKETS];
+	};
+
+	/**
+	 * @brief The values of a FunctionMetrics object at one point in time.
+	 */
+	struct MetricsSnapshot
+	{
+		std::string name; //!< The name of the metrics
+		uint64_t calls; //!< The number of calls
+		uint64_t errors; //!< The number of calls which failed
+		uint64_t p50; //!< The median latency in nanoseconds
+		uint64_t p99; //!< The 99th percentile of the latency in nanoseconds
+		uint64_t p999; //!< The 99.9th percentile of the latency in nanoseconds
+	};
+
+	/**
+	 * @brief Call metrics of one or more lua functions.
+	 */
+	class FunctionMetrics
+	{
+	public:
+		explicit FunctionMetrics(const std::string& name);
+
+		/**
+		 * @brief Gets the name of the metrics.
+		 */
+		const std::string& getName() const { return name; }
+
+		/**
+		 * @brief Records a call.
+		 *
+		 * @param nanoseconds The duration of the call
+		 * @param failed @c true if the call failed
+		 */
+		void record(uint64_t nanoseconds, bool failed);
+
+		/**
+		 * @brief Gets the current values.
+		 */
+		MetricsSnapshot snapshot() const;
+
+		/**
+		 * @brief Sets all values to zero.
+		 */
+		void reset();
+
+	private:
+		std::string name;
+
+		std::atomic<uint64_t> calls;
+		std::atomic<uint64_t> errors;
+		LatencyHistogram latency;
+	};
+
+	typedef boost::shared_ptr<FunctionMetrics> FunctionMetricsPtr;
+
+	/**
+	 * @brief Keeps the metrics of all instrumented functions of a lua state.
+	 *
+	 * There is one registry per state which is destroyed when the state is closed. Metrics are identified
+	 * by name so functions created from the same chunk can share them. Use LuaFunction::setMetrics() to
+	 * instrument a single function or enableChunkInstrumentation() to instrument every function created
+	 * with LuaFunction::createFromCode() using the chunk name.
+	 */
+	class MetricsRegistry
+	{
+	public:
+		/**
+		 * @brief Gets the registry of a state, it is created if it does not exist yet.
+		 *
+		 * @param L The lua state
+		 * @return luacpp::MetricsRegistry& The registry
+		 */
+		static MetricsRegistry& forState(lua_State* L);
+
+		/**
+		 * @brief Gets the registry of a state if it exists.
+		 *
+		 * @param L The lua state
+		 * @return luacpp::MetricsRegistry* The registry or @c nullptr
+		 */
+		static MetricsRegistry* find(lua_State* L);
+
+		/**
+		 * @brief Gets the metrics with the given name, they are created if they do not exist yet.
+		 *
+		 * @param name The name
+		 * @return luacpp::FunctionMetricsPtr The metrics
+		 */
+		FunctionMetricsPtr get(const std::string& name);
+
+		/**
+		 * @brief Specifies if functions created from code with a chunk name are instrumented automatically.
+		 */
+		void enableChunkInstrumentation(bool enable) { instrumentChunks = enable; }
+
+		/**
+		 * @brief Checks if functions created from code are instrumented automatically.
+		 */
+		bool isChunkInstrumentationEnabled() const { return instrumentChunks; }
+
+		/**
+		 * @brief Gets the current values of all metrics, sorted by name.
+		 *
+		 * @param reset @c true to reset the metrics after reading them
+		 * @return std::vector<MetricsSnapshot> The values
+		 */
+		std::vector<MetricsSnapshot> snapshot(bool reset = false);
+
+		/**
+		 * @brief Resets all metrics.
+		 */
+		void reset();
+
+	private:
+		MetricsRegistry();
+
+		static int collect(lua_State* L);
+
+		std::mutex mutex;
+		std::map<std::string, FunctionMetricsPtr> metrics;
+		bool instrumentChunks;
+	};
+}
+
+#endif // LUA_METRICS_H
@@ -0,0 +1,165 @@
+#ifndef LUA_MSGPACK_H
+#define LUA_MSGPACK_H
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "LuaCpp/LuaHeaders.hpp"
+#include "LuaCpp/LuaException.hpp"
+#include "LuaCpp/LuaValue.hpp"
+#include "LuaCpp/LuaSerialize.hpp"
+
+namespace luacpp
+{
+	/**
+	 * @brief Contains functions to convert lua values to and from MessagePack.
+	 *
+	 * Numbers without a fractional part are written with the smallest integer format, other numbers as 64 bit
+	 * floats. Integers are read exactly as long as the lua number type can represent them, which are all integers
+	 * up to 2^53 for the default @c double. Tables whose keys are exactly the numbers 1 to n are written as arrays,
+	 * all other tables as maps. Both @c str and @c bin values are read as lua strings, extension types are not
+	 * supported.
+	 *
+	 * The writer uses the sinks of the serialize namespace, see serialize::Sink.
+	 */
+	namespace msgpack
+	{
+		/**
+		 * @brief Specifies how lua strings are written.
+		 */
+		enum class StringEncoding
+		{
+			STR, //!< Always use the @c str format
+			BIN, //!< Always use the @c bin format
+			DETECT //!< Use @c str for valid UTF-8 and @c bin for other strings
+		};
+
+		/**
+		 * @brief Options for reading and writing MessagePack.
+		 */
+		struct Options
+		{
+			StringEncoding strings; //!< The format of strings
+			bool emptyTableAsArray; //!< @c true to write empty tables as arrays instead of maps
+			size_t maxDepth; //!< The maximum nesting depth of arrays and maps
+			size_t maxSize; //!< The maximum number of bytes of a value
+
+			Options() : strings(StringEncoding::DETECT), emptyTableAsArray(false), maxDepth(128),
+				maxSize(64 * 1024 * 1024)
+			{
+			}
+		};
+
+		/**
+		 * @brief Writes the value at the given stack position.
+		 *
+		 * Small values are collected in a buffer, long strings are passed to the sink directly from lua's memory
+		 * without copying them.
+		 *
+		 * @param L The lua state
+		 * @param index The stack position of the value
+		 * @param sink Receives the output
+		 * @param options The options
+		 *
+		 * @exception LuaException Thrown when the value contains a function, userdata or thread or when a limit
+		 * 	is exceeded. Cyclic tables exceed the depth limit.
+		 */
+		void encode(lua_State* L, int index, serialize::Sink& sink, const Options& options = Options());
+
+		/**
+		 * @brief Writes a value into a string. See encode(lua_State*, int, serialize::Sink&, const Options&).
+		 *
+		 * @return std::string The MessagePack data
+		 */
+		std::string encode(const LuaValue& value, const Options& options = Options());
+
+		/**
+		 * @brief Reads one value and pushes it onto the stack.
+		 *
+		 * @param L The lua state
+		 * @param data The MessagePack data, it must contain exactly one value
+		 * @param length The number of bytes
+		 * @param options The options
+		 *
+		 * @exception LuaException Thrown when the data is invalid or exceeds a limit. Nothing is pushed in that case.
+		 */
+		void push(lua_State* L, const char* data, size_t length, const Options& options = Options());
+
+		/**
+		 * @brief Reads one value. See push().
+		 *
+		 * @return luacpp::LuaValue The value
+		 */
+		LuaValue decode(lua_State* L, const std::string& data, const Options& options = Options());
+
+		/**
+		 * @brief Reads a stream of values which arrives in arbitrary pieces.
+		 *
+		 * The data is appended with feed(), next() pushes the next value as soon as it is complete. The decoder
+		 * remembers how far it has checked the data, so a large value which arrives in many small pieces is only
+		 * scanned once before it is converted.
+		 *
+		 * @code
+		 * msgpack::StreamDecoder decoder;
+		 *
+		 * while (receive(buffer, &length))
+		 * {
+		 * 	decoder.feed(buffer, length);
+		 *
+		 * 	while (decoder.next(L))
+		 * 	{
+		 * 		handleMessage(L);
+		 * 		lua_pop(L, 1);
+		 * 	}
+		 * }
+		 * @endcode
+		 *
+		 * After an exception the decoder is in an undefined state and has to be reset.
+		 */
+		class StreamDecoder
+		{
+		public:
+			explicit StreamDecoder(const Options& options = Options());
+
+			/**
+			 * @brief Appends data to the stream.
+			 *
+			 * @param data The bytes
+			 * @param length The number of bytes
+			 */
+			void feed(const char* data, size_t length);
+
+			/**
+			 * @brief Pushes the next value if it is complete.
+			 *
+			 * @param L The lua state
+			 * @return bool @c true if a value was pushed, @c false if more data is needed
+			 *
+			 * @exception LuaException Thrown when the data is invalid or a value exceeds a limit
+			 */
+			bool next(lua_State* L);
+
+			/**
+			 * @brief Gets the number of bytes which were fed but do not belong to a value returned by next() yet.
+			 */
+			size_t getBufferedSize() const { return buffer.size() - readPosition; }
+
+			/**
+			 * @brief Discards all buffered data.
+			 */
+			void reset();
+
+		private:
+			Options options;
+
+			std::string buffer;
+			size_t readPosition; //!< The start of the next value
+			size_t scanPosition; //!< The data before this position was checked
+			std::vector<uint64_t> remaining; //!< The number of elements which are missing on every level
+		};
+	}
+}
+
+#endif // LUA_MSGPACK_H
@@ -0,0 +1,191 @@
+#ifndef LUA_PATH_H
+#define LUA_PATH_H
+#pragma once
+
+#include <string>
+
+#include "LuaCpp/LuaHeaders.hpp"
+#include "LuaCpp/LuaException.hpp"
+#include "LuaCpp/LuaConvert.hpp"
+#include "LuaCpp/LuaTable.hpp"
+
+namespace luacpp
+{
+	/**
+	 * @brief A precompiled path of keys into nested tables, e.g. @c settings.render.shadows.quality
+	 *
+	 * The path is parsed once when it is created. The keys are stored as lua values in a table which is
+	 * referenced by the path, so a lookup only copies the already interned keys onto the stack instead of
+	 * creating the strings again. The lookup walks the tables on the stack and does not create any references.
+	 *
+	 * Segments which only consist of digits are used as number keys, e.g. @c items.1.name. Leading zeros
+	 * are ignored, so @c items.01 and @c items.1 refer to the same key.
+	 *
+	 * The lookup uses @c lua_gettable and @c lua_settable so the metamethods of the tables are used.
+	 */
+	class LuaPath
+	{
+	public:
+		/**
+		 * @brief Parses a path.
+		 *
+		 * @param L The lua state
+		 * @param path The keys separated by dots
+		 * @return luacpp::LuaPath The path
+		 *
+		 * @exception LuaException Thrown when the path or one of its segments is empty or when a number key is
+		 * 	larger than 2^53 and can not be represented exactly
+		 */
+		static LuaPath create(lua_State* L, const std::string& path);
+
+		/**
+		 * @brief Pushes the value at the end of the path.
+		 *
+		 * @param root The stack index of the table where the path starts, may be a pseudo-index like
+		 * 	@c LUA_GLOBALSINDEX
+		 * @return bool @c true if every value on the way is a table, @c false if not. In that case nil is pushed.
+		 */
+		bool pushValue(int root) const;
+
+		/**
+		 * @brief Pushes the value at the end of the path. See pushValue(int).
+		 *
+		 * @param root The table where the path starts
+		 */
+		bool pushValue(const LuaTable& root) const;
+
+		/**
+		 * @brief Gets the value at the end of the path.
+		 *
+		 * @param root The table where the path starts, either a LuaTable or a stack index
+		 * @param target The target location where the value should be stored
+		 * @return @c true when the value exists and could be converted, @c false otherwise
+		 */
+		template<class RootType, class ValueType>
+		bool getValue(const RootType& root, ValueType& target) const
+		{
+			if (!pushValue(root))
+			{
+				lua_pop(luaState, 1);
+				return false;
+			}
+
+			bool ret = convert::popValue(luaState, target);
+
+			if (!ret)
+			{
+				lua_pop(luaState, 1);
+			}
+
+			return ret;
+		}
+
+		/**
+		 * @brief Gets the value at the end of the path or throws an exception.
+		 *
+		 * @exception LuaException Thrown when the value does not exist or could not be converted
+		 */
+		template<class ValueType, class RootType>
+		ValueType getValue(const RootType& root) const
+		{
+			ValueType target;
+
+			if (!getValue(root, target))
+			{
+				throw LuaException("Failed to get lua value at " + path + "!");
+			}
+
+			return target;
+		}
+
+		/**
+		 * @brief Sets the value at the end of the path.
+		 * Missing tables on the way are created.
+		 *
+		 * @param root The stack index of the table where the path starts
+		 * @param value The new value
+		 *
+		 * @exception LuaException Thrown when a value on the way exists but is no table
+		 */
+		template<class ValueType>
+		void setValue(int root, const ValueType& value) const
+		{
+			int top = lua_gettop(luaState);
+
+			try
+			{
+				pushParent(root);
+
+				lua_rawgeti(luaState, top + 1, static_cast<int>(length));
+				convert::pushValue(luaState, value);
+
+				lua_settable(luaState, -3);
+			}
+			catch (...)
+			{
+				lua_settop(luaState, top);
+				throw;
+			}
+
+			lua_settop(luaState, top);
+		}
+
+		/**
+		 * @brief Sets the value at the end of the path. See setValue(int, const ValueType&).
+		 *
+		 * @param root The table where the path starts
+		 */
+		template<class ValueType>
+		void setValue(const LuaTable& root, const ValueType& value) const
+		{
+			if (!root.pushValue())
+			{
+				throw LuaException("Table reference is not valid!");
+			}
+
+			int rootIndex = lua_gettop(luaState);
+
+			try
+			{
+				setValue(rootIndex, value);
+			}
+			catch (...)
+			{
+				lua_pop(luaState, 1);
+				throw;
+			}
+
+			lua_pop(luaState, 1);
+		}
+
+		/**
+		 * @brief Gets the path as it was given to create().
+		 */
+		const std::string& getPath() const { return path; }
+
+		/**
+		 * @brief Gets the number of keys.
+		 */
+		size_t getLength() const { return length; }
+
+	private:
+		LuaPath();
+
+		/**
+		 * @brief Converts a relative stack index to an absolute one, pseudo-indices are unchanged
+		 */
+		int toAbsolute(int index) const;
+
+		/**
+		 * @brief Pushes the key table and the table which contains the last key, missing tables are created
+		 */
+		void pushParent(int root) const;
+
+		lua_State* luaState;
+		LuaTable keys; //!< The keys as lua values at the indices 1 to length
+		size_t length;
+		std::string path;
+	};
+}
+
+#endif // LUA_PATH_H
@@ -0,0 +1,152 @@
+#ifndef LUA_PROFILER_H
+#define LUA_PROFILER_H
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "LuaCpp/LuaHeaders.hpp"
+
+namespace luacpp
+{
+	/**
+	 * @brief A sampling profiler for lua code.
+	 *
+	 * While the profiler is running it installs a count hook which samples the call stack every
+	 * @c interval instructions. Frames are identified by their function and interned into numeric ids, functions
+	 * with the same name share an id. The samples are aggregated per distinct stack. When the profiler is not running no hook is installed.
+	 *
+	 * The memory usage is bounded by the maximum stack depth and the maximum number of distinct stacks,
+	 * samples of new stacks beyond that limit are only counted as dropped. The number of distinct frames is
+	 * limited to the maximum number of stacks as well, further frames are reported as @c (other).
+	 *
+	 * The results can be written as folded stacks which can be used by flamegraph tools.
+	 */
+	class LuaProfiler
+	{
+	public:
+		/**
+		 * @brief Runs the profiler while it exists, e.g. for profiling a single LuaFunction::call.
+		 */
+		class Scope
+		{
+		public:
+			Scope(LuaProfiler& profiler, lua_State* L, int interval = 1000) : profiler(profiler)
+			{
+				profiler.start(L, interval);
+			}
+
+			~Scope()
+			{
+				profiler.stop();
+			}
+
+		private:
+			Scope(const Scope&);
+			Scope& operator=(const Scope&);
+
+			LuaProfiler& profiler;
+		};
+
+		/**
+		 * @brief Initializes the profiler.
+		 *
+		 * @param maxStacks The maximum number of distinct stacks which are recorded
+		 * @param maxDepth The maximum number of frames of a stack, deeper frames are cut off
+		 */
+		LuaProfiler(size_t maxStacks = 10000, int maxDepth = 64);
+
+		/**
+		 * @brief Stops the profiler if it is running.
+		 */
+		~LuaProfiler();
+
+		/**
+		 * @brief Starts sampling the given state.
+		 * Coroutines created while the profiler is running are sampled as well.
+		 *
+		 * @param L The lua state
+		 * @param interval The number of instructions between two samples
+		 *
+		 * @exception LuaException Thrown if the profiler is already running or the interval is not positive.
+		 */
+		void start(lua_State* L, int interval = 1000);
+
+		/**
+		 * @brief Stops sampling and restores the previous hook of the state.
+		 */
+		void stop();
+
+		/**
+		 * @brief Checks if the profiler is running.
+		 */
+		bool isRunning() const { return luaState != nullptr; }
+
+		/**
+		 * @brief Gets the number of recorded samples.
+		 */
+		uint64_t getSampleCount() const { return samples; }
+
+		/**
+		 * @brief Gets the number of samples which were dropped because the stack limit was reached.
+		 */
+		uint64_t getDroppedCount() const { return dropped; }
+
+		/**
+		 * @brief Writes the samples as folded stacks.
+		 * Every line contains the frames from the outermost to the innermost call separated by @c ; followed
+		 * by the number of samples.
+		 *
+		 * @param out The stream to write to
+		 */
+		void writeFolded(std::ostream& out) const;
+
+		/**
+		 * @brief Removes all samples and frames.
+		 */
+		void clear();
+
+	private:
+		LuaProfiler(const LuaProfiler&);
+		LuaProfiler& operator=(const LuaProfiler&);
+
+		struct StackHash
+		{
+			size_t operator()(const std::vector<uint32_t>& stack) const;
+		};
+
+		static void hook(lua_State* L, lua_Debug* ar);
+
+		void sample(lua_State* L);
+
+		uint32_t internFrame(lua_State* L, lua_Debug* ar);
+
+		size_t maxStacks;
+		int maxDepth;
+
+		lua_State* luaState;
+		int interval;
+		int pending;
+
+		lua_Hook previousHook;
+		int previousMask;
+		int previousCount;
+
+		int functionsRef; //!< A table which keeps the sampled functions alive while the profiler is running
+		std::unordered_map<const void*, uint32_t> frameIds; //!< Frame ids by function object of the current run
+		uint32_t otherFrame; //!< Used for all frames once the frame limit is reached
+		std::vector<std::string> frameNames;
+		std::unordered_map<std::string, uint32_t> nameIds; //!< Frame ids by name, kept across runs
+
+		std::vector<uint32_t> currentStack; //!< Reused for every sample, innermost frame first
+		std::unordered_map<std::vector<uint32_t>, uint64_t, StackHash> stacks;
+
+		uint64_t samples;
+		uint64_t dropped;
+	};
+}
+
+#endif // LUA_PROFILER_H
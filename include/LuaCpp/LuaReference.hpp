@@ -19,7 +19,8 @@ namespace luacpp
 	* @brief A lua-value reference.
 	*
 	* Wraps a reference to a lua-value and provides a way to handle multiple users of that reference and
-	* automatic reference freeing.
+	* automatic reference freeing. @c nil can not be stored in the registry, it is represented by
+	* @c LUA_REFNIL which is valid but does not occupy a registry slot.
 	*/
 	class LuaReference
 	{
@@ -30,7 +31,7 @@ namespace luacpp
 		* Sets the lua_State which will be used to hold the reference and the actual reference value.
 		*
 		* @param state The lua_State where the reference points to a value.
-		* @param reference The reference value, should be >= 0.
+		* @param reference The reference value, should be >= 0 or @c LUA_REFNIL.
 		*/
 		LuaReference(lua_State* state, int reference);
 
@@ -63,7 +64,7 @@ namespace luacpp
 		* @brief Default constructor, initializes an invalid reference
 		*/
 		LuaReference() :
-			luaState(nullptr), mReference(-1)
+			luaState(nullptr), mReference(LUA_NOREF)
 		{
 		}
 
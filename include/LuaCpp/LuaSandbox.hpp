@@ -0,0 +1,123 @@
+#ifndef LUA_SANDBOX_H
+#define LUA_SANDBOX_H
+#pragma once
+
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+
+#include "LuaCpp/LuaHeaders.hpp"
+#include "LuaCpp/LuaTable.hpp"
+#include "LuaCpp/LuaFunction.hpp"
+
+namespace luacpp
+{
+	/**
+	 * @brief Provides isolated environments for scripts of different tenants.
+	 *
+	 * All environments share one base environment which contains the whitelisted globals. It is built once
+	 * when the sandbox is created. Tables like @c string are only reachable through read-only proxies so scripts
+	 * can not modify them. The environment of a tenant is an empty table with a shared metatable whose
+	 * @c __index points to the base, so creating it does not copy anything. Globals assigned by a script
+	 * are stored in the environment of its tenant.
+	 *
+	 * The environments are cached by tenant ID. When more than the maximum number of tenants exist the
+	 * least recently used environment is released.
+	 *
+	 * The proxies are userdata because all tenants share them and functions like @c rawset or @c table.insert
+	 * ignore the metatable of a table. So @c type returns @c userdata for them and they can not be iterated
+	 * with @c pairs.
+	 */
+	class LuaSandbox
+	{
+	public:
+		/**
+		 * @brief Gets a whitelist of globals which are safe for untrusted code.
+		 * It contains the basic functions which can not load code or access the environment of other functions,
+		 * the @c string, @c table, @c math and @c coroutine libraries and the time functions of @c os.
+		 */
+		static const std::vector<std::string>& getDefaultWhitelist();
+
+		/**
+		 * @brief Builds the base environment.
+		 *
+		 * @param L The lua state
+		 * @param whitelist The names of the globals which are available to scripts. A name may contain
+		 * 	one dot to only allow a single field of a table, e.g. @c os.time. Names which do not exist are ignored.
+		 * @param maxTenants The maximum number of cached environments
+		 */
+		LuaSandbox(lua_State* L, const std::vector<std::string>& whitelist = getDefaultWhitelist(),
+			size_t maxTenants = 64);
+
+		/**
+		 * @brief Gets the environment of a tenant, it is created if it does not exist.
+		 *
+		 * @param tenantId The tenant
+		 * @return luacpp::LuaTable The environment
+		 */
+		LuaTable getEnvironment(const std::string& tenantId);
+
+		/**
+		 * @brief Compiles code and sets the environment of the tenant as its environment.
+		 *
+		 * @param tenantId The tenant
+		 * @param code The code
+		 * @param name The chunk name
+		 * @return luacpp::LuaFunction The compiled function
+		 *
+		 * @exception LuaException Thrown when the compilation fails.
+		 */
+		LuaFunction load(const std::string& tenantId, const std::string& code, const std::string& name = "");
+
+		/**
+		 * @brief Replaces the environment of a tenant with an empty one.
+		 * Functions which already use the old environment keep it.
+		 *
+		 * @param tenantId The tenant
+		 * @return bool @c true if the tenant had an environment
+		 */
+		bool reset(const std::string& tenantId);
+
+		/**
+		 * @brief Removes the environment of a tenant from the cache.
+		 *
+		 * @param tenantId The tenant
+		 * @return bool @c true if the tenant had an environment
+		 */
+		bool evict(const std::string& tenantId);
+
+		/**
+		 * @brief Gets the number of cached environments.
+		 */
+		size_t getTenantCount() const { return tenants.size(); }
+
+		/**
+		 * @brief Gets the shared base environment.
+		 */
+		const LuaTable& getBase() const { return base; }
+
+	private:
+		LuaSandbox(const LuaSandbox&);
+		LuaSandbox& operator=(const LuaSandbox&);
+
+		struct Tenant
+		{
+			LuaTable environment;
+			std::list<std::string>::iterator position; //!< The position in the usage list
+		};
+
+		LuaTable createEnvironment();
+
+		lua_State* luaState;
+		size_t maxTenants;
+
+		LuaTable base;
+		LuaTable environmentMetatable; //!< Shared by all environments
+
+		std::unordered_map<std::string, Tenant> tenants;
+		std::list<std::string> usage; //!< The tenant IDs, most recently used first
+	};
+}
+
+#endif // LUA_SANDBOX_H
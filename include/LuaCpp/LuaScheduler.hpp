@@ -0,0 +1,203 @@
+#ifndef LUASCHEDULER_H
+#define LUASCHEDULER_H
+#pragma once
+
+#include <cstdint>
+#include <chrono>
+#include <deque>
+#include <queue>
+#include <vector>
+#include <functional>
+
+#include "LuaCpp/LuaHeaders.hpp"
+#include "LuaCpp/LuaFunction.hpp"
+#include "LuaCpp/LuaTable.hpp"
+
+namespace luacpp
+{
+	/**
+	 * @brief Runs many lua coroutines cooperatively on one lua_State.
+	 *
+	 * Scripts are started with spawn() and run until they finish or suspend themselves. A script can
+	 * suspend by calling the @c sleep or @c yield functions installed by registerFunctions() or by calling
+	 * a C function which uses suspend() to wait for a result produced by C++ code, e.g. a pending I/O request.
+	 * The C++ side calls resolve() when the result is available.
+	 *
+	 * Resumable scripts are kept in a ready queue which is processed in batches by runOnce(). All coroutines
+	 * are anchored in a single table so spawning or finishing a script does not create or remove registry
+	 * references. The stack of a script which finished without an error is reused by the next spawn().
+	 */
+	class LuaScheduler
+	{
+	public:
+		typedef std::chrono::steady_clock Clock;
+
+		/**
+		 * @brief Identifies a task. The value 0 is never used for a valid task.
+		 */
+		typedef uint64_t TaskId;
+
+		/**
+		 * @brief Called when a task fails with the task and the error message.
+		 */
+		typedef std::function<void(TaskId, const std::string&)> ErrorHandler;
+
+		/**
+		 * @brief Statistics about the scheduler.
+		 */
+		struct Stats
+		{
+			size_t resumes; //!< The number of resumes since the last reset
+			uint64_t totalLatency; //!< Sum of the time the resumed tasks waited in the ready queue in nanoseconds
+			uint64_t maxLatency; //!< The longest time a task waited in the ready queue in nanoseconds
+
+			Stats() : resumes(0), totalLatency(0), maxLatency(0) {}
+		};
+
+		/**
+		 * @brief Initializes the scheduler.
+		 *
+		 * @param L The lua state in which the tasks are executed
+		 */
+		explicit LuaScheduler(lua_State* L);
+
+		/**
+		 * @brief Starts a new task.
+		 * The task is put into the ready queue, it does not run before the next call to runOnce().
+		 *
+		 * @param function The function which is executed by the task
+		 * @param arguments The arguments passed to the function
+		 * @return luacpp::LuaScheduler::TaskId The id of the new task
+		 */
+		TaskId spawn(const LuaFunction& function, const LuaValueList& arguments = LuaValueList());
+
+		/**
+		 * @brief Adds @c sleep(seconds) and @c yield() functions to the given table.
+		 * The functions can only be used by tasks of this scheduler.
+		 *
+		 * @param table The table, e.g. the global table or a module table
+		 */
+		void registerFunctions(LuaTable& table);
+
+		/**
+		 * @brief Suspends the task running on @c L until resolve() is called.
+		 * This has to be called from a C function which is executed by a task of this scheduler. That function
+		 * must then return the result of <tt>lua_yield(L, 0)</tt>.
+		 *
+		 * @param L The state of the running task
+		 * @return luacpp::LuaScheduler::TaskId The handle which has to be passed to resolve(), 0 if @c L is not
+		 * 	a task of this scheduler.
+		 */
+		TaskId suspend(lua_State* L);
+
+		/**
+		 * @brief Makes a task which waits in suspend() ready again.
+		 *
+		 * @param handle The handle returned by suspend()
+		 * @param values The values which will be returned to the script by the call that suspended it
+		 * @return bool @c true if the task was waiting, @c false if the handle is not valid anymore
+		 */
+		bool resolve(TaskId handle, const LuaValueList& values = LuaValueList());
+
+		/**
+		 * @brief Moves expired timers into the ready queue and resumes ready tasks.
+		 *
+		 * @param maxResumes The maximum number of tasks which are resumed
+		 * @return size_t The number of tasks which were resumed
+		 */
+		size_t runOnce(size_t maxResumes = static_cast<size_t>(-1));
+
+		/**
+		 * @brief Gets the point in time when the next timer expires.
+		 *
+		 * @param deadline Receives the time if there is a timer
+		 * @return bool @c true if there is a pending timer
+		 */
+		bool getNextDeadline(Clock::time_point& deadline) const;
+
+		/**
+		 * @brief Sets the function which is called when a task fails.
+		 */
+		void setErrorHandler(const ErrorHandler& handler) { errorHandler = handler; }
+
+		/**
+		 * @brief Gets the number of tasks in the ready queue.
+		 */
+		size_t getQueueDepth() const { return readyQueue.size(); }
+
+		/**
+		 * @brief Gets the number of tasks which are not finished yet.
+		 */
+		size_t getTaskCount() const { return activeTasks; }
+
+		/**
+		 * @brief Gets the statistics collected since the last resetStats().
+		 */
+		const Stats& getStats() const { return stats; }
+
+		/**
+		 * @brief Resets the statistics.
+		 */
+		void resetStats() { stats = Stats(); }
+
+	private:
+		enum class TaskState
+		{
+			FREE,
+			READY,
+			SLEEPING,
+			WAITING
+		};
+
+		struct Task
+		{
+			lua_State* thread;
+			uint32_t generation;
+			TaskState state;
+			int numArgs;
+			Clock::time_point readyTime;
+		};
+
+		struct Timer
+		{
+			Clock::time_point deadline;
+			TaskId id;
+
+			bool operator>(const Timer& other) const { return deadline > other.deadline; }
+		};
+
+		static int sleepFunction(lua_State* L);
+		static int yieldFunction(lua_State* L);
+
+		static TaskId makeId(uint32_t slot, uint32_t generation)
+		{
+			return (static_cast<TaskId>(generation) << 32) | slot;
+		}
+
+		Task* getTask(TaskId id);
+
+		uint32_t getCurrentSlot(lua_State* L) const;
+
+		void makeReady(uint32_t slot, Clock::time_point now);
+
+		void resumeTask(uint32_t slot);
+
+		void freeTask(uint32_t slot, bool reuseThread);
+
+		lua_State* luaState;
+		LuaTable threads; //!< Anchors the coroutines, the thread of slot n is stored at n + 1
+
+		std::vector<Task> tasks;
+		std::vector<uint32_t> freeSlots;
+		size_t activeTasks;
+		uint32_t currentSlot;
+
+		std::deque<TaskId> readyQueue;
+		std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+
+		ErrorHandler errorHandler;
+		Stats stats;
+	};
+}
+
+#endif
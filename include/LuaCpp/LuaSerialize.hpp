@@ -0,0 +1,124 @@
+#ifndef LUA_SERIALIZE_H
+#define LUA_SERIALIZE_H
+#pragma once
+
+#include <string>
+
+#include "LuaCpp/LuaHeaders.hpp"
+#include "LuaCpp/LuaException.hpp"
+#include "LuaCpp/LuaValue.hpp"
+
+namespace luacpp
+{
+	/**
+	 * @brief Contains functions to convert lua values to and from a compact binary format.
+	 *
+	 * The format supports nil, booleans, numbers, strings and tables. Integral numbers are stored as variable
+	 * length integers and every string and table is only written once, later occurences refer to the first one.
+	 * This preserves shared tables and cycles. Tables are written with the size of their array and hash parts so
+	 * reading them creates tables with the right size.
+	 *
+	 * Metatables are not serialized and values of other types cause an exception.
+	 */
+	namespace serialize
+	{
+		/**
+		 * @brief Receives the output of a serializer.
+		 */
+		class Sink
+		{
+		public:
+			virtual ~Sink() {}
+
+			/**
+			 * @brief Writes the given bytes.
+			 *
+			 * @param data The bytes
+			 * @param length The number of bytes
+			 */
+			virtual void write(const char* data, size_t length) = 0;
+		};
+
+		/**
+		 * @brief A sink which appends to a string.
+		 */
+		class StringSink : public Sink
+		{
+		public:
+			explicit StringSink(std::string& target) : target(target) {}
+
+			void write(const char* data, size_t length) override
+			{
+				target.append(data, length);
+			}
+
+		private:
+			std::string& target;
+		};
+
+		/**
+		 * @brief Limits for reading and writing serialized data. Set them when the data is not trusted.
+		 */
+		struct Limits
+		{
+			size_t maxDepth; //!< The maximum nesting depth of tables
+			size_t maxSize; //!< The maximum number of bytes
+
+			Limits() : maxDepth(128), maxSize(64 * 1024 * 1024) {}
+
+			Limits(size_t maxDepth, size_t maxSize) : maxDepth(maxDepth), maxSize(maxSize) {}
+		};
+
+		/**
+		 * @brief Serializes the value at the given stack position.
+		 *
+		 * The output is buffered and written to the sink in chunks.
+		 *
+		 * @param L The lua state
+		 * @param index The stack position of the value
+		 * @param sink Receives the output
+		 * @param limits The limits
+		 *
+		 * @exception LuaException Thrown when the value contains a type which can not be serialized or when a
+		 * 	limit is exceeded. The sink may have received a part of the output.
+		 */
+		void write(lua_State* L, int index, Sink& sink, const Limits& limits = Limits());
+
+		/**
+		 * @brief Serializes a value. See write(lua_State*, int, Sink&, const Limits&).
+		 */
+		void write(const LuaValue& value, Sink& sink, const Limits& limits = Limits());
+
+		/**
+		 * @brief Serializes a value into a string.
+		 *
+		 * @param value The value
+		 * @param limits The limits
+		 * @return std::string The serialized data
+		 */
+		std::string toString(const LuaValue& value, const Limits& limits = Limits());
+
+		/**
+		 * @brief Deserializes data and pushes the value onto the stack.
+		 *
+		 * The data is validated while it is read, nothing is pushed if it is invalid.
+		 *
+		 * @param L The lua state
+		 * @param data The serialized data
+		 * @param length The number of bytes
+		 * @param limits The limits
+		 *
+		 * @exception LuaException Thrown when the data is invalid or exceeds a limit
+		 */
+		void push(lua_State* L, const char* data, size_t length, const Limits& limits = Limits());
+
+		/**
+		 * @brief Deserializes data. See push().
+		 *
+		 * @return luacpp::LuaValue The value
+		 */
+		LuaValue read(lua_State* L, const std::string& data, const Limits& limits = Limits());
+	}
+}
+
+#endif // LUA_SERIALIZE_H
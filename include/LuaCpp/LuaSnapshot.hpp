@@ -0,0 +1,277 @@
+#ifndef LUA_SNAPSHOT_H
+#define LUA_SNAPSHOT_H
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "LuaCpp/LuaHeaders.hpp"
+#include "LuaCpp/LuaTable.hpp"
+
+#include <boost/smart_ptr.hpp>
+
+namespace luacpp
+{
+	class LuaSnapshot;
+
+	typedef boost::shared_ptr<const LuaSnapshot> LuaSnapshotPtr;
+
+	namespace detail
+	{
+		enum class SnapshotType : uint8_t
+		{
+			NIL,
+			BOOLEAN,
+			NUMBER,
+			STRING,
+			TABLE
+		};
+
+		struct SnapshotNode
+		{
+			SnapshotType type;
+			union
+			{
+				bool boolean;
+				double number;
+				uint32_t index; //!< The string or table index
+			};
+
+			SnapshotNode() : type(SnapshotType::NIL), number(0.0) {}
+		};
+
+		struct SnapshotString
+		{
+			uint32_t offset; //!< The position of the first character in the character pool
+			uint32_t length;
+			uint32_t hash;
+		};
+
+		struct SnapshotSlot
+		{
+			uint32_t key; //!< The string index of the key, EMPTY_SLOT for unused slots
+			SnapshotNode value;
+		};
+
+		struct SnapshotTable
+		{
+			uint32_t arrayStart; //!< The position of the first array element in the node list
+			uint32_t arrayLength;
+			uint32_t slotStart; //!< The position of the first hash slot
+			uint32_t slotCount; //!< The number of hash slots, zero or a power of two
+			uint32_t fieldCount; //!< The number of used hash slots
+		};
+	}
+
+	/**
+	 * @brief An immutable copy of a lua table which can be read without the lua state.
+	 *
+	 * The snapshot is created once from a table and its nested tables. After that it does not reference the lua
+	 * state anymore and can be read concurrently by any number of threads. Share it with a LuaSnapshotPtr and
+	 * use a LuaSnapshotHolder to replace it while other threads read it.
+	 *
+	 * The data is stored in a few flat arrays: the array part of each table is a range of values, the string
+	 * keys are stored in an open addressing hash table and every string is stored once in a character pool.
+	 *
+	 * Only booleans, numbers, strings and tables are copied. Other values are skipped and so are keys which
+	 * are neither strings nor indices of the array part. A table which is referenced multiple times is only
+	 * copied once, so cycles are preserved.
+	 *
+	 * @code
+	 * LuaSnapshotPtr snapshot = LuaSnapshot::create(config);
+	 * double quality = snapshot->getRoot()["render"].toTable()["quality"].toNumber();
+	 * @endcode
+	 */
+	class LuaSnapshot
+	{
+	public:
+		class Table;
+
+		/**
+		 * @brief A value of the snapshot. This is a small handle which is only valid as long as the snapshot exists.
+		 */
+		class Value
+		{
+		public:
+			bool isNil() const { return node->type == detail::SnapshotType::NIL; }
+			bool isBoolean() const { return node->type == detail::SnapshotType::BOOLEAN; }
+			bool isNumber() const { return node->type == detail::SnapshotType::NUMBER; }
+			bool isString() const { return node->type == detail::SnapshotType::STRING; }
+			bool isTable() const { return node->type == detail::SnapshotType::TABLE; }
+
+			/**
+			 * @brief Gets the boolean value.
+			 * @return bool The value, @c false for other types
+			 */
+			bool toBoolean() const { return isBoolean() && node->boolean; }
+
+			/**
+			 * @brief Gets the number value.
+			 * @param defaultValue The value which is returned for other types
+			 */
+			double toNumber(double defaultValue = 0.0) const { return isNumber() ? node->number : defaultValue; }
+
+			/**
+			 * @brief Gets the string value, the pointer is valid as long as the snapshot exists.
+			 * @param length Receives the length of the string, may be @c nullptr
+			 * @return const char* The null-terminated string, @c nullptr for other types
+			 */
+			const char* toString(size_t* length = nullptr) const;
+
+			/**
+			 * @brief Gets the table.
+			 * @return Table The table, an empty table for other types
+			 */
+			Table toTable() const;
+
+			/**
+			 * @brief Looks up a field if this is a table. See Table::operator[].
+			 */
+			Value operator[](const std::string& key) const { return toTable()[key]; }
+
+		private:
+			Value(const LuaSnapshot* snapshot, const detail::SnapshotNode* node) : snapshot(snapshot), node(node) {}
+
+			const LuaSnapshot* snapshot;
+			const detail::SnapshotNode* node;
+
+			friend class LuaSnapshot;
+		};
+
+		/**
+		 * @brief A table of the snapshot. This is a small handle which is only valid as long as the snapshot exists.
+		 */
+		class Table
+		{
+		public:
+			/**
+			 * @brief Gets the number of elements in the array part.
+			 */
+			size_t getLength() const { return table->arrayLength; }
+
+			/**
+			 * @brief Gets the number of string keys.
+			 */
+			size_t getFieldCount() const { return table->fieldCount; }
+
+			/**
+			 * @brief Gets an element of the array part.
+			 * @param index The index, starting at 1
+			 * @return Value The element, a nil value if the index is outside of the array part
+			 */
+			Value get(size_t index) const;
+
+			/**
+			 * @brief Looks up a string key.
+			 * @param key The key
+			 * @param length The length of the key
+			 * @return Value The value, a nil value if the key does not exist
+			 */
+			Value get(const char* key, size_t length) const;
+
+			Value operator[](const std::string& key) const { return get(key.c_str(), key.size()); }
+
+			/**
+			 * @brief Calls @c function with the key as a <tt>const char*</tt> and the Value for every string key.
+			 */
+			template<typename Function>
+			void forEachField(Function function) const
+			{
+				for (uint32_t i = 0; i < table->slotCount; ++i)
+				{
+					const detail::SnapshotSlot& slot = snapshot->slots[table->slotStart + i];
+
+					if (slot.key != EMPTY_SLOT)
+					{
+						function(snapshot->getString(slot.key), Value(snapshot, &slot.value));
+					}
+				}
+			}
+
+		private:
+			Table(const LuaSnapshot* snapshot, const detail::SnapshotTable* table) : snapshot(snapshot), table(table) {}
+
+			const LuaSnapshot* snapshot;
+			const detail::SnapshotTable* table;
+
+			friend class LuaSnapshot;
+		};
+
+		/**
+		 * @brief Copies a table and all tables reachable from it.
+		 *
+		 * @param table The table to copy
+		 * @return luacpp::LuaSnapshotPtr The snapshot
+		 *
+		 * @exception LuaException Thrown when the table is not valid, too large or nested too deeply
+		 */
+		static LuaSnapshotPtr create(const LuaTable& table);
+
+		/**
+		 * @brief Gets the table the snapshot was created from.
+		 */
+		Table getRoot() const { return Table(this, &tables[0]); }
+
+	private:
+		static const uint32_t EMPTY_SLOT = 0xFFFFFFFF;
+
+		LuaSnapshot();
+
+		const char* getString(uint32_t index) const { return characters.data() + strings[index].offset; }
+
+		static uint32_t hashString(const char* string, size_t length);
+
+		class Builder;
+
+		std::vector<detail::SnapshotTable> tables;
+		std::vector<detail::SnapshotNode> nodes; //!< The array parts of all tables
+		std::vector<detail::SnapshotSlot> slots; //!< The hash parts of all tables
+		std::vector<detail::SnapshotString> strings;
+		std::vector<char> characters; //!< All strings, each one is followed by a null character
+		detail::SnapshotTable emptyTable;
+		detail::SnapshotNode nilNode;
+	};
+
+	/**
+	 * @brief Publishes a snapshot to other threads.
+	 *
+	 * The holder stores a LuaSnapshotPtr which is read and replaced atomically. Readers get their own reference
+	 * to the current snapshot, so a reload builds the new snapshot without blocking anyone and only swaps the
+	 * pointer. The old snapshot is destroyed when the last reader releases it.
+	 */
+	class LuaSnapshotHolder
+	{
+	public:
+		LuaSnapshotHolder() {}
+
+		explicit LuaSnapshotHolder(const LuaSnapshotPtr& snapshot) : snapshot(snapshot) {}
+
+		LuaSnapshotHolder(const LuaSnapshotHolder&) = delete;
+		LuaSnapshotHolder& operator=(const LuaSnapshotHolder&) = delete;
+
+		/**
+		 * @brief Gets the current snapshot, may be called from any thread.
+		 * @return luacpp::LuaSnapshotPtr The snapshot, empty if nothing was published yet
+		 */
+		LuaSnapshotPtr get() const { return boost::atomic_load(&snapshot); }
+
+		/**
+		 * @brief Replaces the current snapshot, may be called from any thread.
+		 * @param newSnapshot The new snapshot
+		 */
+		void publish(const LuaSnapshotPtr& newSnapshot) { boost::atomic_store(&snapshot, newSnapshot); }
+
+		/**
+		 * @brief Replaces the current snapshot and returns the previous one.
+		 * @param newSnapshot The new snapshot
+		 * @return luacpp::LuaSnapshotPtr The previous snapshot
+		 */
+		LuaSnapshotPtr exchange(const LuaSnapshotPtr& newSnapshot) { return boost::atomic_exchange(&snapshot, newSnapshot); }
+
+	private:
+		LuaSnapshotPtr snapshot;
+	};
+}
+
+#endif // LUA_SNAPSHOT_H
@@ -33,6 +33,159 @@ namespace luacpp
 		friend class LuaTable;
 	};
 
+	/**
+	 * @brief A key-value pair of a table which is visited by a LuaTableRange.
+	 *
+	 * The key and the value are stored on the lua stack, no references are created for them. The entry is only
+	 * valid until the iterator is advanced.
+	 */
+	class LuaTableEntry
+	{
+	public:
+		LuaTableEntry(lua_State* L, int keyIndex) : luaState(L), keyIndex(keyIndex) {}
+
+		/**
+		 * @brief Converts the key.
+		 * A copy of the key is converted so converting a number to a string does not affect the iteration.
+		 *
+		 * @return KeyType The key
+		 * @exception LuaException Thrown when the key can not be converted
+		 */
+		template<class KeyType>
+		KeyType key() const
+		{
+			// lua_next gets confused if lua_tolstring is used on the key so always convert a copy
+			lua_pushvalue(luaState, keyIndex);
+
+			try
+			{
+				KeyType key = convert::popValue<KeyType>(luaState, -1, false);
+				lua_pop(luaState, 1);
+
+				return key;
+			}
+			catch (...)
+			{
+				lua_pop(luaState, 1);
+				throw;
+			}
+		}
+
+		/**
+		 * @brief Converts the value.
+		 *
+		 * @return ValueType The value
+		 * @exception LuaException Thrown when the value can not be converted
+		 */
+		template<class ValueType>
+		ValueType value() const
+		{
+			return convert::popValue<ValueType>(luaState, getValueIndex(), false);
+		}
+
+		/**
+		 * @brief Gets the stack position of the key. The key must not be modified.
+		 */
+		int getKeyIndex() const { return keyIndex; }
+
+		/**
+		 * @brief Gets the stack position of the value.
+		 */
+		int getValueIndex() const { return keyIndex + 1; }
+
+		/**
+		 * @brief Gets the lua type of the key, e.g. @c LUA_TSTRING.
+		 */
+		int getKeyType() const { return lua_type(luaState, keyIndex); }
+
+		/**
+		 * @brief Gets the lua type of the value, e.g. @c LUA_TSTRING.
+		 */
+		int getValueType() const { return lua_type(luaState, getValueIndex()); }
+
+	private:
+		lua_State* luaState;
+		int keyIndex;
+	};
+
+	/**
+	 * @brief A range for iterating over a table with a range based for loop.
+	 *
+	 * Created with LuaTable::pairs() or LuaTable::ipairs():
+	 *
+	 * @code
+	 * for (const LuaTableEntry& entry : table.pairs())
+	 * {
+	 * 	std::string key = entry.key<std::string>();
+	 * 	double value = entry.value<double>();
+	 * }
+	 * @endcode
+	 *
+	 * The table is pushed onto the stack while the range exists and the current key and value are kept above it.
+	 * The destructor restores the stack top, so leaving the loop early with @c break, @c return or an exception
+	 * does not leave values on the stack. Values pushed inside the loop body are removed when the iterator is
+	 * advanced. Only one iterator of a range may be used at a time.
+	 */
+	class LuaTableRange
+	{
+	public:
+		class iterator
+		{
+		public:
+			iterator(LuaTableRange* range, bool done);
+
+			const LuaTableEntry& operator*() const { return entry; }
+
+			const LuaTableEntry* operator->() const { return &entry; }
+
+			iterator& operator++();
+
+			bool operator==(const iterator& other) const { return done == other.done; }
+
+			bool operator!=(const iterator& other) const { return done != other.done; }
+
+		private:
+			void next();
+
+			LuaTableRange* range;
+			LuaTableEntry entry;
+			int arrayIndex;
+			bool done;
+		};
+
+		/**
+		 * @brief Pushes the table onto the stack.
+		 *
+		 * @param table The table
+		 * @param arrayOnly @c true to visit the values at the indices 1, 2, ... up to the first nil value
+		 * 	like the @c ipairs function, @c false to visit all pairs like @c pairs
+		 * @exception LuaException Thrown when the table is not valid
+		 */
+		LuaTableRange(const LuaTable& table, bool arrayOnly);
+
+		LuaTableRange(LuaTableRange&& other);
+
+		/**
+		 * @brief Pops the table and everything above it from the stack.
+		 */
+		~LuaTableRange();
+
+		LuaTableRange(const LuaTableRange&) = delete;
+		LuaTableRange& operator=(const LuaTableRange&) = delete;
+
+		/**
+		 * @brief Starts the iteration. This removes the values of a previous iteration from the stack.
+		 */
+		iterator begin();
+
+		iterator end();
+
+	private:
+		lua_State* luaState;
+		int tableIndex;
+		bool arrayOnly;
+	};
+
 	/**
 	* @brief Class to improve handling of lua tables.
 	*
@@ -46,8 +199,15 @@ namespace luacpp
 	public:
 		/**
 		* @brief Creates a new empty table.
+		*
+		* The table has preallocated space for the given number of elements so filling it up to that size
+		* does not need to rehash it.
+		*
+		* @param state The lua state
+		* @param arraySize The number of elements in the array part, i.e. at the indices 1 to @c arraySize
+		* @param hashSize The number of other elements
 		*/
-		static LuaTable create(lua_State* state);
+		static LuaTable create(lua_State* state, int arraySize = 0, int hashSize = 0);
 
 		/**
 		 * @brief Default constructor
@@ -123,16 +283,7 @@ namespace luacpp
 
 			lua_gettable(luaState, -2);
 
-			bool ret = convert::popValue(luaState, target);
-
-			if (!ret)
-			{
-				lua_pop(luaState, 1);
-			}
-
-			lua_pop(luaState, 1);
-
-			return ret;
+			return popField(target);
 		}
 
 		/**
@@ -160,6 +311,117 @@ namespace luacpp
 			}
 		}
 
+		/**
+		 * @brief Adds a value without invoking metamethods.
+		 * Unlike addValue() this uses @c lua_rawset so no lua code can be executed.
+		 *
+		 * @param index The index value to use.
+		 * @param value The value to set at the index.
+		 */
+		template<class IndexType, class ValueType>
+		void rawSet(const IndexType& index, const ValueType& value)
+		{
+			this->pushValue();
+
+			convert::pushValue(luaState, index);
+			convert::pushValue(luaState, value);
+
+			lua_rawset(luaState, -3);
+
+			lua_pop(luaState, 1);
+		}
+
+		/**
+		 * @brief Adds a value at an integer index without invoking metamethods.
+		 *
+		 * @param index The array index.
+		 * @param value The value to set at the index.
+		 */
+		template<class ValueType>
+		void rawSetI(int index, const ValueType& value)
+		{
+			this->pushValue();
+
+			convert::pushValue(luaState, value);
+
+			lua_rawseti(luaState, -2, index);
+
+			lua_pop(luaState, 1);
+		}
+
+		/**
+		 * @brief Retrieves a value without invoking metamethods.
+		 *
+		 * @param index The index where the value is located.
+		 * @param target The target location where the value should be stored.
+		 * @return @c true when the value could be successfully converted, @c false otherwise
+		 */
+		template<class IndexType, class ValueType>
+		bool rawGet(const IndexType& index, ValueType& target)
+		{
+			this->pushValue();
+
+			convert::pushValue(luaState, index);
+
+			lua_rawget(luaState, -2);
+
+			return popField(target);
+		}
+
+		/**
+		 * @brief Gets a value without invoking metamethods or throws an exception. See rawGet().
+		 *
+		 * @exception LuaException Thrown when an error occurs while converting the value
+		 */
+		template<class ValueType, class IndexType>
+		ValueType rawGet(const IndexType& index)
+		{
+			ValueType target;
+
+			if (!rawGet(index, target))
+			{
+				throw LuaException("Failed to get lua value!");
+			}
+
+			return target;
+		}
+
+		/**
+		 * @brief Retrieves the value at an integer index without invoking metamethods.
+		 *
+		 * @param index The array index.
+		 * @param target The target location where the value should be stored.
+		 * @return @c true when the value could be successfully converted, @c false otherwise
+		 */
+		template<class ValueType>
+		bool rawGetI(int index, ValueType& target)
+		{
+			this->pushValue();
+
+			lua_rawgeti(luaState, -1, index);
+
+			return popField(target);
+		}
+
+		/**
+		 * @brief Gets the value at an integer index without invoking metamethods or throws an exception.
+		 * See rawGetI().
+		 *
+		 * @exception LuaException Thrown when an error occurs while converting the value
+		 */
+		template<class ValueType>
+		ValueType rawGetI(int index)
+		{
+			ValueType target;
+
+			if (!rawGetI(index, target))
+			{
+				throw LuaException("Failed to get lua value!");
+			}
+
+			return target;
+		}
+
 		/**
 		 * @brief Gets the length of the table.
 		 *
@@ -174,6 +436,254 @@ namespace luacpp
 		 * @return The iterator instance.
 		 */
 		LuaTableIterator iterator();
+
+		/**
+		 * @brief Creates a range which visits all key-value pairs, like the @c pairs function in lua.
+		 * @see LuaTableRange
+		 */
+		LuaTableRange pairs() const;
+
+		/**
+		 * @brief Creates a range which visits the values at the indices 1, 2, ... up to the first nil value,
+		 * like the @c ipairs function in lua. Metamethods are ignored.
+		 * @see LuaTableRange
+		 */
+		LuaTableRange ipairs() const;
+
+		/**
+		 * @brief Accesses a table which stays on the stack while the accessor exists.
+		 *
+		 * addValue() and getValue() push the table from the registry for every operation. The accessor pushes
+		 * it once and works relative to that stack slot which makes it faster when many fields are accessed:
+		 *
+		 * @code
+		 * {
+		 * 	LuaTable::Accessor access(table);
+		 * 	access.set("x", 1.0);
+		 * 	access.set("y", 2.0);
+		 * 	double x = access.get<double>("x");
+		 * }
+		 * @endcode
+		 *
+		 * The stack top is restored when the accessor is destroyed. Values pushed on top of the table in between
+		 * are removed too, so accessors of the same state must be destroyed in the reverse order of their creation.
+		 */
+		class Accessor
+		{
+		public:
+			/**
+			 * @brief Pushes the table onto the stack.
+			 *
+			 * @param table The table to access
+			 * @exception LuaException Thrown when the table is not valid
+			 */
+			explicit Accessor(const LuaTable& table);
+
+			/**
+			 * @brief Pops the table and everything above it from the stack.
+			 */
+			~Accessor();
+
+			Accessor(const Accessor&) = delete;
+			Accessor& operator=(const Accessor&) = delete;
+
+			/**
+			 * @brief Sets a value, this may invoke the __newindex metamethod.
+			 *
+			 * @param index The index value to use
+			 * @param value The value to set at the index
+			 */
+			template<class IndexType, class ValueType>
+			void set(const IndexType& index, const ValueType& value)
+			{
+				convert::pushValue(luaState, index);
+				convert::pushValue(luaState, value);
+
+				lua_settable(luaState, stackIndex);
+			}
+
+			/**
+			 * @brief Sets a value without invoking metamethods.
+			 *
+			 * @param index The index value to use
+			 * @param value The value to set at the index
+			 */
+			template<class IndexType, class ValueType>
+			void rawSet(const IndexType& index, const ValueType& value)
+			{
+				convert::pushValue(luaState, index);
+				convert::pushValue(luaState, value);
+
+				lua_rawset(luaState, stackIndex);
+			}
+
+			/**
+			 * @brief Retrieves a value, this may invoke the __index metamethod.
+			 *
+			 * @param index The index where the value is located
+			 * @param target The target location where the value should be stored
+			 * @return @c true when the value could be successfully converted, @c false otherwise
+			 */
+			template<class IndexType, class ValueType>
+			bool get(const IndexType& index, ValueType& target)
+			{
+				convert::pushValue(luaState, index);
+
+				lua_gettable(luaState, stackIndex);
+
+				return popField(target);
+			}
+
+			/**
+			 * @brief Gets a value or throws an exception. See get().
+			 *
+			 * @exception LuaException Thrown when the value could not be converted
+			 */
+			template<class ValueType, class IndexType>
+			ValueType get(const IndexType& index)
+			{
+				ValueType target;
+
+				if (!get(index, target))
+				{
+					throw LuaException("Failed to get lua value!");
+				}
+
+				return target;
+			}
+
+			/**
+			 * @brief Retrieves a value without invoking metamethods.
+			 *
+			 * @param index The index where the value is located
+			 * @param target The target location where the value should be stored
+			 * @return @c true when the value could be successfully converted, @c false otherwise
+			 */
+			template<class IndexType, class ValueType>
+			bool rawGet(const IndexType& index, ValueType& target)
+			{
+				convert::pushValue(luaState, index);
+
+				lua_rawget(luaState, stackIndex);
+
+				return popField(target);
+			}
+
+			/**
+			 * @brief Sets the value at an integer index without invoking metamethods.
+			 *
+			 * @param index The array index
+			 * @param value The value to set at the index
+			 */
+			template<class ValueType>
+			void rawSetI(int index, const ValueType& value)
+			{
+				convert::pushValue(luaState, value);
+
+				lua_rawseti(luaState, stackIndex, index);
+			}
+
+			/**
+			 * @brief Retrieves the value at an integer index without invoking metamethods.
+			 *
+			 * @param index The array index
+			 * @param target The target location where the value should be stored
+			 * @return @c true when the value could be successfully converted, @c false otherwise
+			 */
+			template<class ValueType>
+			bool rawGetI(int index, ValueType& target)
+			{
+				lua_rawgeti(luaState, stackIndex, index);
+
+				return popField(target);
+			}
+
+			/**
+			 * @brief Gets the value at an integer index or throws an exception. See rawGetI().
+			 *
+			 * @exception LuaException Thrown when the value could not be converted
+			 */
+			template<class ValueType>
+			ValueType rawGetI(int index)
+			{
+				ValueType target;
+
+				if (!rawGetI(index, target))
+				{
+					throw LuaException("Failed to get lua value!");
+				}
+
+				return target;
+			}
+
+			/**
+			 * @brief Gets the length of the table without invoking metamethods.
+			 * @return size_t The length
+			 */
+			size_t getLength() const { return lua_objlen(luaState, stackIndex); }
+
+			/**
+			 * @brief Checks if the table has a non-nil value at the index, this may invoke the __index metamethod.
+			 *
+			 * @param index The index to check
+			 * @return @c true if the value is not nil
+			 */
+			template<class IndexType>
+			bool has(const IndexType& index)
+			{
+				convert::pushValue(luaState, index);
+
+				lua_gettable(luaState, stackIndex);
+
+				bool exists = !lua_isnil(luaState, -1);
+
+				lua_pop(luaState, 1);
+
+				return exists;
+			}
+
+			/**
+			 * @brief Gets the stack position of the table.
+			 * @return int The absolute stack index
+			 */
+			int getStackIndex() const { return stackIndex; }
+
+		private:
+			template<class ValueType>
+			bool popField(ValueType& target)
+			{
+				bool ret = convert::popValue(luaState, target);
+
+				if (!ret)
+				{
+					lua_pop(luaState, 1);
+				}
+
+				return ret;
+			}
+
+			lua_State* luaState;
+			int stackIndex;
+		};
+
+	private:
+		/**
+		 * @brief Pops the value on top of the stack into @c target and then pops the table below it.
+		 */
+		template<class ValueType>
+		bool popField(ValueType& target)
+		{
+			bool ret = convert::popValue(luaState, target);
+
+			if (!ret)
+			{
+				lua_pop(luaState, 1);
+			}
+
+			lua_pop(luaState, 1);
+
+			return ret;
+		}
 	};
 }
 
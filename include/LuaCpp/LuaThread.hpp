@@ -0,0 +1,212 @@
+#ifndef LUATHREAD_H
+#define LUATHREAD_H
+#pragma once
+
+#include <vector>
+
+#include "LuaCpp/LuaConvert.hpp"
+#include "LuaCpp/LuaValue.hpp"
+#include "LuaCpp/LuaFunction.hpp"
+
+namespace luacpp
+{
+	/**
+	 * @brief The status of a coroutine
+	 */
+	enum class ThreadStatus
+	{
+		SUSPENDED, //!< The thread has a function which was not started yet or it yielded
+		RUNNING, //!< The thread is currently executing, either itself or another coroutine it resumed
+		FINISHED, //!< The function returned without an error or no function was set yet
+		ERRORED //!< The function failed, the thread can not be resumed anymore
+	};
+
+	/**
+	 * @brief A lua coroutine.
+	 *
+	 * Wraps a value of type @c thread and provides ways to resume it from C++ code. Values are passed
+	 * through the lua_State which owns the reference so the arguments may be created on that state as usual.
+	 */
+	class LuaThread : public LuaValue
+	{
+	public:
+		/**
+		 * @brief Creates a new thread which will execute @c function when it is resumed the first time.
+		 *
+		 * @param L The lua state
+		 * @param function The function of the coroutine
+		 * @return luacpp::LuaThread The new thread
+		 */
+		static LuaThread create(lua_State* L, const LuaFunction& function);
+
+		/**
+		 * @brief Creates a new thread without a function. Use setFunction() before resuming it.
+		 *
+		 * @param L The lua state
+		 * @return luacpp::LuaThread The new thread
+		 */
+		static LuaThread create(lua_State* L);
+
+		/**
+		 * @brief Default constructor
+		 */
+		LuaThread();
+
+		/**
+		 * @brief Copy-constructor
+		 * @param other The other thread.
+		 */
+		LuaThread(const LuaThread& other);
+
+		/**
+		 * @brief Frees the reference to the thread if it exists.
+		 */
+		virtual ~LuaThread();
+
+		/**
+		 * @brief Sets a new reference.
+		 * This overload checks if the passed reference is a thread
+		 *
+		 * @param ref The new reference
+		 * @return void
+		 */
+		void setReference(LuaReferencePtr ref) override;
+
+		/**
+		 * @brief Gets the lua_State of the coroutine itself.
+		 * @return lua_State* The state, @c nullptr if the thread is not valid
+		 */
+		lua_State* getThreadState() const { return thread; }
+
+		/**
+		 * @brief Gets the current status of the coroutine.
+		 * @return luacpp::ThreadStatus The status
+		 */
+		ThreadStatus getStatus() const;
+
+		/**
+		 * @brief Sets the function which will be executed by the next resume.
+		 * This is only possible if the thread is ThreadStatus::FINISHED so the stack of a finished coroutine
+		 * can be reused.
+		 *
+		 * @param function The new function
+		 * @return bool @c true if the function was set, @c false if the thread is not finished
+		 */
+		bool setFunction(const LuaFunction& function);
+
+		/**
+		 * @brief Starts or continues the coroutine.
+		 *
+		 * @param arguments The arguments which are passed to the function when it is started or which are
+		 * 	returned by the @c coroutine.yield call that suspended the coroutine.
+		 * @return luacpp::LuaValueList The values passed to @c coroutine.yield or returned by the function.
+		 * 	Use getStatus() to find out which one happened.
+		 *
+		 * @exception LuaException Thrown if the coroutine is not suspended or if it fails with the error as
+		 * 	the message.
+		 */
+		LuaValueList resume(const LuaValueList& arguments = LuaValueList());
+
+		/**
+		 * @brief Starts or continues the coroutine with typed arguments and result.
+		 * The arguments are pushed with convert::pushValues() and the first value that was yielded or
+		 * returned is converted into @c ResultType.
+		 *
+		 * @param args The arguments
+		 * @return ResultType The first result
+		 *
+		 * @exception LuaException Thrown if resuming fails as in resume() or if there is no result which
+		 * 	can be converted.
+		 */
+		template<typename ResultType, typename... Args>
+		ResultType resumeTyped(const Args&... args)
+		{
+			int top = lua_gettop(luaState);
+
+			int numResults = resumeInternal(convert::pushValues(luaState, args...));
+
+			if (numResults < 1)
+			{
+				throw LuaException("Coroutine did not return a value!");
+			}
+
+			try
+			{
+				ResultType result = convert::popValue<ResultType>(luaState, top + 1, false);
+				lua_settop(luaState, top);
+
+				return result;
+			}
+			catch (...)
+			{
+				lua_settop(luaState, top);
+				throw;
+			}
+		}
+
+	private:
+		/**
+		 * @brief Moves @c numArgs values from the top of the stack into the thread and resumes it.
+		 * @return int The number of results which are now on the top of the stack.
+		 */
+		int resumeInternal(int numArgs);
+
+		lua_State* thread;
+	};
+
+	/**
+	 * @brief Recycles the stacks of finished coroutines.
+	 *
+	 * Creating a coroutine allocates a new lua stack. A pool keeps threads which finished without an
+	 * error and hands them out again so starting a new session only needs to set the function.
+	 */
+	class LuaThreadPool
+	{
+	public:
+		/**
+		 * @brief Initializes the pool.
+		 *
+		 * @param L The lua state in which threads are created
+		 * @param maxIdle The maximum number of finished threads which are kept
+		 */
+		LuaThreadPool(lua_State* L, size_t maxIdle = 64);
+
+		/**
+		 * @brief Gets a thread which will execute @c function.
+		 * A recycled thread is used if there is one, otherwise a new thread is created.
+		 *
+		 * @param function The function of the coroutine
+		 * @return luacpp::LuaThread The thread
+		 */
+		LuaThread acquire(const LuaFunction& function);
+
+		/**
+		 * @brief Returns a thread to the pool.
+		 * Only finished threads can be reused, threads which are still suspended or which failed are
+		 * simply dropped.
+		 *
+		 * @param thread The thread
+		 * @return bool @c true if the thread was added to the pool
+		 */
+		bool release(const LuaThread& thread);
+
+		/**
+		 * @brief Gets the number of idle threads in the pool.
+		 * @return size_t The number of threads
+		 */
+		size_t getIdleCount() const { return idle.size(); }
+
+		/**
+		 * @brief Removes all idle threads.
+		 */
+		void clear() { idle.clear(); }
+
+	private:
+		lua_State* luaState;
+		size_t maxIdle;
+
+		std::vector<LuaThread> idle;
+	};
+}
+
+#endif
@@ -0,0 +1,638 @@
+#ifndef LUA_USERTYPE_H
+#define LUA_USERTYPE_H
+#pragma once
+
+#include <new>
+#include <string>
+#include <cstring>
+#include <type_traits>
+
+#include "LuaCpp/LuaHeaders.hpp"
+#include "LuaCpp/LuaException.hpp"
+#include "LuaCpp/LuaTable.hpp"
+#include "LuaCpp/LuaBind.hpp"
+
+namespace luacpp
+{
+	namespace detail
+	{
+		/**
+		 * @brief The address of the tag identifies a usertype
+		 */
+		template<typename T>
+		struct UsertypeTag
+		{
+			static char tag;
+		};
+
+		template<typename T>
+		char UsertypeTag<T>::tag = 0;
+
+		/**
+		 * @brief The start of every usertype userdata, owned objects are stored directly after it
+		 */
+		struct UsertypeHeader
+		{
+			const void* tag;
+			void* object;
+			bool owned;
+		};
+
+		template<typename T, typename Method>
+		struct MethodCall;
+
+		template<typename T, typename Class, typename Result, typename... Args>
+		struct MethodCall<T, Result(Class::*)(Args...)>
+		{
+			Result(Class::*method)(Args...);
+			T* object;
+
+			Result operator()(Args... args) const
+			{
+				return (object->*method)(std::forward<Args>(args)...);
+			}
+		};
+
+		template<typename T, typename Class, typename Result, typename... Args>
+		struct MethodCall<T, Result(Class::*)(Args...) const>
+		{
+			Result(Class::*method)(Args...) const;
+			T* object;
+
+			Result operator()(Args... args) const
+			{
+				return (object->*method)(std::forward<Args>(args)...);
+			}
+		};
+
+		template<typename T, typename Value>
+		struct PropertyGet
+		{
+			Value T::* member;
+			T* object;
+
+			const Value& operator()() const
+			{
+				return object->*member;
+			}
+		};
+
+		template<typename T, typename Value>
+		struct PropertySet
+		{
+			Value T::* member;
+			T* object;
+
+			void operator()(const Value& value) const
+			{
+				object->*member = value;
+			}
+		};
+	}
+
+	/**
+	 * @brief Exposes a C++ class to lua as userdata.
+	 *
+	 * Every usertype has one metatable per lua state which is created by the first Usertype object of the state
+	 * and cached in the registry. Every method is a C closure with the member function pointer as upvalue
+	 * which is stored in the method table of the metatable. As long as no properties exist the method table
+	 * is the @c __index of the metatable so looking up a method does not call any C function.
+	 *
+	 * Values are identified by a type tag at the start of the userdata, converting a value back into a
+	 * pointer does not need to look at the metatable. Arguments and results of methods are converted like
+	 * the ones of functions created with luacpp::bind, pointers to usertypes can be used as arguments and
+	 * results of bound functions. Usertypes can also be passed as non-const references, const references are
+	 * converted to values like all other parameters.
+	 *
+	 * @code
+	 * Usertype<Vector>(L, "Vector").addMethod("length", &Vector::length).addProperty("x", &Vector::x);
+	 * Usertype<Vector>::push(L, Vector(1, 2));
+	 * @endcode
+	 *
+	 * @tparam T The class
+	 */
+	template<typename T>
+	class Usertype
+	{
+	public:
+		/**
+		 * @brief Registers the usertype in the given state or uses the existing registration.
+		 *
+		 * @param L The lua state
+		 * @param name The name used in error messages, ignored if the type is already registered
+		 */
+		Usertype(lua_State* L, const std::string& name) : luaState(L)
+		{
+			if (!pushMetatable(L))
+			{
+				lua_pop(L, 1);
+				createMetatable(L, name);
+			}
+
+			metatable.setReference(LuaReference::create(L));
+
+			lua_pop(L, 1);
+		}
+
+		/**
+		 * @brief Checks if the usertype is registered in the given state.
+		 */
+		static bool isRegistered(lua_State* L)
+		{
+			bool registered = pushMetatable(L);
+
+			lua_pop(L, 1);
+
+			return registered;
+		}
+
+		/**
+		 * @brief Adds a method.
+		 *
+		 * @param name The name of the method
+		 * @param method A pointer to a member function of T or of a base class of T
+		 * @return Usertype& This object
+		 */
+		template<typename Method>
+		Usertype& addMethod(const std::string& name, Method method)
+		{
+			static_assert(std::is_member_function_pointer<Method>::value, "A method must be a member function pointer!");
+
+			lua_State* L = luaState;
+
+			metatable.pushValue();
+			lua_getfield(L, -1, "__methods");
+
+			void* memory = lua_newuserdata(L, sizeof(Method));
+			std::memcpy(memory, &method, sizeof(Method));
+
+			lua_pushcclosure(L, &Usertype::callMethod<Method>, 1);
+			lua_setfield(L, -2, name.c_str());
+
+			lua_pop(L, 2);
+
+			return *this;
+		}
+
+		/**
+		 * @brief Adds a property which accesses a data member.
+		 * Once the usertype has properties the @c __index metamethod is a C function which checks the methods
+		 * first and then the properties.
+		 *
+		 * @param name The name of the property
+		 * @param member A pointer to the data member
+		 * @param writable @c true if the property may be assigned from lua
+		 * @return Usertype& This object
+		 */
+		template<typename Value>
+		Usertype& addProperty(const std::string& name, Value T::* member, bool writable = true)
+		{
+			lua_State* L = luaState;
+
+			metatable.pushValue();
+			int metatableIndex = lua_gettop(L);
+
+			lua_getfield(L, metatableIndex, "__getters");
+
+			void* memory = lua_newuserdata(L, sizeof(member));
+			std::memcpy(memory, &member, sizeof(member));
+
+			lua_pushcclosure(L, &Usertype::getProperty<Value>, 1);
+			lua_setfield(L, -2, name.c_str());
+
+			lua_pop(L, 1);
+
+			if (writable)
+			{
+				lua_getfield(L, metatableIndex, "__setters");
+
+				memory = lua_newuserdata(L, sizeof(member));
+				std::memcpy(memory, &member, sizeof(member));
+
+				lua_pushcclosure(L, &Usertype::setProperty<Value>, 1);
+				lua_setfield(L, -2, name.c_str());
+
+				lua_pop(L, 1);
+			}
+
+			lua_getfield(L, metatableIndex, "__methods");
+			lua_getfield(L, metatableIndex, "__getters");
+			lua_pushcclosure(L, &Usertype::index, 2);
+			lua_setfield(L, metatableIndex, "__index");
+
+			lua_pop(L, 1);
+
+			return *this;
+		}
+
+		/**
+		 * @brief Gets the metatable of the usertype.
+		 */
+		const LuaTable& getMetatable() const
+		{
+			return metatable;
+		}
+
+		/**
+		 * @brief Pushes a copy of the value which is owned by lua.
+		 *
+		 * @param L The lua state
+		 * @param value The value
+		 *
+		 * @exception LuaException Thrown if the usertype is not registered in the state.
+		 */
+		static void push(lua_State* L, const T& value)
+		{
+			pushRegisteredMetatable(L);
+
+			void* memory = lua_newuserdata(L, OBJECT_OFFSET + sizeof(T));
+
+			detail::UsertypeHeader* header = new (memory) detail::UsertypeHeader();
+			header->tag = &detail::UsertypeTag<T>::tag;
+			header->owned = false;
+
+			try
+			{
+				header->object = new (static_cast<char*>(memory) + OBJECT_OFFSET) T(value);
+			}
+			catch (...)
+			{
+				lua_pop(L, 2);
+				throw;
+			}
+
+			header->owned = true;
+
+			setMetatable(L);
+		}
+
+		/**
+		 * @brief Pushes a reference to an object which is owned by C++.
+		 * The object must stay alive as long as lua code can access it.
+		 *
+		 * @param L The lua state
+		 * @param object The object
+		 *
+		 * @exception LuaException Thrown if the usertype is not registered in the state.
+		 */
+		static void pushReference(lua_State* L, T* object)
+		{
+			pushRegisteredMetatable(L);
+
+			detail::UsertypeHeader* header =
+				new (lua_newuserdata(L, sizeof(detail::UsertypeHeader))) detail::UsertypeHeader();
+			header->tag = &detail::UsertypeTag<T>::tag;
+			header->object = object;
+			header->owned = false;
+
+			setMetatable(L);
+		}
+
+		/**
+		 * @brief Gets the object at the given stack position.
+		 *
+		 * @param L The lua state
+		 * @param index The stack position
+		 * @return T* The object or @c nullptr if the value is no object of this usertype
+		 */
+		static T* get(lua_State* L, int index)
+		{
+			void* memory = lua_touserdata(L, index);
+
+			if (memory == nullptr || lua_type(L, index) != LUA_TUSERDATA ||
+				lua_objlen(L, index) < sizeof(detail::UsertypeHeader))
+			{
+				return nullptr;
+			}
+
+			detail::UsertypeHeader* header = static_cast<detail::UsertypeHeader*>(memory);
+
+			if (header->tag != &detail::UsertypeTag<T>::tag)
+			{
+				return nullptr;
+			}
+
+			return static_cast<T*>(header->object);
+		}
+
+		/**
+		 * @brief Gets the object at the given stack position.
+		 *
+		 * @param L The lua state
+		 * @param index The stack position
+		 * @return T& The object
+		 *
+		 * @exception LuaException Thrown if the value is no object of this usertype.
+		 */
+		static T& check(lua_State* L, int index)
+		{
+			T* object = get(L, index);
+
+			if (object == nullptr)
+			{
+				throw LuaException("Specified index is no object of the usertype!");
+			}
+
+			return *object;
+		}
+
+	private:
+		// Owned objects are stored after the header with the alignment they need
+		static const size_t OBJECT_OFFSET =
+			(sizeof(detail::UsertypeHeader) + alignof(T) - 1) / alignof(T) * alignof(T);
+
+		static_assert(alignof(T) <= alignof(double) || alignof(T) <= alignof(void*),
+			"The usertype needs a stronger alignment than lua userdata provide!");
+
+		/**
+		 * @brief Pushes the metatable of the usertype or nil
+		 * @return bool @c true if the usertype is registered
+		 */
+		static bool pushMetatable(lua_State* L)
+		{
+			lua_pushlightuserdata(L, &detail::UsertypeTag<T>::tag);
+			lua_rawget(L, LUA_REGISTRYINDEX);
+
+			return !lua_isnil(L, -1);
+		}
+
+		/**
+		 * @brief Pushes the metatable and throws if the usertype is not registered
+		 */
+		static void pushRegisteredMetatable(lua_State* L)
+		{
+			if (!pushMetatable(L))
+			{
+				lua_pop(L, 1);
+				throw LuaException("The usertype is not registered!");
+			}
+		}
+
+		/**
+		 * @brief Sets the metatable below the new userdata on top of the stack and removes it
+		 */
+		static void setMetatable(lua_State* L)
+		{
+			lua_pushvalue(L, -2);
+			lua_setmetatable(L, -2);
+			lua_remove(L, -2);
+		}
+
+		static void createMetatable(lua_State* L, const std::string& name)
+		{
+			lua_createtable(L, 0, 8);
+			int metatableIndex = lua_gettop(L);
+
+			lua_pushstring(L, name.c_str());
+			lua_setfield(L, metatableIndex, "__typename");
+
+			lua_newtable(L);
+			lua_pushvalue(L, -1);
+			lua_setfield(L, metatableIndex, "__methods");
+			lua_setfield(L, metatableIndex, "__index");
+
+			lua_newtable(L);
+			lua_setfield(L, metatableIndex, "__getters");
+
+			lua_newtable(L);
+			lua_pushvalue(L, -1);
+			lua_setfield(L, metatableIndex, "__setters");
+			lua_pushcclosure(L, &Usertype::newIndex, 1);
+			lua_setfield(L, metatableIndex, "__newindex");
+
+			if (!std::is_trivially_destructible<T>::value)
+			{
+				lua_pushcfunction(L, &Usertype::collect);
+				lua_setfield(L, metatableIndex, "__gc");
+			}
+
+			// Protects the metatable from scripts
+			lua_pushboolean(L, 0);
+			lua_setfield(L, metatableIndex, "__metatable");
+
+			lua_pushlightuserdata(L, &detail::UsertypeTag<T>::tag);
+			lua_pushvalue(L, metatableIndex);
+			lua_rawset(L, LUA_REGISTRYINDEX);
+		}
+
+		/**
+		 * @brief Raises a lua error for an argument which is no object of this usertype
+		 */
+		static int typeError(lua_State* L, int index)
+		{
+			pushMetatable(L);
+			lua_getfield(L, -1, "__typename");
+
+			return luaL_typerror(L, index, lua_tostring(L, -1));
+		}
+
+		template<typename Method>
+		static int callMethod(lua_State* L)
+		{
+			T* object = get(L, 1);
+
+			if (object == nullptr)
+			{
+				return typeError(L, 1);
+			}
+
+			detail::MethodCall<T, Method> call;
+			std::memcpy(&call.method, lua_touserdata(L, lua_upvalueindex(1)), sizeof(Method));
+			call.object = object;
+
+			return bind::detail::dispatch(L, call, 1);
+		}
+
+		template<typename Value>
+		static int getProperty(lua_State* L)
+		{
+			T* object = get(L, 1);
+
+			if (object == nullptr)
+			{
+				return typeError(L, 1);
+			}
+
+			detail::PropertyGet<T, Value> property;
+			std::memcpy(&property.member, lua_touserdata(L, lua_upvalueindex(1)), sizeof(property.member));
+			property.object = object;
+
+			return bind::detail::dispatch(L, property, 1);
+		}
+
+		template<typename Value>
+		static int setProperty(lua_State* L)
+		{
+			T* object = get(L, 1);
+
+			if (object == nullptr)
+			{
+				return typeError(L, 1);
+			}
+
+			detail::PropertySet<T, Value> property;
+			std::memcpy(&property.member, lua_touserdata(L, lua_upvalueindex(1)), sizeof(property.member));
+			property.object = object;
+
+			return bind::detail::dispatch(L, property, 1);
+		}
+
+		/**
+		 * @brief The __index metamethod once properties exist, upvalues are the method and the getter table
+		 */
+		static int index(lua_State* L)
+		{
+			lua_settop(L, 2);
+
+			lua_pushvalue(L, 2);
+			lua_rawget(L, lua_upvalueindex(1));
+
+			if (!lua_isnil(L, -1))
+			{
+				return 1;
+			}
+
+			lua_pop(L, 1);
+
+			lua_pushvalue(L, 2);
+			lua_rawget(L, lua_upvalueindex(2));
+
+			if (lua_isnil(L, -1))
+			{
+				return 1;
+			}
+
+			lua_pushvalue(L, 1);
+			lua_call(L, 1, 1);
+
+			return 1;
+		}
+
+		/**
+		 * @brief The __newindex metamethod, the upvalue is the setter table
+		 */
+		static int newIndex(lua_State* L)
+		{
+			lua_settop(L, 3);
+
+			lua_pushvalue(L, 2);
+			lua_rawget(L, lua_upvalueindex(1));
+
+			if (lua_isnil(L, -1))
+			{
+				return luaL_error(L, "no writable property '%s'", lua_tostring(L, 2));
+			}
+
+			lua_pushvalue(L, 1);
+			lua_pushvalue(L, 3);
+			lua_call(L, 2, 0);
+
+			return 0;
+		}
+
+		static int collect(lua_State* L)
+		{
+			detail::UsertypeHeader* header = static_cast<detail::UsertypeHeader*>(lua_touserdata(L, 1));
+
+			if (header->owned)
+			{
+				static_cast<T*>(header->object)->~T();
+				header->owned = false;
+			}
+
+			return 0;
+		}
+
+		lua_State* luaState;
+		LuaTable metatable;
+	};
+
+	namespace bind
+	{
+		namespace detail
+		{
+			/**
+			 * @brief Pointers to usertypes are converted with a type tag check. Only pointers to classes are
+			 * usertypes, other pointers such as @c const @c char* use the default conversion.
+			 */
+			template<typename T>
+			struct ArgumentConverter<T*, typename std::enable_if<std::is_class<T>::value>::type>
+			{
+				static T* get(lua_State* L, int index)
+				{
+					typedef typename std::remove_const<T>::type Type;
+
+					if (lua_isnil(L, index))
+					{
+						return nullptr;
+					}
+
+					Type* object = Usertype<Type>::get(L, index);
+
+					if (object == nullptr)
+					{
+						throw LuaException("Specified index is no object of the usertype!");
+					}
+
+					return object;
+				}
+
+				static bool matches(lua_State* L, int index)
+				{
+					typedef typename std::remove_const<T>::type Type;
+
+					return lua_isnil(L, index) || Usertype<Type>::get(L, index) != nullptr;
+				}
+			};
+
+			/**
+			 * @brief Non-const references to usertypes, nil is not accepted.
+			 */
+			template<typename T>
+			struct ArgumentConverter<std::reference_wrapper<T>>
+			{
+				static std::reference_wrapper<T> get(lua_State* L, int index)
+				{
+					T* object = Usertype<T>::get(L, index);
+
+					if (object == nullptr)
+					{
+						throw LuaException("Specified index is no object of the usertype!");
+					}
+
+					return std::ref(*object);
+				}
+
+				static bool matches(lua_State* L, int index)
+				{
+					return Usertype<T>::get(L, index) != nullptr;
+				}
+			};
+
+			/**
+			 * @brief Pointers to usertypes are pushed as references, @c nullptr is pushed as nil.
+			 */
+			template<typename T>
+			struct ResultConverter<T*, typename std::enable_if<std::is_class<T>::value>::type>
+			{
+				static int push(lua_State* L, T* object)
+				{
+					typedef typename std::remove_const<T>::type Type;
+
+					if (object == nullptr)
+					{
+						lua_pushnil(L);
+					}
+					else
+					{
+						Usertype<Type>::pushReference(L, const_cast<Type*>(object));
+					}
+
+					return 1;
+				}
+			};
+		}
+	}
+}
+
+#endif // LUA_USERTYPE_H
@@ -3,6 +3,7 @@
 #define LUA_UTIL_H
 #pragma once
 
+#include <functional>
 #include <type_traits> //for std::underlying_type
 
 #include "LuaCpp/LuaValue.hpp"
@@ -35,24 +36,16 @@ namespace luacpp
 
 			keyValueList.clear();
 
-			LuaTableIterator iter = table.iterator();
-			lua_State* L = table.luaState;
-
-			while (iter.toNext())
+			for (const LuaTableEntry& entry : table.pairs())
 			{
-				value_type value = convert::popValue<value_type>(L);
-
-				// lua_next gets confused if we use lua_tolstring here so copy the value and pop it
-				lua_pushvalue(L, -1);
-				key_type key = convert::popValue<key_type>(L);
-
-				keyValueList.push_back(std::make_pair(key, value));
+				keyValueList.push_back(std::make_pair(entry.key<key_type>(), entry.value<value_type>()));
 			}
 		}
 
 		/**
 		 * @brief Fills the given list with all the values from the table.
-		 * This will fill the list with the same value as @c ipairs function in lua.
+		 * This will fill the list with the same value as @c ipairs function in lua. Metamethods of the table are
+		 * ignored.
 		 * 
 		 * @param table The table to be used
 		 * @param list The list into which the values should be inserted
@@ -69,16 +62,138 @@ namespace luacpp
 		{
 			list.clear();
 
-			size_t length = table.getLength();
+			// The table stays on the stack while the elements are read, raw access skips the metamethod checks
+			LuaTable::Accessor access(table);
+
+			int length = static_cast<int>(access.getLength());
 
 			// Lua arrays begin at 1
-			for (size_t i = 1; i <= length; ++i)
+			for (int i = 1; i <= length; ++i)
+			{
+				list.push_back(access.rawGetI<typename Container::value_type>(i));
+			}
+		}
+
+		/**
+		 * @brief Creates a table which contains the values of the container at the indices starting with 1.
+		 * The table is created with the size of the container so it does not need to grow while it is filled.
+		 *
+		 * @param L The lua state
+		 * @param list The values
+		 * @return luacpp::LuaTable The new table
+		 *
+		 * @tparam Container A container with a size function whose values can be converted with convert::pushValue
+		 */
+		template<typename Container>
+		LuaTable listToTable(lua_State* L, const Container& list)
+		{
+			LuaTable table = LuaTable::create(L, static_cast<int>(list.size()), 0);
+
+			LuaTable::Accessor access(table);
+
+			int index = 1;
+			for (const auto& value : list)
+			{
+				access.rawSetI(index, value);
+				++index;
+			}
+
+			return table;
+		}
+
+		/**
+		 * @brief Creates a table which contains the key-value pairs of the container.
+		 * This is the inverse of tableListPairs(), the table is created with space for all pairs.
+		 *
+		 * @param L The lua state
+		 * @param keyValueList The pairs
+		 * @return luacpp::LuaTable The new table
+		 *
+		 * @tparam Container A container of pairs, e.g. a std::map or a std::vector of std::pair
+		 */
+		template<typename Container>
+		LuaTable pairsToTable(lua_State* L, const Container& keyValueList)
+		{
+			LuaTable table = LuaTable::create(L, 0, static_cast<int>(keyValueList.size()));
+
+			LuaTable::Accessor access(table);
+
+			for (const auto& pair : keyValueList)
 			{
-				list.push_back(table.getValue<typename Container::value_type>(i));
+				access.rawSet(pair.first, pair.second);
 			}
+
+			return table;
 		}
 
 		const char* getValueName(ValueType type);
+
+		/**
+		 * @brief An error function which appends a stack traceback to the error message.
+		 * This is a lua_CFunction which can be used as the message handler of lua_pcall. It produces the same
+		 * output as @c debug.traceback, the traceback is only built when an error occurs. Error objects which
+		 * are no strings are returned unchanged.
+		 *
+		 * @param L The lua state
+		 * @return int Always 1
+		 */
+		int traceback(lua_State* L);
+
+		/**
+		 * @brief Specifies if functions of the state use traceback() as their error function by default.
+		 * The setting is read when a LuaFunction gets its reference so it only affects functions created
+		 * afterwards.
+		 *
+		 * @param L The lua state
+		 * @param enable @c true to enable the traceback handler
+		 */
+		void setDefaultTraceback(lua_State* L, bool enable);
+
+		/**
+		 * @brief Checks if functions of the state use traceback() by default.
+		 * @see setDefaultTraceback()
+		 */
+		bool isDefaultTracebackEnabled(lua_State* L);
+
+		/**
+		 * @brief Converts a value which can not be copied by transfer(), e.g. a function or userdata.
+		 *
+		 * The hook gets the source state, the stack position of the value and the destination state. It pushes
+		 * exactly one replacement value onto the destination stack and returns @c true, or returns @c false
+		 * without pushing anything to reject the value.
+		 */
+		typedef std::function<bool(lua_State* source, int index, lua_State* destination)> TransferHook;
+
+		/**
+		 * @brief Copies the value at the given stack position to another lua state and pushes it there.
+		 *
+		 * Nil, booleans, numbers and strings are copied directly and tables are copied deeply. A table which is
+		 * reachable multiple times is only copied once, so shared tables and cycles are preserved. Metatables are
+		 * not copied. Other values are passed to the hook, without a hook they are rejected.
+		 *
+		 * If both states belong to the same main state, e.g. coroutines, the value is moved with @c lua_xmove
+		 * instead of copying it.
+		 *
+		 * Neither state may be used by another thread during the transfer.
+		 *
+		 * @param source The source state
+		 * @param index The stack position of the value in the source state
+		 * @param destination The destination state
+		 * @param hook Converts the values which can not be copied, may be empty
+		 *
+		 * @exception LuaException Thrown when a value can not be transferred. Nothing is pushed in that case.
+		 */
+		void transfer(lua_State* source, int index, lua_State* destination, const TransferHook& hook = TransferHook());
+
+		/**
+		 * @brief Copies a value to another lua state. See transfer(lua_State*, int, lua_State*, const TransferHook&).
+		 *
+		 * @param value The value to copy
+		 * @param destination The destination state
+		 * @param hook Converts the values which can not be copied, may be empty
+		 * @return luacpp::LuaValue The value in the destination state
+		 */
+		LuaValue transfer(const LuaValue& value, lua_State* destination, const TransferHook& hook = TransferHook());
 	}
 }
 
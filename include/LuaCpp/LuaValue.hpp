@@ -164,7 +164,7 @@ namespace luacpp
 		 * 
 		 * @return bool @c true if it can be used and have an underlying reference, @c false otherwise.
 		 */
-		bool isValid() const { return reference->isValid(); }
+		bool isValid() const { return reference && reference->isValid(); }
 
 		/**
 		 * @brief Pushes this lua value onto the stack.
@@ -0,0 +1,263 @@
+#include "LuaCpp/LuaBudget.hpp"
+
+#include "LuaCpp/LuaHeaders.hpp"
+
+namespace
+{
+	// The address is used as the registry key of the innermost budget
+	char budgetKey;
+
+	luacpp::ScopedBudget* getCurrentBudget(lua_State* L)
+	{
+		lua_pushlightuserdata(L, &budgetKey);
+		lua_rawget(L, LUA_REGISTRYINDEX);
+
+		luacpp::ScopedBudget* budget = static_cast<luacpp::ScopedBudget*>(lua_touserdata(L, -1));
+
+		lua_pop(L, 1);
+
+		return budget;
+	}
+
+	void setCurrentBudget(lua_State* L, luacpp::ScopedBudget* budget)
+	{
+		lua_pushlightuserdata(L, &budgetKey);
+
+		if (budget == nullptr)
+		{
+			lua_pushnil(L);
+		}
+		else
+		{
+			lua_pushlightuserdata(L, budget);
+		}
+
+		lua_rawset(L, LUA_REGISTRYINDEX);
+	}
+}
+
+namespace luacpp
+{
+	ScopedBudget::ScopedBudget(lua_State* L, const ExecutionBudget& budget) :
+		luaState(L), budget(budget), outer(nullptr), threadsRef(LUA_NOREF), instructions(0), sliceInstructions(0),
+		restartSlice(false), exceeded(false)
+	{
+		if (L == nullptr)
+		{
+			throw LuaException("Need a valid lua state!");
+		}
+
+		if (budget.checkInterval <= 0)
+		{
+			throw LuaException("The check interval must be positive!");
+		}
+
+		previousHook = lua_gethook(L);
+		previousMask = lua_gethookmask(L);
+		previousCount = lua_gethookcount(L);
+
+		outer = getCurrentBudget(L);
+		setCurrentBudget(L, this);
+
+		int mask = LUA_MASKCOUNT;
+		int count = budget.checkInterval;
+
+		if (previousHook != nullptr)
+		{
+			// The previous hook still receives its events through our hook
+			mask |= previousMask;
+
+			if ((previousMask & LUA_MASKCOUNT) && previousCount < count)
+			{
+				// Keep the finer granularity of the previous hook
+				count = previousCount;
+			}
+		}
+
+		start = ExecutionBudget::Clock::now();
+
+		lua_sethook(L, &ScopedBudget::hook, mask, count);
+	}
+
+	ScopedBudget::~ScopedBudget()
+	{
+		lua_sethook(luaState, previousHook, previousMask, previousCount);
+
+		if (threadsRef != LUA_NOREF)
+		{
+			// Coroutines which ran with the hook of this budget get the previous hook back as well
+			lua_rawgeti(luaState, LUA_REGISTRYINDEX, threadsRef);
+
+			lua_pushnil(luaState);
+			while (lua_next(luaState, -2))
+			{
+				lua_State* thread = lua_tothread(luaState, -2);
+
+				if (thread != nullptr && lua_gethook(thread) == &ScopedBudget::hook)
+				{
+					lua_sethook(thread, previousHook, previousMask, previousCount);
+				}
+
+				lua_pop(luaState, 1);
+			}
+
+			lua_pop(luaState, 1);
+
+			luaL_unref(luaState, LUA_REGISTRYINDEX, threadsRef);
+		}
+
+		setCurrentBudget(luaState, outer);
+	}
+
+	void ScopedBudget::addThread(lua_State* L)
+	{
+		if (threadsRef == LUA_NOREF)
+		{
+			// The keys are weak so the budget does not keep finished coroutines alive
+			lua_newtable(L);
+			lua_newtable(L);
+			lua_pushliteral(L, "__mode");
+			lua_pushliteral(L, "k");
+			lua_rawset(L, -3);
+			lua_setmetatable(L, -2);
+
+			threadsRef = luaL_ref(L, LUA_REGISTRYINDEX);
+		}
+
+		lua_rawgeti(L, LUA_REGISTRYINDEX, threadsRef);
+		lua_pushthread(L);
+		lua_pushboolean(L, 1);
+		lua_rawset(L, -3);
+		lua_pop(L, 1);
+	}
+
+	bool ScopedBudget::charge(int count, ExecutionBudget::Clock::time_point now)
+	{
+		if (restartSlice)
+		{
+			// The coroutine was resumed after it yielded because of this budget
+			start = now;
+			sliceInstructions = 0;
+			restartSlice = false;
+		}
+
+		instructions += count;
+		sliceInstructions += count;
+
+		if (exceeded)
+		{
+			return true;
+		}
+
+		if (budget.maxInstructions > 0 && sliceInstructions > budget.maxInstructions)
+		{
+			return true;
+		}
+
+		if (budget.maxTime > ExecutionBudget::Clock::duration::zero() && now - start > budget.maxTime)
+		{
+			return true;
+		}
+
+		return false;
+	}
+
+	void ScopedBudget::hook(lua_State* L, lua_Debug* ar)
+	{
+		ScopedBudget* current = getCurrentBudget(L);
+
+		if (current == nullptr)
+		{
+			// A coroutine created inside a budget which has ended since, the hook has no owner anymore
+			if (lua_gethook(L) == &ScopedBudget::hook)
+			{
+				lua_sethook(L, nullptr, 0, 0);
+			}
+
+			return;
+		}
+
+		// Find the hook which was installed before the outermost budget
+		lua_Hook forward = nullptr;
+		int forwardMask = 0;
+		for (ScopedBudget* budget = current; budget != nullptr; budget = budget->outer)
+		{
+			if (budget->previousHook != &ScopedBudget::hook)
+			{
+				forward = budget->previousHook;
+				forwardMask = budget->previousMask;
+				break;
+			}
+		}
+
+		if (ar->event != LUA_HOOKCOUNT)
+		{
+			if (forward != nullptr)
+			{
+				forward(L, ar);
+			}
+
+			return;
+		}
+
+		if (L != current->luaState)
+		{
+			// Coroutines inherit the hook when they are created, the budget restores them when it ends
+			current->addThread(L);
+		}
+
+		int count = lua_gethookcount(L);
+		ExecutionBudget::Clock::time_point now = ExecutionBudget::Clock::now();
+
+		ScopedBudget* exhausted = nullptr;
+		for (ScopedBudget* budget = current; budget != nullptr; budget = budget->outer)
+		{
+			if (budget->charge(count, now) && exhausted == nullptr)
+			{
+				exhausted = budget;
+			}
+		}
+
+		if (forward != nullptr && (forwardMask & LUA_MASKCOUNT))
+		{
+			forward(L, ar);
+		}
+
+		if (exhausted == nullptr)
+		{
+			return;
+		}
+
+		if (exhausted->budget.yieldInCoroutine && !exhausted->exceeded)
+		{
+			// lua_pushthread returns 1 for the main thread which can not yield
+			int isMainThread = lua_pushthread(L);
+			lua_pop(L, 1);
+
+			if (!isMainThread)
+			{
+				exhausted->restartSlice = true;
+				lua_yield(L, 0);
+				return;
+			}
+		}
+
+		exhausted->exceeded = true;
+
+		// Check every instruction from now on so the error also reaches code which catches it with pcall
+		lua_Hook installed = lua_gethook(L);
+
+		if (installed == &ScopedBudget::hook)
+		{
+			lua_sethook(L, &ScopedBudget::hook, LUA_MASKCOUNT | (forward != nullptr ? forwardMask : 0), 1);
+		}
+		else if (installed != nullptr)
+		{
+			// A hook which was installed after the budget, e.g. by a LuaProfiler, passes the events on to this one
+			lua_sethook(L, installed, lua_gethookmask(L) | LUA_MASKCOUNT, 1);
+		}
+
+		lua_pushliteral(L, "Execution budget exceeded!");
+		lua_error(L);
+	}
+}
@@ -26,56 +26,56 @@ namespace luacpp
 	namespace convert
 	{
 		template<>
-		void pushValue<double>(lua_State* luaState, const double& value)
+		void Converter<double>::push(lua_State* luaState, const double& value)
 		{
 			lua_pushnumber(luaState, value);
 		}
 
 		template<>
-		void pushValue<float>(lua_State* luaState, const float& value)
+		void Converter<float>::push(lua_State* luaState, const float& value)
 		{
 			lua_pushnumber(luaState, value);
 		}
 
 		template<>
-		void pushValue<int>(lua_State* luaState, const int& value)
+		void Converter<int>::push(lua_State* luaState, const int& value)
 		{
 			lua_pushnumber(luaState, value);
 		}
 
 		template<>
-		void pushValue<size_t>(lua_State* luaState, const size_t& value)
+		void Converter<size_t>::push(lua_State* luaState, const size_t& value)
 		{
 			lua_pushnumber(luaState, value);
 		}
 
 		template<>
-		void pushValue<std::string>(lua_State* luaState, const std::string& value)
+		void Converter<std::string>::push(lua_State* luaState, const std::string& value)
 		{
 			lua_pushlstring(luaState, value.c_str(), value.size());
 		}
 
 		template<>
-		void pushValue<const char*>(lua_State* luaState, const char* const& value)
+		void Converter<const char*>::push(lua_State* luaState, const char* const& value)
 		{
 			lua_pushstring(luaState, value);
 		}
 
 		template<>
-		void pushValue<bool>(lua_State* luaState, const bool& value)
+		void Converter<bool>::push(lua_State* luaState, const bool& value)
 		{
 			lua_pushboolean(luaState, value);
 		}
 
 		template<>
-		void pushValue<lua_CFunction>(lua_State* luaState,
-		                              const lua_CFunction& value)
+		void Converter<lua_CFunction>::push(lua_State* luaState,
+		                                    const lua_CFunction& value)
 		{
 			lua_pushcfunction(luaState, value);
 		}
 
 		template<>
-		void pushValue<LuaValue>(lua_State* luaState, const LuaValue& value)
+		void Converter<LuaValue>::push(lua_State* luaState, const LuaValue& value)
 		{
 			if (luaState != value.luaState)
 			{
@@ -86,7 +86,7 @@ namespace luacpp
 		}
 
 		template<>
-		double popValue<double>(lua_State* luaState, int stackposition, bool remove)
+		double Converter<double>::pop(lua_State* luaState, int stackposition, bool remove)
 		{
 			if (!isValidIndex(luaState, stackposition))
 			{
@@ -111,25 +111,25 @@ namespace luacpp
 		}
 
 		template<>
-		float popValue<float>(lua_State* luaState, int stackposition, bool remove)
+		float Converter<float>::pop(lua_State* luaState, int stackposition, bool remove)
 		{
 			return static_cast<float>(popValue<double>(luaState, stackposition, remove));
 		}
 
 		template<>
-		int popValue<int>(lua_State* luaState, int stackposition, bool remove)
+		int Converter<int>::pop(lua_State* luaState, int stackposition, bool remove)
 		{
 			return static_cast<int>(popValue<double>(luaState, stackposition, remove));
 		}
 
 		template<>
-		size_t popValue<size_t>(lua_State* luaState, int stackposition, bool remove)
+		size_t Converter<size_t>::pop(lua_State* luaState, int stackposition, bool remove)
 		{
 			return static_cast<size_t>(popValue<double>(luaState, stackposition, remove));
 		}
 
 		template<>
-		std::string popValue<std::string>(lua_State* luaState, int stackposition, bool remove)
+		std::string Converter<std::string>::pop(lua_State* luaState, int stackposition, bool remove)
 		{
 			if (!isValidIndex(luaState, stackposition))
 			{
@@ -158,7 +158,7 @@ namespace luacpp
 		}
 
 		template<>
-		bool popValue<bool>(lua_State* luaState, int stackposition, bool remove)
+		bool Converter<bool>::pop(lua_State* luaState, int stackposition, bool remove)
 		{
 			if (!isValidIndex(luaState, stackposition))
 			{
@@ -183,7 +183,7 @@ namespace luacpp
 		}
 
 		template<>
-		lua_CFunction popValue<lua_CFunction>(lua_State* luaState, int stackposition, bool remove)
+		lua_CFunction Converter<lua_CFunction>::pop(lua_State* luaState, int stackposition, bool remove)
 		{
 			if (!isValidIndex(luaState, stackposition))
 			{
@@ -208,7 +208,7 @@ namespace luacpp
 		}
 
 		template<>
-		LuaTable popValue<LuaTable>(lua_State* luaState, int stackposition, bool remove)
+		LuaTable Converter<LuaTable>::pop(lua_State* luaState, int stackposition, bool remove)
 		{
 			if (!isValidIndex(luaState, stackposition))
 			{
@@ -234,7 +234,7 @@ namespace luacpp
 		}
 
 		template<>
-		LuaFunction popValue<LuaFunction>(lua_State* luaState, int stackposition, bool remove)
+		LuaFunction Converter<LuaFunction>::pop(lua_State* luaState, int stackposition, bool remove)
 		{
 			if (!isValidIndex(luaState, stackposition))
 			{
@@ -260,7 +260,7 @@ namespace luacpp
 		}
 
 		template<>
-		LuaValue popValue<LuaValue>(lua_State* luaState, int stackposition, bool remove)
+		LuaValue Converter<LuaValue>::pop(lua_State* luaState, int stackposition, bool remove)
 		{
 			if (!isValidIndex(luaState, stackposition))
 			{
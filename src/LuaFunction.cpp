@@ -1,5 +1,6 @@
 #include "LuaCpp/LuaFunction.hpp"
 #include "LuaCpp/LuaException.hpp"
+#include "LuaCpp/LuaUtil.hpp"
 
 #include "LuaCpp/LuaHeaders.hpp"
 
@@ -30,6 +31,16 @@ namespace luacpp
 
 			lua_pop(L, 1);
 
+			if (!name.empty())
+			{
+				MetricsRegistry* registry = MetricsRegistry::find(L);
+
+				if (registry != nullptr && registry->isChunkInstrumentationEnabled())
+				{
+					func.setMetrics(registry->get(name));
+				}
+			}
+
 			return func;
 		}
 		else
@@ -44,11 +55,13 @@ namespace luacpp
 		}
 	}
 
-	LuaFunction::LuaFunction() : LuaValue(), isCFunction(false), errorFunction(nullptr)
+	LuaFunction::LuaFunction() : LuaValue(), isCFunction(false), errorFunction(nullptr), useTraceback(false),
+		tracebackSet(false)
 	{
 	}
 
-	LuaFunction::LuaFunction(const LuaFunction& other) : LuaValue(other), errorFunction(nullptr)
+	LuaFunction::LuaFunction(const LuaFunction& other) : LuaValue(other), errorFunction(nullptr),
+		useTraceback(other.useTraceback), tracebackSet(other.tracebackSet), metrics(other.metrics)
 	{
 	}
 	
@@ -94,25 +107,78 @@ namespace luacpp
 		{
 			lua_pop(L, 1);
 			LuaValue::setReference(reference);
+
+			if (!tracebackSet)
+			{
+				useTraceback = util::isDefaultTracebackEnabled(L);
+			}
 		}
 	}
 
-	LuaValueList LuaFunction::call(const LuaValueList& args)
+	int LuaFunction::pushErrorFunction()
 	{
-		int err_idx = 0;
-		int stackTop;
-
 		if (errorFunction)
 		{
 			// push the error function
 			errorFunction->pushValue();
-			err_idx = lua_gettop(luaState);
-			stackTop = err_idx;
+			return lua_gettop(luaState);
+		}
+		else if (useTraceback)
+		{
+			lua_pushcfunction(luaState, &util::traceback);
+			return lua_gettop(luaState);
 		}
 		else
 		{
-			stackTop = lua_gettop(luaState);
+			return 0;
 		}
+	}
+
+	LuaValueList LuaFunction::call(const LuaValueList& args)
+	{
+		LuaCallResult result = tryCall(args);
+
+		if (!result.isOk())
+		{
+			// Throw exception with generated message
+			throw LuaException(result.getError().getMessage());
+		}
+
+		return std::move(result.getValues());
+	}
+
+	LuaValueList LuaFunction::callWithBudget(const ExecutionBudget& budget, const LuaValueList& args)
+	{
+		LuaCallResult result;
+		bool exceeded;
+
+		{
+			ScopedBudget scope(luaState, budget);
+
+			result = tryCall(args);
+			exceeded = scope.isExceeded();
+		}
+
+		if (exceeded)
+		{
+			throw BudgetExceededException();
+		}
+
+		if (!result.isOk())
+		{
+			throw LuaException(result.getError().getMessage());
+		}
+
+		return std::move(result.getValues());
+	}
+
+	LuaCallResult LuaFunction::tryCall(const LuaValueList& args)
+	{
+		LuaCallResult result;
+
+		int entryTop = lua_gettop(luaState);
+		int err_idx = pushErrorFunction();
+		int stackTop = lua_gettop(luaState);
 
 		// Push the function onto the stack
 		this->pushValue();
@@ -123,48 +189,117 @@ namespace luacpp
 			iter->pushValue();
 		}
 
+		std::chrono::steady_clock::time_point start;
+		if (metrics)
+		{
+			start = std::chrono::steady_clock::now();
+		}
+
 		// actually call the function now!
-		int err = lua_pcall(luaState, args.size(), LUA_MULTRET, err_idx);
+		int err = lua_pcall(luaState, static_cast<int>(args.size()), LUA_MULTRET, err_idx);
+
+		if (metrics)
+		{
+			recordCall(start, err != 0);
+		}
 
 		if (!err)
 		{
 			int numReturn = lua_gettop(luaState) - stackTop;
-			LuaValueList values;
-			values.reserve(numReturn);
+			result.values.resize(numReturn);
 
-			LuaValue val;
-			for (int i = 0; i < numReturn; ++i)
+			try
 			{
-				auto top = lua_gettop(luaState);
-				if (convert::popValue(luaState, val))
+				// The first return value is directly above the previous stack top, nil values get no registry slot
+				for (int i = 0; i < numReturn; ++i)
 				{
-					top = lua_gettop(luaState);
-					// Add values at the begin as the last return value is on top
-					// of the stack.
-					values.insert(values.begin(), val);
+					result.values[i].setReference(LuaReference::create(luaState, stackTop + 1 + i));
 				}
 			}
-
-			if (err_idx != 0)
+			catch (...)
 			{
-				// Remove the error function
-				lua_remove(luaState, err_idx);
+				lua_settop(luaState, entryTop);
+				throw;
 			}
 
-			return values;
+			lua_settop(luaState, stackTop);
 		}
 		else
 		{
-			// Throw exception with generated message
-			LuaException exception(convert::popValue<std::string>(luaState));
+			CallStatus status;
+			switch (err)
+			{
+			case LUA_ERRMEM:
+				status = CallStatus::MEMORY_ERROR;
+				break;
+			case LUA_ERRERR:
+				status = CallStatus::ERROR_HANDLER_ERROR;
+				break;
+			default:
+				status = CallStatus::RUNTIME_ERROR;
+				break;
+			}
+
+			LuaValue value;
 
-			if (err_idx != 0)
+			try
 			{
-				// Pop the error function
-				lua_pop(luaState, 1);
+				// error() and error(nil) raise a nil error object
+				value.setReference(LuaReference::create(luaState));
 			}
+			catch (...)
+			{
+				lua_settop(luaState, entryTop);
+				throw;
+			}
+
+			lua_pop(luaState, 1);
 
-			throw exception;
+			result.error = LuaError(status, value);
 		}
+
+		if (err_idx != 0)
+		{
+			// Remove the error function
+			lua_remove(luaState, err_idx);
+		}
+
+		return result;
+	}
+
+	void LuaFunction::recordCall(std::chrono::steady_clock::time_point start, bool failed)
+	{
+		std::chrono::steady_clock::duration duration = std::chrono::steady_clock::now() - start;
+
+		metrics->record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()),
+			failed);
+	}
+
+	std::string LuaError::getMessage() const
+	{
+		if (!value.isValid())
+		{
+			return std::string();
+		}
+
+		value.pushValue();
+
+		std::string message;
+
+		size_t len;
+		const char* str = lua_tolstring(value.luaState, -1, &len);
+
+		if (str != nullptr)
+		{
+			message.assign(str, len);
+		}
+		else
+		{
+			message = std::string("Error object is a ") + util::getValueName(value.getValueType()) + " value!";
+		}
+
+		lua_pop(value.luaState, 1);
+
+		return message;
 	}
-}
\ No newline at end of file
+}
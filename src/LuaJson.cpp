@@ -0,0 +1,1009 @@
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+
+#include "LuaCpp/LuaJson.hpp"
+#include "LuaCpp/LuaConvert.hpp"
+
+namespace
+{
+	using namespace luacpp;
+	using namespace luacpp::json;
+
+	/**
+	 * @brief Reads JSON text and reports what it finds to a handler, like a SAX parser.
+	 *
+	 * The handler must provide onNull(), onBoolean(bool), onNumber(double), onString(const char*, size_t, bool isKey),
+	 * onStartArray(), onEndArray(), onStartObject() and onEndObject().
+	 */
+	template<typename Handler>
+	class Parser
+	{
+	public:
+		Parser(const char* text, size_t length, size_t maxDepth, Handler& handler) :
+			start(text), position(text), end(text + length), maxDepth(maxDepth), handler(handler)
+		{
+		}
+
+		void parse()
+		{
+			skipWhitespace();
+			parseValue(0);
+			skipWhitespace();
+
+			if (position != end)
+			{
+				fail("Unexpected data after the value");
+			}
+		}
+
+	private:
+		void fail(const char* message)
+		{
+			char buffer[128];
+			std::snprintf(buffer, sizeof(buffer), "Invalid JSON at offset %u: %s!",
+				static_cast<unsigned int>(position - start), message);
+
+			throw LuaException(buffer);
+		}
+
+		void skipWhitespace()
+		{
+			while (position != end && (*position == ' ' || *position == '\t' || *position == '\n' || *position == '\r'))
+			{
+				++position;
+			}
+		}
+
+		char peek()
+		{
+			if (position == end)
+			{
+				fail("Unexpected end of text");
+			}
+
+			return *position;
+		}
+
+		void expectLiteral(const char* literal, size_t length)
+		{
+			if (static_cast<size_t>(end - position) < length || std::memcmp(position, literal, length) != 0)
+			{
+				fail("Invalid literal");
+			}
+
+			position += length;
+		}
+
+		void parseValue(size_t depth)
+		{
+			switch (peek())
+			{
+			case '{':
+				parseObject(depth + 1);
+				break;
+			case '[':
+				parseArray(depth + 1);
+				break;
+			case '"':
+				parseString(false);
+				break;
+			case 't':
+				expectLiteral("true", 4);
+				handler.onBoolean(true);
+				break;
+			case 'f':
+				expectLiteral("false", 5);
+				handler.onBoolean(false);
+				break;
+			case 'n':
+				expectLiteral("null", 4);
+				handler.onNull();
+				break;
+			default:
+				parseNumber();
+				break;
+			}
+		}
+
+		void checkDepth(size_t depth)
+		{
+			if (depth > maxDepth)
+			{
+				fail("Nesting exceeds the depth limit");
+			}
+		}
+
+		void parseArray(size_t depth)
+		{
+			checkDepth(depth);
+
+			++position;
+			handler.onStartArray();
+
+			skipWhitespace();
+
+			if (peek() == ']')
+			{
+				++position;
+				handler.onEndArray();
+				return;
+			}
+
+			while (true)
+			{
+				skipWhitespace();
+				parseValue(depth);
+				skipWhitespace();
+
+				char next = peek();
+				++position;
+
+				if (next == ']')
+				{
+					handler.onEndArray();
+					return;
+				}
+				else if (next != ',')
+				{
+					--position;
+					fail("Expected ',' or ']'");
+				}
+			}
+		}
+
+		void parseObject(size_t depth)
+		{
+			checkDepth(depth);
+
+			++position;
+			handler.onStartObject();
+
+			skipWhitespace();
+
+			if (peek() == '}')
+			{
+				++position;
+				handler.onEndObject();
+				return;
+			}
+
+			while (true)
+			{
+				skipWhitespace();
+
+				if (peek() != '"')
+				{
+					fail("Expected a string key");
+				}
+
+				parseString(true);
+
+				skipWhitespace();
+
+				if (peek() != ':')
+				{
+					fail("Expected ':'");
+				}
+
+				++position;
+
+				skipWhitespace();
+				parseValue(depth);
+				skipWhitespace();
+
+				char next = peek();
+				++position;
+
+				if (next == '}')
+				{
+					handler.onEndObject();
+					return;
+				}
+				else if (next != ',')
+				{
+					--position;
+					fail("Expected ',' or '}'");
+				}
+			}
+		}
+
+		void parseString(bool isKey)
+		{
+			// Skip the quote
+			++position;
+
+			const char* begin = position;
+
+			// Strings without escape sequences are passed on without copying them
+			while (position != end && *position != '"' && *position != '\\')
+			{
+				if (static_cast<unsigned char>(*position) < 0x20)
+				{
+					fail("Control character in string");
+				}
+
+				++position;
+			}
+
+			if (peek() == '"')
+			{
+				handler.onString(begin, static_cast<size_t>(position - begin), isKey);
+				++position;
+				return;
+			}
+
+			scratch.assign(begin, position);
+
+			while (true)
+			{
+				char current = peek();
+				++position;
+
+				if (current == '"')
+				{
+					break;
+				}
+				else if (current == '\\')
+				{
+					parseEscape();
+				}
+				else if (static_cast<unsigned char>(current) < 0x20)
+				{
+					--position;
+					fail("Control character in string");
+				}
+				else
+				{
+					scratch.push_back(current);
+				}
+			}
+
+			handler.onString(scratch.data(), scratch.size(), isKey);
+		}
+
+		void parseEscape()
+		{
+			char escaped = peek();
+			++position;
+
+			switch (escaped)
+			{
+			case '"': scratch.push_back('"'); break;
+			case '\\': scratch.push_back('\\'); break;
+			case '/': scratch.push_back('/'); break;
+			case 'b': scratch.push_back('\b'); break;
+			case 'f': scratch.push_back('\f'); break;
+			case 'n': scratch.push_back('\n'); break;
+			case 'r': scratch.push_back('\r'); break;
+			case 't': scratch.push_back('\t'); break;
+			case 'u':
+			{
+				uint32_t codePoint = parseHex();
+
+				if (codePoint >= 0xD800 && codePoint <= 0xDBFF)
+				{
+					// A high surrogate must be followed by a low surrogate
+					if (end - position < 2 || position[0] != '\\' || position[1] != 'u')
+					{
+						fail("Missing low surrogate");
+					}
+
+					position += 2;
+
+					uint32_t low = parseHex();
+
+					if (low < 0xDC00 || low > 0xDFFF)
+					{
+						fail("Invalid low surrogate");
+					}
+
+					codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+				}
+				else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF)
+				{
+					fail("Unexpected low surrogate");
+				}
+
+				appendUtf8(codePoint);
+				break;
+			}
+			default:
+				--position;
+				fail("Invalid escape sequence");
+			}
+		}
+
+		uint32_t parseHex()
+		{
+			if (end - position < 4)
+			{
+				fail("Unexpected end of text");
+			}
+
+			uint32_t value = 0;
+
+			for (int i = 0; i < 4; ++i)
+			{
+				char digit = *position++;
+				value <<= 4;
+
+				if (digit >= '0' && digit <= '9')
+				{
+					value |= static_cast<uint32_t>(digit - '0');
+				}
+				else if (digit >= 'a' && digit <= 'f')
+				{
+					value |= static_cast<uint32_t>(digit - 'a' + 10);
+				}
+				else if (digit >= 'A' && digit <= 'F')
+				{
+					value |= static_cast<uint32_t>(digit - 'A' + 10);
+				}
+				else
+				{
+					--position;
+					fail("Invalid hex digit");
+				}
+			}
+
+			return value;
+		}
+
+		void appendUtf8(uint32_t codePoint)
+		{
+			if (codePoint < 0x80)
+			{
+				scratch.push_back(static_cast<char>(codePoint));
+			}
+			else if (codePoint < 0x800)
+			{
+				scratch.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+				scratch.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+			}
+			else if (codePoint < 0x10000)
+			{
+				scratch.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+				scratch.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+				scratch.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+			}
+			else
+			{
+				scratch.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+				scratch.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+				scratch.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+				scratch.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+			}
+		}
+
+		bool isDigit()
+		{
+			return position != end && *position >= '0' && *position <= '9';
+		}
+
+		void parseNumber()
+		{
+			const char* begin = position;
+
+			bool negative = false;
+
+			if (*position == '-')
+			{
+				negative = true;
+				++position;
+			}
+
+			if (!isDigit())
+			{
+				fail("Invalid value");
+			}
+
+			// Leading zeros are not allowed
+			if (*position == '0')
+			{
+				++position;
+			}
+			else
+			{
+				while (isDigit())
+				{
+					++position;
+				}
+			}
+
+			bool isInteger = true;
+
+			if (position != end && *position == '.')
+			{
+				isInteger = false;
+				++position;
+
+				if (!isDigit())
+				{
+					fail("Invalid number");
+				}
+
+				while (isDigit())
+				{
+					++position;
+				}
+			}
+
+			if (position != end && (*position == 'e' || *position == 'E'))
+			{
+				isInteger = false;
+				++position;
+
+				if (position != end && (*position == '+' || *position == '-'))
+				{
+					++position;
+				}
+
+				if (!isDigit())
+				{
+					fail("Invalid number");
+				}
+
+				while (isDigit())
+				{
+					++position;
+				}
+			}
+
+			size_t length = static_cast<size_t>(position - begin);
+			size_t digits = negative ? length - 1 : length;
+
+			if (isInteger && digits <= 15)
+			{
+				// Small integers are exact as doubles, no need for strtod
+				int64_t value = 0;
+
+				for (const char* digit = negative ? begin + 1 : begin; digit != position; ++digit)
+				{
+					value = value * 10 + (*digit - '0');
+				}
+
+				handler.onNumber(static_cast<double>(negative ? -value : value));
+				return;
+			}
+
+			// strtod needs a terminated string
+			char buffer[64];
+			std::string longNumber;
+			const char* number = buffer;
+
+			if (length < sizeof(buffer))
+			{
+				std::memcpy(buffer, begin, length);
+				buffer[length] = '\0';
+			}
+			else
+			{
+				longNumber.assign(begin, length);
+				number = longNumber.c_str();
+			}
+
+			handler.onNumber(std::strtod(number, nullptr));
+		}
+
+		const char* start;
+		const char* position;
+		const char* end;
+		size_t maxDepth;
+		Handler& handler;
+
+		std::string scratch; //!< Receives strings with escape sequences
+	};
+
+	/**
+	 * @brief Builds lua values from the events of the parser.
+	 *
+	 * The elements of an array or object are collected on the stack until the container ends, then the table
+	 * is created with the exact size. When many elements are collected the table is created early and the
+	 * collected elements are moved into it so the stack does not grow without bounds.
+	 */
+	class TableBuilder
+	{
+	public:
+		explicit TableBuilder(lua_State* L) : luaState(L)
+		{
+		}
+
+		void onNull()
+		{
+			checkStack();
+			lua_pushnil(luaState);
+			afterValue();
+		}
+
+		void onBoolean(bool value)
+		{
+			checkStack();
+			lua_pushboolean(luaState, value ? 1 : 0);
+			afterValue();
+		}
+
+		void onNumber(double value)
+		{
+			checkStack();
+			lua_pushnumber(luaState, static_cast<lua_Number>(value));
+			afterValue();
+		}
+
+		void onString(const char* value, size_t length, bool isKey)
+		{
+			checkStack();
+			lua_pushlstring(luaState, value, length);
+
+			if (!isKey)
+			{
+				afterValue();
+			}
+		}
+
+		void onStartArray()
+		{
+			startContainer(false);
+		}
+
+		void onEndArray()
+		{
+			endContainer();
+		}
+
+		void onStartObject()
+		{
+			startContainer(true);
+		}
+
+		void onEndObject()
+		{
+			endContainer();
+		}
+
+	private:
+		// The number of stack slots a container may use for its elements, this is even so a pair is never split
+		static const int MAX_PENDING = 32;
+
+		struct Frame
+		{
+			bool isObject;
+			int table; //!< The stack index of the table, 0 if it was not created yet
+			int base; //!< The stack index of the first collected element
+			int count; //!< The number of array elements in the table
+		};
+
+		void checkStack()
+		{
+			if (!lua_checkstack(luaState, 3))
+			{
+				throw LuaException("Not enough stack space to parse the JSON text!");
+			}
+		}
+
+		void startContainer(bool isObject)
+		{
+			checkStack();
+
+			Frame frame;
+			frame.isObject = isObject;
+			frame.table = 0;
+			frame.base = lua_gettop(luaState) + 1;
+			frame.count = 0;
+
+			frames.push_back(frame);
+		}
+
+		void endContainer()
+		{
+			flush(frames.back());
+
+			frames.pop_back();
+
+			afterValue();
+		}
+
+		void afterValue()
+		{
+			if (frames.empty())
+			{
+				return;
+			}
+
+			Frame& frame = frames.back();
+
+			if (lua_gettop(luaState) - frame.base + 1 >= MAX_PENDING)
+			{
+				flush(frame);
+			}
+		}
+
+		/**
+		 * @brief Moves the collected elements into the table, the table is created if necessary
+		 */
+		void flush(Frame& frame)
+		{
+			int pending = lua_gettop(luaState) - frame.base + 1;
+
+			if (frame.table == 0)
+			{
+				if (frame.isObject)
+				{
+					lua_createtable(luaState, 0, pending / 2);
+				}
+				else
+				{
+					lua_createtable(luaState, pending, 0);
+				}
+
+				lua_insert(luaState, frame.base);
+
+				frame.table = frame.base;
+				frame.base = frame.table + 1;
+			}
+
+			if (frame.isObject)
+			{
+				for (int i = 0; i < pending; i += 2)
+				{
+					lua_pushvalue(luaState, frame.base + i);
+					lua_pushvalue(luaState, frame.base + i + 1);
+					lua_rawset(luaState, frame.table);
+				}
+			}
+			else
+			{
+				for (int i = 0; i < pending; ++i)
+				{
+					lua_pushvalue(luaState, frame.base + i);
+					lua_rawseti(luaState, frame.table, ++frame.count);
+				}
+			}
+
+			lua_settop(luaState, frame.table);
+		}
+
+		lua_State* luaState;
+		std::vector<Frame> frames;
+	};
+
+	// Doubles represent all integers up to this value exactly
+	const double MAX_EXACT_INTEGER = 9007199254740992.0;
+
+	class Writer
+	{
+	public:
+		Writer(lua_State* L, std::string& output, const Options& options) : luaState(L), output(output), options(options)
+		{
+		}
+
+		void writeValue(int index, size_t depth)
+		{
+			switch (lua_type(luaState, index))
+			{
+			case LUA_TNIL:
+				output.append("null", 4);
+				break;
+			case LUA_TBOOLEAN:
+				if (lua_toboolean(luaState, index))
+				{
+					output.append("true", 4);
+				}
+				else
+				{
+					output.append("false", 5);
+				}
+				break;
+			case LUA_TNUMBER:
+				writeNumber(lua_tonumber(luaState, index));
+				break;
+			case LUA_TSTRING:
+			{
+				size_t length;
+				const char* string = lua_tolstring(luaState, index, &length);
+
+				writeString(string, length);
+				break;
+			}
+			case LUA_TTABLE:
+				writeTable(index, depth + 1);
+				break;
+			default:
+				throw LuaException(std::string("Values of type ") + lua_typename(luaState, lua_type(luaState, index)) +
+					" can not be converted to JSON!");
+			}
+		}
+
+	private:
+		void writeNumber(double value)
+		{
+			if (!std::isfinite(value))
+			{
+				throw LuaException("Infinite numbers can not be converted to JSON!");
+			}
+
+			char buffer[32];
+			int length;
+
+			if (std::floor(value) == value && std::fabs(value) < MAX_EXACT_INTEGER)
+			{
+				length = std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(value));
+			}
+			else
+			{
+				length = std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+			}
+
+			output.append(buffer, static_cast<size_t>(length));
+		}
+
+		void writeString(const char* string, size_t length)
+		{
+			static const char hexDigits[] = "0123456789abcdef";
+
+			output.push_back('"');
+
+			const char* runStart = string;
+			const char* stringEnd = string + length;
+
+			for (const char* current = string; current != stringEnd; ++current)
+			{
+				unsigned char character = static_cast<unsigned char>(*current);
+
+				if (character >= 0x20 && character != '"' && character != '\\')
+				{
+					continue;
+				}
+
+				// Append the characters which need no escaping in one go
+				output.append(runStart, current);
+				runStart = current + 1;
+
+				switch (character)
+				{
+				case '"': output.append("\\\"", 2); break;
+				case '\\': output.append("\\\\", 2); break;
+				case '\b': output.append("\\b", 2); break;
+				case '\f': output.append("\\f", 2); break;
+				case '\n': output.append("\\n", 2); break;
+				case '\r': output.append("\\r", 2); break;
+				case '\t': output.append("\\t", 2); break;
+				default:
+				{
+					char escaped[6] = { '\\', 'u', '0', '0', hexDigits[character >> 4], hexDigits[character & 0xF] };
+					output.append(escaped, sizeof(escaped));
+					break;
+				}
+				}
+			}
+
+			output.append(runStart, stringEnd);
+			output.push_back('"');
+		}
+
+		/**
+		 * @brief Determines if the table is written as an array and returns its length, -1 for objects
+		 */
+		int getArrayLength(int index)
+		{
+			if (options.arrayDetection == ArrayDetection::LENGTH)
+			{
+				size_t length = lua_objlen(luaState, index);
+
+				return length > 0 ? static_cast<int>(length) : -1;
+			}
+
+			size_t count = 0;
+			lua_Number max = 0;
+
+			lua_pushnil(luaState);
+			while (lua_next(luaState, index) != 0)
+			{
+				lua_pop(luaState, 1);
+
+				lua_Number key = lua_tonumber(luaState, -1);
+
+				if (lua_type(luaState, -1) != LUA_TNUMBER || key < 1 || std::floor(key) != key)
+				{
+					lua_pop(luaState, 1);
+					return -1;
+				}
+
+				++count;
+
+				if (key > max)
+				{
+					max = key;
+				}
+			}
+
+			return count > 0 && static_cast<lua_Number>(count) == max ? static_cast<int>(count) : -1;
+		}
+
+		void writeTable(int index, size_t depth)
+		{
+			if (depth > options.maxDepth)
+			{
+				throw LuaException("The value exceeds the depth limit!");
+			}
+
+			if (!lua_checkstack(luaState, 4))
+			{
+				throw LuaException("Not enough stack space to convert the table!");
+			}
+
+			lua_pushnil(luaState);
+			if (lua_next(luaState, index) == 0)
+			{
+				output.append(options.emptyTableAsArray ? "[]" : "{}", 2);
+				return;
+			}
+			lua_pop(luaState, 2);
+
+			int arrayLength = getArrayLength(index);
+
+			if (arrayLength > 0)
+			{
+				output.push_back('[');
+
+				for (int i = 1; i <= arrayLength; ++i)
+				{
+					if (i > 1)
+					{
+						output.push_back(',');
+					}
+
+					lua_rawgeti(luaState, index, i);
+					writeValue(lua_gettop(luaState), depth);
+					lua_pop(luaState, 1);
+				}
+
+				output.push_back(']');
+				return;
+			}
+
+			output.push_back('{');
+
+			bool first = true;
+
+			lua_pushnil(luaState);
+			while (lua_next(luaState, index) != 0)
+			{
+				if (!first)
+				{
+					output.push_back(',');
+				}
+
+				first = false;
+
+				int top = lua_gettop(luaState);
+
+				writeKey(top - 1);
+				output.push_back(':');
+				writeValue(top, depth);
+
+				lua_pop(luaState, 1);
+			}
+
+			output.push_back('}');
+		}
+
+		void writeKey(int index)
+		{
+			int type = lua_type(luaState, index);
+
+			if (type == LUA_TSTRING)
+			{
+				size_t length;
+				const char* string = lua_tolstring(luaState, index, &length);
+
+				writeString(string, length);
+			}
+			else if (type == LUA_TNUMBER)
+			{
+				// Converting the key with lua_tolstring would confuse lua_next
+				output.push_back('"');
+				writeNumber(lua_tonumber(luaState, index));
+				output.push_back('"');
+			}
+			else
+			{
+				throw LuaException(std::string("Table keys of type ") + lua_typename(luaState, type) +
+					" can not be converted to JSON!");
+			}
+		}
+
+		lua_State* luaState;
+		std::string& output;
+		const Options& options;
+	};
+}
+
+namespace luacpp
+{
+	namespace json
+	{
+		void encode(lua_State* L, int index, std::string& output, const Options& options)
+		{
+			if (index < 0 && index > LUA_REGISTRYINDEX)
+			{
+				index = lua_gettop(L) + index + 1;
+			}
+
+			int top = lua_gettop(L);
+
+			try
+			{
+				Writer writer(L, output, options);
+				writer.writeValue(index, 0);
+			}
+			catch (...)
+			{
+				lua_settop(L, top);
+				throw;
+			}
+		}
+
+		std::string encode(const LuaValue& value, const Options& options)
+		{
+			if (!value.pushValue())
+			{
+				throw LuaException("Value reference is not valid!");
+			}
+
+			lua_State* L = value.luaState;
+			std::string output;
+
+			try
+			{
+				encode(L, -1, output, options);
+			}
+			catch (...)
+			{
+				lua_pop(L, 1);
+				throw;
+			}
+
+			lua_pop(L, 1);
+
+			return output;
+		}
+
+		void push(lua_State* L, const char* text, size_t length, const Options& options)
+		{
+			int top = lua_gettop(L);
+
+			try
+			{
+				TableBuilder builder(L);
+				Parser<TableBuilder> parser(text, length, options.maxDepth, builder);
+
+				parser.parse();
+			}
+			catch (...)
+			{
+				lua_settop(L, top);
+				throw;
+			}
+		}
+
+		LuaValue decode(lua_State* L, const std::string& text, const Options& options)
+		{
+			push(L, text.data(), text.size(), options);
+
+			try
+			{
+				return convert::popValue<LuaValue>(L);
+			}
+			catch (...)
+			{
+				lua_pop(L, 1);
+				throw;
+			}
+		}
+	}
+}
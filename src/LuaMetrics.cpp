@@ -0,0 +1,250 @@
+#include <new>
+
+#include "LuaCpp/LuaMetrics.hpp"
+
+#include "LuaCpp/LuaHeaders.hpp"
+
+namespace
+{
+	// The address is used as the registry key of the metrics registry
+	char registryKey;
+}
+
+namespace luacpp
+{
+	LatencyHistogram::LatencyHistogram()
+	{
+		reset();
+	}
+
+	size_t LatencyHistogram::getBucket(uint64_t value)
+	{
+		if (value < 4)
+		{
+			return static_cast<size_t>(value);
+		}
+
+		int msb = 63;
+		while (!(value & (static_cast<uint64_t>(1) << msb)))
+		{
+			--msb;
+		}
+
+		// The two bits below the most significant one select the sub-bucket
+		size_t sub = static_cast<size_t>((value >> (msb - 2)) & 3);
+
+		return 4 * (msb - 1) + sub;
+	}
+
+	uint64_t LatencyHistogram::getUpperBound(size_t bucket)
+	{
+		if (bucket < 4)
+		{
+			return bucket;
+		}
+
+		int msb = static_cast<int>(bucket / 4) + 1;
+		uint64_t sub = bucket % 4;
+
+		if (msb == 63 && sub == 3)
+		{
+			return static_cast<uint64_t>(-1);
+		}
+
+		return ((4 + sub + 1) << (msb - 2)) - 1;
+	}
+
+	void LatencyHistogram::record(uint64_t nanoseconds)
+	{
+		buckets[getBucket(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	uint64_t LatencyHistogram::getCount() const
+	{
+		uint64_t count = 0;
+
+		for (size_t i = 0; i < NUM_BUCKETS; ++i)
+		{
+			count += buckets[i].load(std::memory_order_relaxed);
+		}
+
+		return count;
+	}
+
+	uint64_t LatencyHistogram::getPercentile(double percentile) const
+	{
+		uint64_t counts[NUM_BUCKETS];
+		uint64_t total = 0;
+
+		// Copy the values first so concurrent updates do not change the result while it is computed
+		for (size_t i = 0; i < NUM_BUCKETS; ++i)
+		{
+			counts[i] = buckets[i].load(std::memory_order_relaxed);
+			total += counts[i];
+		}
+
+		if (total == 0)
+		{
+			return 0;
+		}
+
+		uint64_t rank = static_cast<uint64_t>(percentile * total);
+		if (rank >= total)
+		{
+			rank = total - 1;
+		}
+
+		uint64_t seen = 0;
+		for (size_t i = 0; i < NUM_BUCKETS; ++i)
+		{
+			seen += counts[i];
+
+			if (seen > rank)
+			{
+				return getUpperBound(i);
+			}
+		}
+
+		return getUpperBound(NUM_BUCKETS - 1);
+	}
+
+	void LatencyHistogram::reset()
+	{
+		for (size_t i = 0; i < NUM_BUCKETS; ++i)
+		{
+			buckets[i].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	FunctionMetrics::FunctionMetrics(const std::string& name) : name(name), calls(0), errors(0)
+	{
+	}
+
+	void FunctionMetrics::record(uint64_t nanoseconds, bool failed)
+	{
+		calls.fetch_add(1, std::memory_order_relaxed);
+
+		if (failed)
+		{
+			errors.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		latency.record(nanoseconds);
+	}
+
+	MetricsSnapshot FunctionMetrics::snapshot() const
+	{
+		MetricsSnapshot values;
+
+		values.name = name;
+		values.calls = calls.load(std::memory_order_relaxed);
+		values.errors = errors.load(std::memory_order_relaxed);
+		values.p50 = latency.getPercentile(0.5);
+		values.p99 = latency.getPercentile(0.99);
+		values.p999 = latency.getPercentile(0.999);
+
+		return values;
+	}
+
+	void FunctionMetrics::reset()
+	{
+		calls.store(0, std::memory_order_relaxed);
+		errors.store(0, std::memory_order_relaxed);
+		latency.reset();
+	}
+
+	MetricsRegistry::MetricsRegistry() : instrumentChunks(false)
+	{
+	}
+
+	MetricsRegistry& MetricsRegistry::forState(lua_State* L)
+	{
+		MetricsRegistry* registry = find(L);
+
+		if (registry != nullptr)
+		{
+			return *registry;
+		}
+
+		lua_pushlightuserdata(L, &registryKey);
+
+		// The registry lives in a userdata so it is destroyed together with the state
+		void* memory = lua_newuserdata(L, sizeof(MetricsRegistry));
+		registry = new (memory) MetricsRegistry();
+
+		lua_createtable(L, 0, 1);
+		lua_pushcfunction(L, &MetricsRegistry::collect);
+		lua_setfield(L, -2, "__gc");
+		lua_setmetatable(L, -2);
+
+		lua_rawset(L, LUA_REGISTRYINDEX);
+
+		return *registry;
+	}
+
+	MetricsRegistry* MetricsRegistry::find(lua_State* L)
+	{
+		lua_pushlightuserdata(L, &registryKey);
+		lua_rawget(L, LUA_REGISTRYINDEX);
+
+		MetricsRegistry* registry = static_cast<MetricsRegistry*>(lua_touserdata(L, -1));
+
+		lua_pop(L, 1);
+
+		return registry;
+	}
+
+	int MetricsRegistry::collect(lua_State* L)
+	{
+		static_cast<MetricsRegistry*>(lua_touserdata(L, 1))->~MetricsRegistry();
+
+		return 0;
+	}
+
+	FunctionMetricsPtr MetricsRegistry::get(const std::string& name)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		std::map<std::string, FunctionMetricsPtr>::iterator iter = metrics.find(name);
+
+		if (iter != metrics.end())
+		{
+			return iter->second;
+		}
+
+		FunctionMetricsPtr entry(new FunctionMetrics(name));
+		metrics.insert(std::make_pair(name, entry));
+
+		return entry;
+	}
+
+	std::vector<MetricsSnapshot> MetricsRegistry::snapshot(bool reset)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		std::vector<MetricsSnapshot> values;
+		values.reserve(metrics.size());
+
+		for (std::map<std::string, FunctionMetricsPtr>::iterator iter = metrics.begin(); iter != metrics.end(); ++iter)
+		{
+			values.push_back(iter->second->snapshot());
+
+			if (reset)
+			{
+				iter->second->reset();
+			}
+		}
+
+		return values;
+	}
+
+	void MetricsRegistry::reset()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for (std::map<std::string, FunctionMetricsPtr>::iterator iter = metrics.begin(); iter != metrics.end(); ++iter)
+		{
+			iter->second->reset();
+		}
+	}
+}
@@ -0,0 +1,920 @@
+
+#include <cmath>
+#include <cstring>
+
+#include "LuaCpp/LuaMsgPack.hpp"
+#include "LuaCpp/LuaConvert.hpp"
+
+namespace
+{
+	using namespace luacpp;
+	using namespace luacpp::msgpack;
+
+	enum class Kind
+	{
+		NIL,
+		BOOLEAN,
+		UINT,
+		INT,
+		FLOAT32,
+		FLOAT64,
+		STR,
+		BIN,
+		ARRAY,
+		MAP,
+		EXT
+	};
+
+	/**
+	 * @brief The type byte and the fixed size fields of a value
+	 */
+	struct Header
+	{
+		Kind kind;
+		size_t length; //!< The number of bytes of the header
+		uint64_t value; //!< The number, the bits of a float or the length or element count of the other types
+	};
+
+	enum class HeaderResult
+	{
+		OK,
+		INCOMPLETE,
+		INVALID
+	};
+
+	uint64_t readBigEndian(const char* data, size_t bytes)
+	{
+		uint64_t value = 0;
+
+		for (size_t i = 0; i < bytes; ++i)
+		{
+			value = (value << 8) | static_cast<uint8_t>(data[i]);
+		}
+
+		return value;
+	}
+
+	/**
+	 * @brief Parses the header at @c data, the header is followed by @c value bytes for STR, BIN and EXT
+	 */
+	HeaderResult parseHeader(const char* data, const char* end, Header& header)
+	{
+		if (data == end)
+		{
+			return HeaderResult::INCOMPLETE;
+		}
+
+		uint8_t type = static_cast<uint8_t>(*data);
+		size_t extra = 0; //!< The size of the field after the type byte
+		uint64_t fixed = 0; //!< A value which is part of the type byte
+
+		if (type <= 0x7F)
+		{
+			header.kind = Kind::UINT;
+			fixed = type;
+		}
+		else if (type <= 0x8F)
+		{
+			header.kind = Kind::MAP;
+			fixed = type & 0x0F;
+		}
+		else if (type <= 0x9F)
+		{
+			header.kind = Kind::ARRAY;
+			fixed = type & 0x0F;
+		}
+		else if (type <= 0xBF)
+		{
+			header.kind = Kind::STR;
+			fixed = type & 0x1F;
+		}
+		else if (type >= 0xE0)
+		{
+			header.kind = Kind::INT;
+			fixed = static_cast<uint64_t>(static_cast<int64_t>(static_cast<int8_t>(type)));
+		}
+		else
+		{
+			switch (type)
+			{
+			case 0xC0: header.kind = Kind::NIL; break;
+			case 0xC2: header.kind = Kind::BOOLEAN; fixed = 0; break;
+			case 0xC3: header.kind = Kind::BOOLEAN; fixed = 1; break;
+			case 0xC4: header.kind = Kind::BIN; extra = 1; break;
+			case 0xC5: header.kind = Kind::BIN; extra = 2; break;
+			case 0xC6: header.kind = Kind::BIN; extra = 4; break;
+			case 0xC7: header.kind = Kind::EXT; extra = 1; break;
+			case 0xC8: header.kind = Kind::EXT; extra = 2; break;
+			case 0xC9: header.kind = Kind::EXT; extra = 4; break;
+			case 0xCA: header.kind = Kind::FLOAT32; extra = 4; break;
+			case 0xCB: header.kind = Kind::FLOAT64; extra = 8; break;
+			case 0xCC: header.kind = Kind::UINT; extra = 1; break;
+			case 0xCD: header.kind = Kind::UINT; extra = 2; break;
+			case 0xCE: header.kind = Kind::UINT; extra = 4; break;
+			case 0xCF: header.kind = Kind::UINT; extra = 8; break;
+			case 0xD0: header.kind = Kind::INT; extra = 1; break;
+			case 0xD1: header.kind = Kind::INT; extra = 2; break;
+			case 0xD2: header.kind = Kind::INT; extra = 4; break;
+			case 0xD3: header.kind = Kind::INT; extra = 8; break;
+			case 0xD4: header.kind = Kind::EXT; fixed = 1; break;
+			case 0xD5: header.kind = Kind::EXT; fixed = 2; break;
+			case 0xD6: header.kind = Kind::EXT; fixed = 4; break;
+			case 0xD7: header.kind = Kind::EXT; fixed = 8; break;
+			case 0xD8: header.kind = Kind::EXT; fixed = 16; break;
+			case 0xD9: header.kind = Kind::STR; extra = 1; break;
+			case 0xDA: header.kind = Kind::STR; extra = 2; break;
+			case 0xDB: header.kind = Kind::STR; extra = 4; break;
+			case 0xDC: header.kind = Kind::ARRAY; extra = 2; break;
+			case 0xDD: header.kind = Kind::ARRAY; extra = 4; break;
+			case 0xDE: header.kind = Kind::MAP; extra = 2; break;
+			case 0xDF: header.kind = Kind::MAP; extra = 4; break;
+			default:
+				// 0xC1 is never used
+				return HeaderResult::INVALID;
+			}
+		}
+
+		if (static_cast<size_t>(end - data) < 1 + extra)
+		{
+			return HeaderResult::INCOMPLETE;
+		}
+
+		header.length = 1 + extra;
+		header.value = extra > 0 ? readBigEndian(data + 1, extra) : fixed;
+
+		if (header.kind == Kind::INT && extra > 0 && extra < 8)
+		{
+			// Sign extend the smaller integers
+			unsigned int shift = static_cast<unsigned int>(64 - extra * 8);
+			header.value = static_cast<uint64_t>(static_cast<int64_t>(header.value << shift) >> shift);
+		}
+		else if (header.kind == Kind::EXT)
+		{
+			// The type of the extension is part of the payload
+			header.value += 1;
+		}
+
+		return HeaderResult::OK;
+	}
+
+	/**
+	 * @brief Gets the number of bytes which follow the header
+	 */
+	uint64_t getPayloadLength(const Header& header)
+	{
+		return header.kind == Kind::STR || header.kind == Kind::BIN || header.kind == Kind::EXT ? header.value : 0;
+	}
+
+	/**
+	 * @brief Gets the number of values contained in an array or map
+	 */
+	uint64_t getChildCount(const Header& header)
+	{
+		if (header.kind == Kind::ARRAY)
+		{
+			return header.value;
+		}
+		else if (header.kind == Kind::MAP)
+		{
+			return header.value * 2;
+		}
+
+		return 0;
+	}
+
+	bool isUtf8(const char* string, size_t length)
+	{
+		size_t i = 0;
+
+		while (i < length)
+		{
+			uint8_t lead = static_cast<uint8_t>(string[i]);
+
+			if (lead < 0x80)
+			{
+				++i;
+				continue;
+			}
+
+			size_t continuation;
+			uint32_t codePoint;
+
+			if (lead >= 0xC2 && lead <= 0xDF)
+			{
+				continuation = 1;
+				codePoint = lead & 0x1F;
+			}
+			else if (lead >= 0xE0 && lead <= 0xEF)
+			{
+				continuation = 2;
+				codePoint = lead & 0x0F;
+			}
+			else if (lead >= 0xF0 && lead <= 0xF4)
+			{
+				continuation = 3;
+				codePoint = lead & 0x07;
+			}
+			else
+			{
+				return false;
+			}
+
+			if (length - i - 1 < continuation)
+			{
+				return false;
+			}
+
+			for (size_t k = 1; k <= continuation; ++k)
+			{
+				uint8_t byte = static_cast<uint8_t>(string[i + k]);
+
+				if ((byte & 0xC0) != 0x80)
+				{
+					return false;
+				}
+
+				codePoint = (codePoint << 6) | (byte & 0x3F);
+			}
+
+			// Reject overlong encodings, surrogates and values above the unicode range
+			if ((continuation == 2 && (codePoint < 0x800 || (codePoint >= 0xD800 && codePoint <= 0xDFFF))) ||
+				(continuation == 3 && (codePoint < 0x10000 || codePoint > 0x10FFFF)))
+			{
+				return false;
+			}
+
+			i += continuation + 1;
+		}
+
+		return true;
+	}
+
+	class Writer
+	{
+	public:
+		Writer(lua_State* L, serialize::Sink& sink, const Options& options) :
+			luaState(L), sink(sink), options(options), written(0), used(0)
+		{
+		}
+
+		void write(int index)
+		{
+			writeValue(index, 0);
+			flush();
+		}
+
+	private:
+		// Longer strings are passed to the sink without copying them into the buffer
+		static const size_t ZERO_COPY_LENGTH = 512;
+
+		void flush()
+		{
+			if (used > 0)
+			{
+				sink.write(buffer, used);
+				used = 0;
+			}
+		}
+
+		void reserve(size_t length)
+		{
+			written += length;
+
+			if (written > options.maxSize)
+			{
+				throw LuaException("MessagePack data exceeds the size limit!");
+			}
+
+			if (used + length > sizeof(buffer))
+			{
+				flush();
+			}
+		}
+
+		void writeBytes(const char* data, size_t length)
+		{
+			reserve(length);
+
+			if (length >= ZERO_COPY_LENGTH)
+			{
+				flush();
+				sink.write(data, length);
+			}
+			else
+			{
+				std::memcpy(buffer + used, data, length);
+				used += length;
+			}
+		}
+
+		/**
+		 * @brief Writes a type byte followed by a big endian field with the given number of bytes
+		 */
+		void writeHeader(uint8_t type, uint64_t value, size_t bytes)
+		{
+			reserve(1 + bytes);
+
+			buffer[used++] = static_cast<char>(type);
+
+			for (size_t i = bytes; i > 0; --i)
+			{
+				buffer[used++] = static_cast<char>((value >> ((i - 1) * 8)) & 0xFF);
+			}
+		}
+
+		void writeNumber(lua_Number number)
+		{
+			double value = static_cast<double>(number);
+
+			if (std::floor(value) == value && value >= -9223372036854775808.0 && value < 18446744073709551616.0)
+			{
+				if (value >= 0)
+				{
+					uint64_t integer = static_cast<uint64_t>(value);
+
+					if (integer <= 0x7F)
+					{
+						writeHeader(static_cast<uint8_t>(integer), 0, 0);
+					}
+					else if (integer <= 0xFF)
+					{
+						writeHeader(0xCC, integer, 1);
+					}
+					else if (integer <= 0xFFFF)
+					{
+						writeHeader(0xCD, integer, 2);
+					}
+					else if (integer <= 0xFFFFFFFF)
+					{
+						writeHeader(0xCE, integer, 4);
+					}
+					else
+					{
+						writeHeader(0xCF, integer, 8);
+					}
+				}
+				else
+				{
+					int64_t integer = static_cast<int64_t>(value);
+					uint64_t bits = static_cast<uint64_t>(integer);
+
+					if (integer >= -32)
+					{
+						writeHeader(static_cast<uint8_t>(integer), 0, 0);
+					}
+					else if (integer >= -128)
+					{
+						writeHeader(0xD0, bits, 1);
+					}
+					else if (integer >= -32768)
+					{
+						writeHeader(0xD1, bits, 2);
+					}
+					else if (integer >= -2147483648LL)
+					{
+						writeHeader(0xD2, bits, 4);
+					}
+					else
+					{
+						writeHeader(0xD3, bits, 8);
+					}
+				}
+
+				return;
+			}
+
+			uint64_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+
+			writeHeader(0xCB, bits, 8);
+		}
+
+		void writeString(const char* string, size_t length)
+		{
+			if (length > 0xFFFFFFFF)
+			{
+				throw LuaException("The string is too long for MessagePack!");
+			}
+
+			bool binary = options.strings == StringEncoding::BIN ||
+				(options.strings == StringEncoding::DETECT && !isUtf8(string, length));
+
+			if (binary)
+			{
+				if (length <= 0xFF)
+				{
+					writeHeader(0xC4, length, 1);
+				}
+				else if (length <= 0xFFFF)
+				{
+					writeHeader(0xC5, length, 2);
+				}
+				else
+				{
+					writeHeader(0xC6, length, 4);
+				}
+			}
+			else
+			{
+				if (length < 32)
+				{
+					writeHeader(static_cast<uint8_t>(0xA0 | length), 0, 0);
+				}
+				else if (length <= 0xFF)
+				{
+					writeHeader(0xD9, length, 1);
+				}
+				else if (length <= 0xFFFF)
+				{
+					writeHeader(0xDA, length, 2);
+				}
+				else
+				{
+					writeHeader(0xDB, length, 4);
+				}
+			}
+
+			writeBytes(string, length);
+		}
+
+		void writeContainerHeader(bool isArray, size_t count)
+		{
+			if (count > 0xFFFFFFFF)
+			{
+				throw LuaException("The table is too large for MessagePack!");
+			}
+
+			if (count < 16)
+			{
+				writeHeader(static_cast<uint8_t>((isArray ? 0x90 : 0x80) | count), 0, 0);
+			}
+			else if (count <= 0xFFFF)
+			{
+				writeHeader(isArray ? 0xDC : 0xDE, count, 2);
+			}
+			else
+			{
+				writeHeader(isArray ? 0xDD : 0xDF, count, 4);
+			}
+		}
+
+		void writeValue(int index, size_t depth)
+		{
+			switch (lua_type(luaState, index))
+			{
+			case LUA_TNIL:
+				writeHeader(0xC0, 0, 0);
+				break;
+			case LUA_TBOOLEAN:
+				writeHeader(lua_toboolean(luaState, index) ? 0xC3 : 0xC2, 0, 0);
+				break;
+			case LUA_TNUMBER:
+				writeNumber(lua_tonumber(luaState, index));
+				break;
+			case LUA_TSTRING:
+			{
+				size_t length;
+				const char* string = lua_tolstring(luaState, index, &length);
+
+				writeString(string, length);
+				break;
+			}
+			case LUA_TTABLE:
+				writeTable(index, depth + 1);
+				break;
+			default:
+				throw LuaException(std::string("Values of type ") + lua_typename(luaState, lua_type(luaState, index)) +
+					" can not be converted to MessagePack!");
+			}
+		}
+
+		void writeTable(int index, size_t depth)
+		{
+			if (depth > options.maxDepth)
+			{
+				throw LuaException("The value exceeds the depth limit!");
+			}
+
+			if (!lua_checkstack(luaState, 4))
+			{
+				throw LuaException("Not enough stack space to convert the table!");
+			}
+
+			// Count the pairs and check if the keys are 1 to n
+			size_t count = 0;
+			lua_Number max = 0;
+			bool isArray = true;
+
+			lua_pushnil(luaState);
+			while (lua_next(luaState, index) != 0)
+			{
+				lua_pop(luaState, 1);
+
+				++count;
+
+				if (isArray)
+				{
+					lua_Number key = lua_tonumber(luaState, -1);
+
+					if (lua_type(luaState, -1) != LUA_TNUMBER || key < 1 || std::floor(key) != key)
+					{
+						isArray = false;
+					}
+					else if (key > max)
+					{
+						max = key;
+					}
+				}
+			}
+
+			if (count == 0)
+			{
+				isArray = options.emptyTableAsArray;
+			}
+			else
+			{
+				isArray = isArray && static_cast<lua_Number>(count) == max;
+			}
+
+			writeContainerHeader(isArray, count);
+
+			if (isArray)
+			{
+				for (size_t i = 1; i <= count; ++i)
+				{
+					lua_rawgeti(luaState, index, static_cast<int>(i));
+					writeValue(lua_gettop(luaState), depth);
+					lua_pop(luaState, 1);
+				}
+
+				return;
+			}
+
+			lua_pushnil(luaState);
+			while (lua_next(luaState, index) != 0)
+			{
+				int top = lua_gettop(luaState);
+
+				writeValue(top - 1, depth);
+				writeValue(top, depth);
+
+				lua_pop(luaState, 1);
+			}
+		}
+
+		lua_State* luaState;
+		serialize::Sink& sink;
+		const Options& options;
+
+		size_t written;
+		size_t used;
+		char buffer[4096];
+	};
+
+	class Reader
+	{
+	public:
+		Reader(lua_State* L, const char* data, size_t length, const Options& options) :
+			luaState(L), position(data), end(data + length), options(options)
+		{
+		}
+
+		void read()
+		{
+			decodeValue(0);
+
+			if (position != end)
+			{
+				fail("Unexpected data after the value!");
+			}
+		}
+
+	private:
+		void fail(const char* message)
+		{
+			throw LuaException(std::string("Invalid MessagePack data: ") + message);
+		}
+
+		size_t remaining() const
+		{
+			return static_cast<size_t>(end - position);
+		}
+
+		void decodeValue(size_t depth)
+		{
+			Header header;
+
+			switch (parseHeader(position, end, header))
+			{
+			case HeaderResult::INCOMPLETE:
+				fail("Unexpected end of data!");
+				break;
+			case HeaderResult::INVALID:
+				fail("Unknown type!");
+				break;
+			case HeaderResult::OK:
+				break;
+			}
+
+			position += header.length;
+
+			if (!lua_checkstack(luaState, 3))
+			{
+				throw LuaException("Not enough stack space to read the MessagePack data!");
+			}
+
+			switch (header.kind)
+			{
+			case Kind::NIL:
+				lua_pushnil(luaState);
+				break;
+			case Kind::BOOLEAN:
+				lua_pushboolean(luaState, header.value != 0);
+				break;
+			case Kind::UINT:
+				lua_pushnumber(luaState, static_cast<lua_Number>(header.value));
+				break;
+			case Kind::INT:
+				lua_pushnumber(luaState, static_cast<lua_Number>(static_cast<int64_t>(header.value)));
+				break;
+			case Kind::FLOAT32:
+			{
+				uint32_t bits = static_cast<uint32_t>(header.value);
+				float value;
+				std::memcpy(&value, &bits, sizeof(value));
+
+				lua_pushnumber(luaState, static_cast<lua_Number>(value));
+				break;
+			}
+			case Kind::FLOAT64:
+			{
+				double value;
+				std::memcpy(&value, &header.value, sizeof(value));
+
+				lua_pushnumber(luaState, static_cast<lua_Number>(value));
+				break;
+			}
+			case Kind::STR:
+			case Kind::BIN:
+				if (header.value > remaining())
+				{
+					fail("Unexpected end of data!");
+				}
+
+				lua_pushlstring(luaState, position, static_cast<size_t>(header.value));
+				position += header.value;
+				break;
+			case Kind::ARRAY:
+				decodeArray(static_cast<size_t>(header.value), depth + 1);
+				break;
+			case Kind::MAP:
+				decodeMap(static_cast<size_t>(header.value), depth + 1);
+				break;
+			case Kind::EXT:
+				fail("Extension types are not supported!");
+				break;
+			}
+		}
+
+		void checkContainer(uint64_t values, size_t depth)
+		{
+			if (depth > options.maxDepth)
+			{
+				throw LuaException("MessagePack data exceeds the depth limit!");
+			}
+
+			// Every value needs at least one byte, this prevents creating huge tables for small inputs
+			if (values > remaining())
+			{
+				fail("Element count exceeds the remaining data!");
+			}
+		}
+
+		void decodeArray(size_t count, size_t depth)
+		{
+			checkContainer(count, depth);
+
+			lua_createtable(luaState, static_cast<int>(count), 0);
+
+			for (size_t i = 1; i <= count; ++i)
+			{
+				decodeValue(depth);
+				lua_rawseti(luaState, -2, static_cast<int>(i));
+			}
+		}
+
+		void decodeMap(size_t count, size_t depth)
+		{
+			checkContainer(static_cast<uint64_t>(count) * 2, depth);
+
+			lua_createtable(luaState, 0, static_cast<int>(count));
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				decodeValue(depth);
+
+				if (lua_isnil(luaState, -1) ||
+					(lua_type(luaState, -1) == LUA_TNUMBER && lua_tonumber(luaState, -1) != lua_tonumber(luaState, -1)))
+				{
+					fail("Invalid map key!");
+				}
+
+				decodeValue(depth);
+				lua_rawset(luaState, -3);
+			}
+		}
+
+		lua_State* luaState;
+		const char* position;
+		const char* end;
+		const Options& options;
+	};
+}
+
+namespace luacpp
+{
+	namespace msgpack
+	{
+		void encode(lua_State* L, int index, serialize::Sink& sink, const Options& options)
+		{
+			if (index < 0 && index > LUA_REGISTRYINDEX)
+			{
+				index = lua_gettop(L) + index + 1;
+			}
+
+			int top = lua_gettop(L);
+
+			try
+			{
+				Writer writer(L, sink, options);
+				writer.write(index);
+			}
+			catch (...)
+			{
+				lua_settop(L, top);
+				throw;
+			}
+		}
+
+		std::string encode(const LuaValue& value, const Options& options)
+		{
+			if (!value.pushValue())
+			{
+				throw LuaException("Value reference is not valid!");
+			}
+
+			lua_State* L = value.luaState;
+
+			std::string data;
+			serialize::StringSink sink(data);
+
+			try
+			{
+				encode(L, -1, sink, options);
+			}
+			catch (...)
+			{
+				lua_pop(L, 1);
+				throw;
+			}
+
+			lua_pop(L, 1);
+
+			return data;
+		}
+
+		void push(lua_State* L, const char* data, size_t length, const Options& options)
+		{
+			if (length > options.maxSize)
+			{
+				throw LuaException("MessagePack data exceeds the size limit!");
+			}
+
+			int top = lua_gettop(L);
+
+			try
+			{
+				Reader reader(L, data, length, options);
+				reader.read();
+			}
+			catch (...)
+			{
+				lua_settop(L, top);
+				throw;
+			}
+		}
+
+		LuaValue decode(lua_State* L, const std::string& data, const Options& options)
+		{
+			push(L, data.data(), data.size(), options);
+
+			try
+			{
+				return convert::popValue<LuaValue>(L);
+			}
+			catch (...)
+			{
+				lua_pop(L, 1);
+				throw;
+			}
+		}
+
+		StreamDecoder::StreamDecoder(const Options& options) : options(options), readPosition(0), scanPosition(0)
+		{
+		}
+
+		void StreamDecoder::feed(const char* data, size_t length)
+		{
+			buffer.append(data, length);
+		}
+
+		bool StreamDecoder::next(lua_State* L)
+		{
+			if (remaining.empty())
+			{
+				// Start a new value
+				remaining.push_back(1);
+			}
+
+			const char* data = buffer.data();
+			const char* end = data + buffer.size();
+
+			// Check that the value is complete without converting anything
+			while (!remaining.empty())
+			{
+				Header header;
+
+				switch (parseHeader(data + scanPosition, end, header))
+				{
+				case HeaderResult::INCOMPLETE:
+					return false;
+				case HeaderResult::INVALID:
+					throw LuaException("Invalid MessagePack data: Unknown type!");
+				case HeaderResult::OK:
+					break;
+				}
+
+				uint64_t payload = getPayloadLength(header);
+
+				if (static_cast<uint64_t>(end - data - scanPosition) - header.length < payload)
+				{
+					return false;
+				}
+
+				scanPosition += header.length + static_cast<size_t>(payload);
+
+				if (scanPosition - readPosition > options.maxSize)
+				{
+					throw LuaException("MessagePack data exceeds the size limit!");
+				}
+
+				--remaining.back();
+
+				uint64_t children = getChildCount(header);
+
+				if (children > 0)
+				{
+					if (remaining.size() > options.maxDepth)
+					{
+						throw LuaException("MessagePack data exceeds the depth limit!");
+					}
+
+					remaining.push_back(children);
+				}
+
+				while (!remaining.empty() && remaining.back() == 0)
+				{
+					remaining.pop_back();
+				}
+			}
+
+			push(L, data + readPosition, scanPosition - readPosition, options);
+
+			readPosition = scanPosition;
+
+			// Drop the consumed data once it makes up most of the buffer
+			if (readPosition == buffer.size())
+			{
+				buffer.clear();
+				readPosition = 0;
+				scanPosition = 0;
+			}
+			else if (readPosition > 4096 && readPosition > buffer.size() / 2)
+			{
+				buffer.erase(0, readPosition);
+				scanPosition -= readPosition;
+				readPosition = 0;
+			}
+
+			return true;
+		}
+
+		void StreamDecoder::reset()
+		{
+			buffer.clear();
+			readPosition = 0;
+			scanPosition = 0;
+			remaining.clear();
+		}
+	}
+}
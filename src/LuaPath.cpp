@@ -0,0 +1,205 @@
+
+#include <cctype>
+#include <cstdint>
+
+#include "LuaCpp/LuaPath.hpp"
+
+namespace
+{
+	bool isNumber(const std::string& segment)
+	{
+		for (std::string::const_iterator iter = segment.begin(); iter != segment.end(); ++iter)
+		{
+			if (!std::isdigit(static_cast<unsigned char>(*iter)))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	 * @brief Parses a segment which only consists of digits, larger numbers than 2^53 are not exact as a double
+	 */
+	lua_Number parseNumber(const std::string& path, const std::string& segment)
+	{
+		const uint64_t maxExact = static_cast<uint64_t>(1) << 53;
+
+		uint64_t value = 0;
+
+		for (std::string::const_iterator iter = segment.begin(); iter != segment.end(); ++iter)
+		{
+			value = value * 10 + static_cast<uint64_t>(*iter - '0');
+
+			if (value > maxExact)
+			{
+				throw luacpp::LuaException("Path \"" + path + "\" contains a number key which is too large!");
+			}
+		}
+
+		return static_cast<lua_Number>(value);
+	}
+}
+
+namespace luacpp
+{
+	LuaPath LuaPath::create(lua_State* L, const std::string& path)
+	{
+		LuaPath luaPath;
+		luaPath.luaState = L;
+		luaPath.path = path;
+
+		lua_newtable(L);
+
+		try
+		{
+			std::string::size_type start = 0;
+
+			while (true)
+			{
+				std::string::size_type end = path.find('.', start);
+
+				if (end == std::string::npos)
+				{
+					end = path.size();
+				}
+
+				std::string segment = path.substr(start, end - start);
+
+				if (segment.empty())
+				{
+					throw LuaException("Path \"" + path + "\" contains an empty key!");
+				}
+
+				if (isNumber(segment))
+				{
+					lua_pushnumber(L, parseNumber(path, segment));
+				}
+				else
+				{
+					lua_pushlstring(L, segment.c_str(), segment.size());
+				}
+
+				lua_rawseti(L, -2, static_cast<int>(++luaPath.length));
+
+				if (end == path.size())
+				{
+					break;
+				}
+
+				start = end + 1;
+			}
+
+			luaPath.keys.setReference(LuaReference::create(L));
+		}
+		catch (...)
+		{
+			lua_pop(L, 1);
+			throw;
+		}
+
+		lua_pop(L, 1);
+
+		return luaPath;
+	}
+
+	LuaPath::LuaPath() : luaState(nullptr), length(0)
+	{
+	}
+
+	int LuaPath::toAbsolute(int index) const
+	{
+		if (index < 0 && index > LUA_REGISTRYINDEX)
+		{
+			return lua_gettop(luaState) + index + 1;
+		}
+
+		return index;
+	}
+
+	bool LuaPath::pushValue(int root) const
+	{
+		root = toAbsolute(root);
+
+		keys.pushValue();
+		int keysIndex = lua_gettop(luaState);
+
+		lua_pushvalue(luaState, root);
+
+		for (int i = 1; i <= static_cast<int>(length); ++i)
+		{
+			if (!lua_istable(luaState, -1))
+			{
+				lua_pop(luaState, 2);
+				lua_pushnil(luaState);
+
+				return false;
+			}
+
+			lua_rawgeti(luaState, keysIndex, i);
+			lua_gettable(luaState, -2);
+
+			// Remove the parent table
+			lua_remove(luaState, -2);
+		}
+
+		lua_remove(luaState, keysIndex);
+
+		return true;
+	}
+
+	bool LuaPath::pushValue(const LuaTable& root) const
+	{
+		if (!root.pushValue())
+		{
+			throw LuaException("Table reference is not valid!");
+		}
+
+		bool ret = pushValue(-1);
+
+		// Remove the root table
+		lua_remove(luaState, -2);
+
+		return ret;
+	}
+
+	void LuaPath::pushParent(int root) const
+	{
+		root = toAbsolute(root);
+
+		keys.pushValue();
+		int keysIndex = lua_gettop(luaState);
+
+		lua_pushvalue(luaState, root);
+
+		for (int i = 1; i < static_cast<int>(length); ++i)
+		{
+			if (!lua_istable(luaState, -1))
+			{
+				throw LuaException("A value on the way to " + path + " is not a table!");
+			}
+
+			lua_rawgeti(luaState, keysIndex, i);
+			lua_gettable(luaState, -2);
+
+			if (lua_isnil(luaState, -1))
+			{
+				lua_pop(luaState, 1);
+
+				// Create the missing table and store it in the parent
+				lua_newtable(luaState);
+				lua_rawgeti(luaState, keysIndex, i);
+				lua_pushvalue(luaState, -2);
+				lua_settable(luaState, -4);
+			}
+
+			lua_remove(luaState, -2);
+		}
+
+		if (!lua_istable(luaState, -1))
+		{
+			throw LuaException("A value on the way to " + path + " is not a table!");
+		}
+	}
+}
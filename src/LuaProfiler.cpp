@@ -0,0 +1,325 @@
+#include <cstring>
+
+#include "LuaCpp/LuaProfiler.hpp"
+#include "LuaCpp/LuaException.hpp"
+
+#include "LuaCpp/LuaHeaders.hpp"
+
+namespace
+{
+	// The address is used as the registry key of the running profiler
+	char profilerKey;
+
+	luacpp::LuaProfiler* getProfiler(lua_State* L)
+	{
+		lua_pushlightuserdata(L, &profilerKey);
+		lua_rawget(L, LUA_REGISTRYINDEX);
+
+		luacpp::LuaProfiler* profiler = static_cast<luacpp::LuaProfiler*>(lua_touserdata(L, -1));
+
+		lua_pop(L, 1);
+
+		return profiler;
+	}
+
+	void setProfiler(lua_State* L, luacpp::LuaProfiler* profiler)
+	{
+		lua_pushlightuserdata(L, &profilerKey);
+
+		if (profiler == nullptr)
+		{
+			lua_pushnil(L);
+		}
+		else
+		{
+			lua_pushlightuserdata(L, profiler);
+		}
+
+		lua_rawset(L, LUA_REGISTRYINDEX);
+	}
+
+	std::string getFrameName(lua_Debug* ar)
+	{
+		std::string name;
+
+		if (std::strcmp(ar->what, "main") == 0)
+		{
+			name = std::string("main chunk (") + ar->short_src + ")";
+		}
+		else if (std::strcmp(ar->what, "C") == 0)
+		{
+			name = std::string(ar->name != nullptr ? ar->name : "?") + " [C]";
+		}
+		else if (std::strcmp(ar->what, "tail") == 0)
+		{
+			name = "(tail call)";
+		}
+		else
+		{
+			name = std::string(ar->name != nullptr ? ar->name : "anonymous") + " (" + ar->short_src + ":" +
+				std::to_string(ar->linedefined) + ")";
+		}
+
+		// The separator of the folded format may not appear inside a frame
+		for (std::string::iterator iter = name.begin(); iter != name.end(); ++iter)
+		{
+			if (*iter == ';')
+			{
+				*iter = ':';
+			}
+		}
+
+		return name;
+	}
+}
+
+namespace luacpp
+{
+	size_t LuaProfiler::StackHash::operator()(const std::vector<uint32_t>& stack) const
+	{
+		// FNV-1a
+		size_t hash = 2166136261u;
+
+		for (std::vector<uint32_t>::const_iterator iter = stack.begin(); iter != stack.end(); ++iter)
+		{
+			hash = (hash ^ *iter) * 16777619u;
+		}
+
+		return hash;
+	}
+
+	LuaProfiler::LuaProfiler(size_t maxStacks, int maxDepth) : maxStacks(maxStacks), maxDepth(maxDepth),
+		luaState(nullptr), interval(0), pending(0), previousHook(nullptr), previousMask(0), previousCount(0),
+		functionsRef(LUA_NOREF), otherFrame(static_cast<uint32_t>(-1)), samples(0), dropped(0)
+	{
+		currentStack.reserve(maxDepth);
+	}
+
+	LuaProfiler::~LuaProfiler()
+	{
+		stop();
+	}
+
+	void LuaProfiler::start(lua_State* L, int interval)
+	{
+		if (isRunning())
+		{
+			throw LuaException("The profiler is already running!");
+		}
+
+		if (interval <= 0)
+		{
+			throw LuaException("The sample interval must be positive!");
+		}
+
+		if (getProfiler(L) != nullptr)
+		{
+			throw LuaException("Another profiler is already running on this state!");
+		}
+
+		previousHook = lua_gethook(L);
+		previousMask = lua_gethookmask(L);
+		previousCount = lua_gethookcount(L);
+
+		luaState = L;
+		this->interval = interval;
+		pending = 0;
+
+		setProfiler(L, this);
+
+		lua_newtable(L);
+		functionsRef = luaL_ref(L, LUA_REGISTRYINDEX);
+
+		int mask = LUA_MASKCOUNT;
+		int count = interval;
+
+		if (previousHook != nullptr)
+		{
+			// The previous hook still receives its events through our hook
+			mask |= previousMask;
+
+			if ((previousMask & LUA_MASKCOUNT) && previousCount < count)
+			{
+				count = previousCount;
+			}
+		}
+
+		lua_sethook(L, &LuaProfiler::hook, mask, count);
+	}
+
+	void LuaProfiler::stop()
+	{
+		if (!isRunning())
+		{
+			return;
+		}
+
+		lua_sethook(luaState, previousHook, previousMask, previousCount);
+		setProfiler(luaState, nullptr);
+
+		// The addresses of the functions may be reused once they are released, later runs find their frames by name
+		luaL_unref(luaState, LUA_REGISTRYINDEX, functionsRef);
+		functionsRef = LUA_NOREF;
+		frameIds.clear();
+
+		luaState = nullptr;
+	}
+
+	void LuaProfiler::writeFolded(std::ostream& out) const
+	{
+		typedef std::unordered_map<std::vector<uint32_t>, uint64_t, StackHash>::const_iterator StackIterator;
+
+		for (StackIterator iter = stacks.begin(); iter != stacks.end(); ++iter)
+		{
+			const std::vector<uint32_t>& stack = iter->first;
+
+			// The stack is stored with the innermost frame first
+			for (size_t i = stack.size(); i > 0; --i)
+			{
+				out << frameNames[stack[i - 1]];
+
+				if (i > 1)
+				{
+					out << ';';
+				}
+			}
+
+			out << ' ' << iter->second << '\n';
+		}
+	}
+
+	void LuaProfiler::clear()
+	{
+		frameIds.clear();
+		frameNames.clear();
+		nameIds.clear();
+		otherFrame = static_cast<uint32_t>(-1);
+		stacks.clear();
+
+		samples = 0;
+		dropped = 0;
+	}
+
+	void LuaProfiler::hook(lua_State* L, lua_Debug* ar)
+	{
+		LuaProfiler* profiler = getProfiler(L);
+
+		if (profiler == nullptr)
+		{
+			return;
+		}
+
+		if (ar->event == LUA_HOOKCOUNT)
+		{
+			// The hook may run more often than the interval if a previous hook needs that
+			profiler->pending += lua_gethookcount(L);
+
+			if (profiler->pending >= profiler->interval)
+			{
+				profiler->pending = 0;
+				profiler->sample(L);
+			}
+		}
+
+		lua_Hook previous = profiler->previousHook;
+
+		if (previous != nullptr && (ar->event != LUA_HOOKCOUNT || (profiler->previousMask & LUA_MASKCOUNT)))
+		{
+			// This has to be the last action as the previous hook may raise an error
+			previous(L, ar);
+		}
+	}
+
+	void LuaProfiler::sample(lua_State* L)
+	{
+		currentStack.clear();
+
+		lua_Debug frame;
+		for (int level = 0; level < maxDepth && lua_getstack(L, level, &frame); ++level)
+		{
+			currentStack.push_back(internFrame(L, &frame));
+		}
+
+		if (currentStack.empty())
+		{
+			return;
+		}
+
+		std::unordered_map<std::vector<uint32_t>, uint64_t, StackHash>::iterator iter = stacks.find(currentStack);
+
+		if (iter != stacks.end())
+		{
+			++iter->second;
+			++samples;
+		}
+		else if (stacks.size() < maxStacks)
+		{
+			stacks.insert(std::make_pair(currentStack, 1));
+			++samples;
+		}
+		else
+		{
+			++dropped;
+		}
+	}
+
+	uint32_t LuaProfiler::internFrame(lua_State* L, lua_Debug* ar)
+	{
+		// Frames are identified by the function object, chunks with the same name may have functions on the same
+		// line. Functions with the same name share the id so closures and later runs end up in the same frame.
+		lua_getinfo(L, "f", ar);
+		const void* function = lua_topointer(L, -1);
+
+		std::unordered_map<const void*, uint32_t>::iterator iter = frameIds.find(function);
+
+		if (iter != frameIds.end())
+		{
+			lua_pop(L, 1);
+			return iter->second;
+		}
+
+		lua_getinfo(L, "Sn", ar);
+		std::string name = getFrameName(ar);
+
+		uint32_t id;
+		std::unordered_map<std::string, uint32_t>::iterator nameIter = nameIds.find(name);
+
+		if (nameIter != nameIds.end())
+		{
+			id = nameIter->second;
+		}
+		else if (frameNames.size() >= maxStacks)
+		{
+			lua_pop(L, 1);
+
+			if (otherFrame == static_cast<uint32_t>(-1))
+			{
+				otherFrame = static_cast<uint32_t>(frameNames.size());
+				frameNames.push_back("(other)");
+			}
+
+			return otherFrame;
+		}
+		else
+		{
+			id = static_cast<uint32_t>(frameNames.size());
+			frameNames.push_back(name);
+			nameIds.insert(std::make_pair(name, id));
+		}
+
+		if (!lua_isnil(L, -1))
+		{
+			// Keep the function alive so its address is not reused while the profiler is running
+			lua_rawgeti(L, LUA_REGISTRYINDEX, functionsRef);
+			lua_pushvalue(L, -2);
+			lua_pushboolean(L, 1);
+			lua_rawset(L, -3);
+			lua_pop(L, 1);
+		}
+		lua_pop(L, 1);
+
+		frameIds.insert(std::make_pair(function, id));
+
+		return id;
+	}
+}
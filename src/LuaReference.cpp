@@ -35,7 +35,7 @@ namespace luacpp
 			throw LuaException("Need a valid lua state!");
 		}
 
-		if (reference < 0)
+		if (reference < 0 && reference != LUA_REFNIL)
 		{
 			throw LuaException("Reference must be greater than or equal to zero!");
 		}
@@ -50,8 +50,9 @@ namespace luacpp
 	{
 		if (this->isValid())
 		{
+			// luaL_unref ignores LUA_REFNIL
 			luaL_unref(luaState, LUA_REGISTRYINDEX, mReference);
-			mReference = -1;
+			mReference = LUA_NOREF;
 			return true;
 		}
 		else
@@ -72,7 +73,7 @@ namespace luacpp
 			return false;
 		}
 
-		if (mReference < 0)
+		if (mReference < 0 && mReference != LUA_REFNIL)
 		{
 			return false;
 		}
@@ -82,7 +83,11 @@ namespace luacpp
 
 	void LuaReference::pushValue() const
 	{
-		if (this->isValid())
+		if (mReference == LUA_REFNIL)
+		{
+			lua_pushnil(luaState);
+		}
+		else if (this->isValid())
 		{
 			lua_rawgeti(luaState, LUA_REGISTRYINDEX, this->getReference());
 		}
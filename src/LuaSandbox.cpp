@@ -0,0 +1,216 @@
+#include <map>
+
+#include "LuaCpp/LuaSandbox.hpp"
+#include "LuaCpp/LuaException.hpp"
+
+#include "LuaCpp/LuaHeaders.hpp"
+
+namespace
+{
+	int readOnlyError(lua_State* L)
+	{
+		return luaL_error(L, "attempt to modify a read-only table");
+	}
+
+	/**
+	 * @brief Replaces the table on top of the stack with a read-only proxy of it.
+	 * The proxy is a userdata so raw accesses like @c rawset or @c table.insert can not modify it.
+	 */
+	void makeProxy(lua_State* L)
+	{
+		int target = lua_gettop(L);
+
+		lua_newuserdata(L, 0);
+
+		lua_createtable(L, 0, 3);
+
+		lua_pushvalue(L, target);
+		lua_setfield(L, -2, "__index");
+
+		lua_pushcfunction(L, &readOnlyError);
+		lua_setfield(L, -2, "__newindex");
+
+		lua_pushboolean(L, 0);
+		lua_setfield(L, -2, "__metatable");
+
+		lua_setmetatable(L, -2);
+
+		lua_replace(L, target);
+	}
+}
+
+namespace luacpp
+{
+	const std::vector<std::string>& LuaSandbox::getDefaultWhitelist()
+	{
+		static const std::vector<std::string> whitelist = {
+			"assert", "error", "ipairs", "next", "pairs", "pcall", "select", "tonumber", "tostring", "type",
+			"unpack", "xpcall",
+			"string", "table", "math", "coroutine",
+			"os.clock", "os.date", "os.difftime", "os.time"
+		};
+
+		return whitelist;
+	}
+
+	LuaSandbox::LuaSandbox(lua_State* L, const std::vector<std::string>& whitelist, size_t maxTenants) :
+		luaState(L), maxTenants(maxTenants)
+	{
+		if (maxTenants == 0)
+		{
+			throw LuaException("The sandbox needs space for at least one tenant!");
+		}
+
+		lua_createtable(L, 0, static_cast<int>(whitelist.size()));
+		int baseIndex = lua_gettop(L);
+
+		// Fields of tables which are only partially whitelisted, grouped by the table name
+		std::map<std::string, std::vector<std::string>> fields;
+
+		for (std::vector<std::string>::const_iterator iter = whitelist.begin(); iter != whitelist.end(); ++iter)
+		{
+			std::string::size_type dot = iter->find('.');
+
+			if (dot != std::string::npos)
+			{
+				fields[iter->substr(0, dot)].push_back(iter->substr(dot + 1));
+				continue;
+			}
+
+			lua_getglobal(L, iter->c_str());
+
+			if (lua_istable(L, -1))
+			{
+				makeProxy(L);
+			}
+
+			lua_setfield(L, baseIndex, iter->c_str());
+		}
+
+		for (std::map<std::string, std::vector<std::string>>::iterator iter = fields.begin(); iter != fields.end(); ++iter)
+		{
+			lua_getfield(L, baseIndex, iter->first.c_str());
+			bool whitelisted = !lua_isnil(L, -1);
+			lua_pop(L, 1);
+
+			if (whitelisted)
+			{
+				// The whole table is already available
+				continue;
+			}
+
+			lua_getglobal(L, iter->first.c_str());
+
+			if (!lua_istable(L, -1))
+			{
+				lua_pop(L, 1);
+				continue;
+			}
+
+			int source = lua_gettop(L);
+
+			lua_createtable(L, 0, static_cast<int>(iter->second.size()));
+
+			for (std::vector<std::string>::iterator field = iter->second.begin(); field != iter->second.end(); ++field)
+			{
+				lua_getfield(L, source, field->c_str());
+				lua_setfield(L, -2, field->c_str());
+			}
+
+			makeProxy(L);
+
+			lua_setfield(L, baseIndex, iter->first.c_str());
+
+			lua_pop(L, 1);
+		}
+
+		base.setReference(LuaReference::create(L));
+
+		lua_createtable(L, 0, 2);
+
+		lua_pushvalue(L, baseIndex);
+		lua_setfield(L, -2, "__index");
+
+		// Scripts may not get the metatable and through it the base environment
+		lua_pushboolean(L, 0);
+		lua_setfield(L, -2, "__metatable");
+
+		environmentMetatable.setReference(LuaReference::create(L));
+
+		lua_pop(L, 2);
+	}
+
+	LuaTable LuaSandbox::createEnvironment()
+	{
+		LuaTable environment = LuaTable::create(luaState);
+		environment.setMetatable(environmentMetatable);
+
+		return environment;
+	}
+
+	LuaTable LuaSandbox::getEnvironment(const std::string& tenantId)
+	{
+		std::unordered_map<std::string, Tenant>::iterator iter = tenants.find(tenantId);
+
+		if (iter != tenants.end())
+		{
+			usage.splice(usage.begin(), usage, iter->second.position);
+
+			return iter->second.environment;
+		}
+
+		if (tenants.size() >= maxTenants)
+		{
+			tenants.erase(usage.back());
+			usage.pop_back();
+		}
+
+		usage.push_front(tenantId);
+
+		Tenant tenant;
+		tenant.environment = createEnvironment();
+		tenant.position = usage.begin();
+
+		tenants.insert(std::make_pair(tenantId, tenant));
+
+		return tenant.environment;
+	}
+
+	LuaFunction LuaSandbox::load(const std::string& tenantId, const std::string& code, const std::string& name)
+	{
+		LuaFunction func = LuaFunction::createFromCode(luaState, code, name);
+
+		func.setEnvironment(getEnvironment(tenantId));
+
+		return func;
+	}
+
+	bool LuaSandbox::reset(const std::string& tenantId)
+	{
+		std::unordered_map<std::string, Tenant>::iterator iter = tenants.find(tenantId);
+
+		if (iter == tenants.end())
+		{
+			return false;
+		}
+
+		iter->second.environment = createEnvironment();
+
+		return true;
+	}
+
+	bool LuaSandbox::evict(const std::string& tenantId)
+	{
+		std::unordered_map<std::string, Tenant>::iterator iter = tenants.find(tenantId);
+
+		if (iter == tenants.end())
+		{
+			return false;
+		}
+
+		usage.erase(iter->second.position);
+		tenants.erase(iter);
+
+		return true;
+	}
+}
@@ -0,0 +1,337 @@
+#include <algorithm>
+
+#include "LuaCpp/LuaScheduler.hpp"
+#include "LuaCpp/LuaException.hpp"
+
+#include "LuaCpp/LuaHeaders.hpp"
+
+namespace
+{
+	const uint32_t NO_SLOT = static_cast<uint32_t>(-1);
+}
+
+namespace luacpp
+{
+	LuaScheduler::LuaScheduler(lua_State* L) : luaState(L), activeTasks(0), currentSlot(NO_SLOT)
+	{
+		if (L == nullptr)
+		{
+			throw LuaException("Need a valid lua state!");
+		}
+
+		threads = LuaTable::create(L);
+	}
+
+	LuaScheduler::TaskId LuaScheduler::spawn(const LuaFunction& function, const LuaValueList& args)
+	{
+		uint32_t slot;
+
+		if (freeSlots.empty())
+		{
+			slot = static_cast<uint32_t>(tasks.size());
+
+			Task task;
+			task.thread = nullptr;
+			task.generation = 0;
+			task.state = TaskState::FREE;
+			task.numArgs = 0;
+
+			tasks.push_back(task);
+		}
+		else
+		{
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+		}
+
+		Task& task = tasks[slot];
+
+		if (task.thread == nullptr)
+		{
+			threads.pushValue();
+
+			task.thread = lua_newthread(luaState);
+			lua_rawseti(luaState, -2, static_cast<int>(slot + 1));
+
+			lua_pop(luaState, 1);
+		}
+
+		// Generation 0 is never used so no id is 0
+		if (++task.generation == 0)
+		{
+			task.generation = 1;
+		}
+
+		function.pushValue();
+		for (LuaValueList::const_iterator iter = args.begin(); iter != args.end(); ++iter)
+		{
+			iter->pushValue();
+		}
+		lua_xmove(luaState, task.thread, static_cast<int>(args.size()) + 1);
+
+		task.numArgs = static_cast<int>(args.size());
+
+		++activeTasks;
+		makeReady(slot, Clock::now());
+
+		return makeId(slot, task.generation);
+	}
+
+	void LuaScheduler::registerFunctions(LuaTable& table)
+	{
+		table.pushValue();
+
+		lua_pushlightuserdata(luaState, this);
+		lua_pushcclosure(luaState, &LuaScheduler::sleepFunction, 1);
+		lua_setfield(luaState, -2, "sleep");
+
+		lua_pushlightuserdata(luaState, this);
+		lua_pushcclosure(luaState, &LuaScheduler::yieldFunction, 1);
+		lua_setfield(luaState, -2, "yield");
+
+		lua_pop(luaState, 1);
+	}
+
+	LuaScheduler::TaskId LuaScheduler::suspend(lua_State* L)
+	{
+		uint32_t slot = getCurrentSlot(L);
+
+		if (slot == NO_SLOT)
+		{
+			return 0;
+		}
+
+		tasks[slot].state = TaskState::WAITING;
+
+		return makeId(slot, tasks[slot].generation);
+	}
+
+	bool LuaScheduler::resolve(TaskId handle, const LuaValueList& values)
+	{
+		Task* task = getTask(handle);
+
+		if (task == nullptr || task->state != TaskState::WAITING)
+		{
+			return false;
+		}
+
+		for (LuaValueList::const_iterator iter = values.begin(); iter != values.end(); ++iter)
+		{
+			iter->pushValue();
+		}
+		lua_xmove(luaState, task->thread, static_cast<int>(values.size()));
+
+		task->numArgs = static_cast<int>(values.size());
+
+		makeReady(static_cast<uint32_t>(handle & 0xFFFFFFFF), Clock::now());
+
+		return true;
+	}
+
+	size_t LuaScheduler::runOnce(size_t maxResumes)
+	{
+		Clock::time_point now = Clock::now();
+
+		while (!timers.empty() && timers.top().deadline <= now)
+		{
+			Timer timer = timers.top();
+			timers.pop();
+
+			Task* task = getTask(timer.id);
+
+			if (task != nullptr && task->state == TaskState::SLEEPING)
+			{
+				task->numArgs = 0;
+				makeReady(static_cast<uint32_t>(timer.id & 0xFFFFFFFF), now);
+			}
+		}
+
+		// Only run the tasks which are ready now, tasks which yield are handled in the next batch
+		size_t batchSize = std::min(maxResumes, readyQueue.size());
+		size_t resumed = 0;
+
+		for (size_t i = 0; i < batchSize; ++i)
+		{
+			TaskId id = readyQueue.front();
+			readyQueue.pop_front();
+
+			Task* task = getTask(id);
+
+			if (task == nullptr || task->state != TaskState::READY)
+			{
+				continue;
+			}
+
+			uint64_t latency = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - task->readyTime).count();
+
+			++stats.resumes;
+			stats.totalLatency += latency;
+			stats.maxLatency = std::max(stats.maxLatency, latency);
+
+			resumeTask(static_cast<uint32_t>(id & 0xFFFFFFFF));
+			++resumed;
+		}
+
+		return resumed;
+	}
+
+	bool LuaScheduler::getNextDeadline(Clock::time_point& deadline) const
+	{
+		if (timers.empty())
+		{
+			return false;
+		}
+
+		deadline = timers.top().deadline;
+
+		return true;
+	}
+
+	int LuaScheduler::sleepFunction(lua_State* L)
+	{
+		LuaScheduler* scheduler = static_cast<LuaScheduler*>(lua_touserdata(L, lua_upvalueindex(1)));
+
+		lua_Number seconds = luaL_checknumber(L, 1);
+
+		uint32_t slot = scheduler->getCurrentSlot(L);
+
+		if (slot == NO_SLOT)
+		{
+			return luaL_error(L, "sleep can only be used by a scheduled task!");
+		}
+
+		Task& task = scheduler->tasks[slot];
+		task.state = TaskState::SLEEPING;
+
+		Timer timer;
+		timer.deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+		timer.id = makeId(slot, task.generation);
+
+		scheduler->timers.push(timer);
+
+		return lua_yield(L, 0);
+	}
+
+	int LuaScheduler::yieldFunction(lua_State* L)
+	{
+		LuaScheduler* scheduler = static_cast<LuaScheduler*>(lua_touserdata(L, lua_upvalueindex(1)));
+
+		if (scheduler->getCurrentSlot(L) == NO_SLOT)
+		{
+			return luaL_error(L, "yield can only be used by a scheduled task!");
+		}
+
+		// resumeTask puts the task back into the ready queue
+		return lua_yield(L, 0);
+	}
+
+	LuaScheduler::Task* LuaScheduler::getTask(TaskId id)
+	{
+		uint32_t slot = static_cast<uint32_t>(id & 0xFFFFFFFF);
+		uint32_t generation = static_cast<uint32_t>(id >> 32);
+
+		if (slot >= tasks.size())
+		{
+			return nullptr;
+		}
+
+		Task& task = tasks[slot];
+
+		if (task.generation != generation || task.state == TaskState::FREE)
+		{
+			return nullptr;
+		}
+
+		return &task;
+	}
+
+	uint32_t LuaScheduler::getCurrentSlot(lua_State* L) const
+	{
+		if (currentSlot == NO_SLOT || tasks[currentSlot].thread != L)
+		{
+			return NO_SLOT;
+		}
+
+		return currentSlot;
+	}
+
+	void LuaScheduler::makeReady(uint32_t slot, Clock::time_point now)
+	{
+		Task& task = tasks[slot];
+
+		task.state = TaskState::READY;
+		task.readyTime = now;
+
+		readyQueue.push_back(makeId(slot, task.generation));
+	}
+
+	void LuaScheduler::resumeTask(uint32_t slot)
+	{
+		Task& task = tasks[slot];
+
+		// The state is changed by the functions which suspend the task
+		task.state = TaskState::READY;
+
+		currentSlot = slot;
+		int err = lua_resume(task.thread, task.numArgs);
+		currentSlot = NO_SLOT;
+
+		// tasks may have been reallocated if the task spawned new tasks
+		Task& current = tasks[slot];
+
+		if (err == LUA_YIELD)
+		{
+			// Values passed to yield are not used
+			lua_settop(current.thread, 0);
+
+			if (current.state == TaskState::READY)
+			{
+				// Either our yield or coroutine.yield was used, run the task again in the next batch
+				current.numArgs = 0;
+				makeReady(slot, Clock::now());
+			}
+		}
+		else if (err == 0)
+		{
+			lua_settop(current.thread, 0);
+
+			freeTask(slot, true);
+		}
+		else
+		{
+			if (errorHandler)
+			{
+				size_t len;
+				const char* str = lua_tolstring(current.thread, -1, &len);
+
+				std::string message = str ? std::string(str, len) : "Error object is not a string!";
+
+				errorHandler(makeId(slot, current.generation), message);
+			}
+
+			freeTask(slot, false);
+		}
+	}
+
+	void LuaScheduler::freeTask(uint32_t slot, bool reuseThread)
+	{
+		Task& task = tasks[slot];
+
+		if (!reuseThread)
+		{
+			// A failed coroutine can not be resumed again so remove it from the anchor table
+			threads.pushValue();
+			lua_pushnil(luaState);
+			lua_rawseti(luaState, -2, static_cast<int>(slot + 1));
+			lua_pop(luaState, 1);
+
+			task.thread = nullptr;
+		}
+
+		task.state = TaskState::FREE;
+		task.numArgs = 0;
+
+		freeSlots.push_back(slot);
+		--activeTasks;
+	}
+}
@@ -0,0 +1,633 @@
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "LuaCpp/LuaSerialize.hpp"
+#include "LuaCpp/LuaConvert.hpp"
+
+namespace
+{
+	using namespace luacpp;
+	using namespace luacpp::serialize;
+
+	const char MAGIC[] = { 'L', 'C', 'S', 1 };
+
+	enum Tag : uint8_t
+	{
+		TAG_NIL = 0,
+		TAG_FALSE = 1,
+		TAG_TRUE = 2,
+		TAG_NUMBER = 3, //!< Followed by the 8 bytes of the double, least significant first
+		TAG_INTEGER = 4, //!< Followed by a zigzag encoded varint
+		TAG_STRING = 5, //!< Followed by the length as a varint and the bytes
+		TAG_STRING_REF = 6, //!< Followed by the index of a previous string
+		TAG_TABLE = 7, //!< Followed by the array size, the number of pairs, the array values and the pairs
+		TAG_TABLE_REF = 8 //!< Followed by the index of a previous table
+	};
+
+	// Doubles represent all integers up to this value exactly
+	const double MAX_EXACT_INTEGER = 9007199254740992.0;
+
+	class Encoder
+	{
+	public:
+		Encoder(lua_State* L, Sink& sink, const Limits& limits) :
+			luaState(L), sink(sink), limits(limits), seenIndex(0), stringCount(0), tableCount(0), written(0), used(0)
+		{
+		}
+
+		void encode(int index)
+		{
+			lua_checkstack(luaState, 8);
+
+			// Maps the strings and tables which were already written to their index
+			lua_newtable(luaState);
+			seenIndex = lua_gettop(luaState);
+
+			writeBytes(MAGIC, sizeof(MAGIC));
+			encodeValue(index, 0);
+
+			flush();
+		}
+
+	private:
+		void flush()
+		{
+			if (used > 0)
+			{
+				sink.write(buffer, used);
+				used = 0;
+			}
+		}
+
+		void reserve(size_t length)
+		{
+			written += length;
+
+			if (written > limits.maxSize)
+			{
+				throw LuaException("Serialized data exceeds the size limit!");
+			}
+
+			if (used + length > sizeof(buffer))
+			{
+				flush();
+			}
+		}
+
+		void writeByte(uint8_t byte)
+		{
+			reserve(1);
+
+			buffer[used++] = static_cast<char>(byte);
+		}
+
+		void writeVarint(uint64_t value)
+		{
+			char bytes[10];
+			size_t length = 0;
+
+			do
+			{
+				uint8_t byte = value & 0x7F;
+				value >>= 7;
+
+				if (value != 0)
+				{
+					byte |= 0x80;
+				}
+
+				bytes[length++] = static_cast<char>(byte);
+			} while (value != 0);
+
+			writeBytes(bytes, length);
+		}
+
+		void writeBytes(const char* data, size_t length)
+		{
+			reserve(length);
+
+			if (length > sizeof(buffer))
+			{
+				sink.write(data, length);
+			}
+			else
+			{
+				std::memcpy(buffer + used, data, length);
+				used += length;
+			}
+		}
+
+		void writeNumber(lua_Number number)
+		{
+			double value = static_cast<double>(number);
+
+			if (std::floor(value) == value && std::fabs(value) < MAX_EXACT_INTEGER)
+			{
+				int64_t integer = static_cast<int64_t>(value);
+
+				writeByte(TAG_INTEGER);
+				writeVarint((static_cast<uint64_t>(integer) << 1) ^ static_cast<uint64_t>(integer >> 63));
+				return;
+			}
+
+			uint64_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+
+			char bytes[8];
+			for (int i = 0; i < 8; ++i)
+			{
+				bytes[i] = static_cast<char>((bits >> (i * 8)) & 0xFF);
+			}
+
+			writeByte(TAG_NUMBER);
+			writeBytes(bytes, sizeof(bytes));
+		}
+
+		/**
+		 * @brief Writes a reference if the value was written before, otherwise assigns the next index to it
+		 */
+		bool writeReference(int index, uint8_t tag, uint32_t& counter)
+		{
+			lua_pushvalue(luaState, index);
+			lua_rawget(luaState, seenIndex);
+
+			if (!lua_isnil(luaState, -1))
+			{
+				uint64_t reference = static_cast<uint64_t>(lua_tonumber(luaState, -1));
+				lua_pop(luaState, 1);
+
+				writeByte(tag);
+				writeVarint(reference);
+
+				return true;
+			}
+
+			lua_pop(luaState, 1);
+
+			lua_pushvalue(luaState, index);
+			lua_pushnumber(luaState, static_cast<lua_Number>(counter++));
+			lua_rawset(luaState, seenIndex);
+
+			return false;
+		}
+
+		void encodeValue(int index, size_t depth)
+		{
+			switch (lua_type(luaState, index))
+			{
+			case LUA_TNIL:
+				writeByte(TAG_NIL);
+				break;
+			case LUA_TBOOLEAN:
+				writeByte(lua_toboolean(luaState, index) ? TAG_TRUE : TAG_FALSE);
+				break;
+			case LUA_TNUMBER:
+				writeNumber(lua_tonumber(luaState, index));
+				break;
+			case LUA_TSTRING:
+				if (!writeReference(index, TAG_STRING_REF, stringCount))
+				{
+					size_t length;
+					const char* string = lua_tolstring(luaState, index, &length);
+
+					writeByte(TAG_STRING);
+					writeVarint(length);
+					writeBytes(string, length);
+				}
+				break;
+			case LUA_TTABLE:
+				if (!writeReference(index, TAG_TABLE_REF, tableCount))
+				{
+					encodeTable(index, depth + 1);
+				}
+				break;
+			default:
+				throw LuaException(std::string("Values of type ") + lua_typename(luaState, lua_type(luaState, index)) +
+					" can not be serialized!");
+			}
+		}
+
+		void encodeTable(int index, size_t depth)
+		{
+			if (depth > limits.maxDepth)
+			{
+				throw LuaException("Serialized data exceeds the depth limit!");
+			}
+
+			if (!lua_checkstack(luaState, 4))
+			{
+				throw LuaException("Not enough stack space to serialize the table!");
+			}
+
+			// The array part ends at the first nil value
+			size_t arraySize = 0;
+			size_t maxSize = lua_objlen(luaState, index);
+
+			while (arraySize < maxSize)
+			{
+				lua_rawgeti(luaState, index, static_cast<int>(arraySize) + 1);
+				bool isNil = lua_isnil(luaState, -1);
+				lua_pop(luaState, 1);
+
+				if (isNil)
+				{
+					break;
+				}
+
+				++arraySize;
+			}
+
+			size_t pairCount = 0;
+
+			lua_pushnil(luaState);
+			while (lua_next(luaState, index) != 0)
+			{
+				lua_pop(luaState, 1);
+
+				if (!isArrayKey(-1, arraySize))
+				{
+					++pairCount;
+				}
+			}
+
+			writeByte(TAG_TABLE);
+			writeVarint(arraySize);
+			writeVarint(pairCount);
+
+			for (size_t i = 1; i <= arraySize; ++i)
+			{
+				lua_rawgeti(luaState, index, static_cast<int>(i));
+				encodeValue(lua_gettop(luaState), depth);
+				lua_pop(luaState, 1);
+			}
+
+			lua_pushnil(luaState);
+			while (lua_next(luaState, index) != 0)
+			{
+				int top = lua_gettop(luaState);
+
+				if (!isArrayKey(top - 1, arraySize))
+				{
+					encodeValue(top - 1, depth);
+					encodeValue(top, depth);
+				}
+
+				lua_pop(luaState, 1);
+			}
+		}
+
+		bool isArrayKey(int index, size_t arraySize)
+		{
+			if (lua_type(luaState, index) != LUA_TNUMBER)
+			{
+				return false;
+			}
+
+			lua_Number key = lua_tonumber(luaState, index);
+
+			return key >= 1 && key <= static_cast<lua_Number>(arraySize) && std::floor(key) == key;
+		}
+
+		lua_State* luaState;
+		Sink& sink;
+		Limits limits;
+
+		int seenIndex;
+		uint32_t stringCount;
+		uint32_t tableCount;
+
+		size_t written;
+		size_t used;
+		char buffer[4096];
+	};
+
+	class Decoder
+	{
+	public:
+		Decoder(lua_State* L, const char* data, size_t length, const Limits& limits) :
+			luaState(L), position(data), end(data + length), limits(limits), stringsIndex(0), tablesIndex(0),
+			stringCount(0), tableCount(0)
+		{
+		}
+
+		void decode()
+		{
+			if (static_cast<size_t>(end - position) > limits.maxSize)
+			{
+				throw LuaException("Serialized data exceeds the size limit!");
+			}
+
+			if (static_cast<size_t>(end - position) < sizeof(MAGIC) || std::memcmp(position, MAGIC, sizeof(MAGIC)) != 0)
+			{
+				throw LuaException("Invalid serialized data: Unknown format!");
+			}
+
+			position += sizeof(MAGIC);
+
+			lua_checkstack(luaState, 8);
+
+			// The strings and tables in the order of their first occurence
+			lua_newtable(luaState);
+			stringsIndex = lua_gettop(luaState);
+
+			lua_newtable(luaState);
+			tablesIndex = lua_gettop(luaState);
+
+			decodeValue(0);
+
+			if (position != end)
+			{
+				throw LuaException("Invalid serialized data: Unexpected data after the value!");
+			}
+
+			lua_replace(luaState, stringsIndex);
+			lua_pop(luaState, 1);
+		}
+
+	private:
+		void fail(const char* message)
+		{
+			throw LuaException(std::string("Invalid serialized data: ") + message);
+		}
+
+		size_t remaining() const
+		{
+			return static_cast<size_t>(end - position);
+		}
+
+		uint8_t readByte()
+		{
+			if (position == end)
+			{
+				fail("Unexpected end of data!");
+			}
+
+			return static_cast<uint8_t>(*position++);
+		}
+
+		uint64_t readVarint()
+		{
+			uint64_t value = 0;
+
+			for (int shift = 0; shift < 64; shift += 7)
+			{
+				uint8_t byte = readByte();
+
+				value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+				if ((byte & 0x80) == 0)
+				{
+					return value;
+				}
+			}
+
+			fail("Integer is too long!");
+			return 0;
+		}
+
+		/**
+		 * @brief Reads a count and checks that the remaining data can contain that many elements of at least
+		 * the given size. This prevents allocating huge tables for small inputs.
+		 */
+		size_t readCount(size_t minElementSize)
+		{
+			uint64_t count = readVarint();
+
+			if (count > remaining() / minElementSize)
+			{
+				fail("Count exceeds the remaining data!");
+			}
+
+			return static_cast<size_t>(count);
+		}
+
+		void decodeValue(size_t depth)
+		{
+			uint8_t tag = readByte();
+
+			switch (tag)
+			{
+			case TAG_NIL:
+				lua_pushnil(luaState);
+				break;
+			case TAG_FALSE:
+				lua_pushboolean(luaState, 0);
+				break;
+			case TAG_TRUE:
+				lua_pushboolean(luaState, 1);
+				break;
+			case TAG_NUMBER:
+			{
+				if (remaining() < 8)
+				{
+					fail("Unexpected end of data!");
+				}
+
+				uint64_t bits = 0;
+				for (int i = 0; i < 8; ++i)
+				{
+					bits |= static_cast<uint64_t>(static_cast<uint8_t>(position[i])) << (i * 8);
+				}
+				position += 8;
+
+				double value;
+				std::memcpy(&value, &bits, sizeof(value));
+
+				lua_pushnumber(luaState, static_cast<lua_Number>(value));
+				break;
+			}
+			case TAG_INTEGER:
+			{
+				uint64_t zigzag = readVarint();
+				int64_t value = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+
+				lua_pushnumber(luaState, static_cast<lua_Number>(value));
+				break;
+			}
+			case TAG_STRING:
+			{
+				size_t length = readCount(1);
+
+				lua_pushlstring(luaState, position, length);
+				position += length;
+
+				lua_pushvalue(luaState, -1);
+				lua_rawseti(luaState, stringsIndex, ++stringCount);
+				break;
+			}
+			case TAG_STRING_REF:
+				pushReference(stringsIndex, stringCount);
+				break;
+			case TAG_TABLE:
+				decodeTable(depth + 1);
+				break;
+			case TAG_TABLE_REF:
+				pushReference(tablesIndex, tableCount);
+				break;
+			default:
+				fail("Unknown value type!");
+			}
+		}
+
+		void pushReference(int listIndex, int count)
+		{
+			uint64_t reference = readVarint();
+
+			if (reference >= static_cast<uint64_t>(count))
+			{
+				fail("Invalid reference!");
+			}
+
+			lua_rawgeti(luaState, listIndex, static_cast<int>(reference) + 1);
+		}
+
+		void decodeTable(size_t depth)
+		{
+			if (depth > limits.maxDepth)
+			{
+				throw LuaException("Serialized data exceeds the depth limit!");
+			}
+
+			if (!lua_checkstack(luaState, 4))
+			{
+				throw LuaException("Not enough stack space to deserialize the table!");
+			}
+
+			size_t arraySize = readCount(1);
+			size_t pairCount = readCount(2);
+
+			if (arraySize + pairCount * 2 > remaining())
+			{
+				fail("Count exceeds the remaining data!");
+			}
+
+			lua_createtable(luaState, static_cast<int>(arraySize), static_cast<int>(pairCount));
+
+			lua_pushvalue(luaState, -1);
+			lua_rawseti(luaState, tablesIndex, ++tableCount);
+
+			for (size_t i = 1; i <= arraySize; ++i)
+			{
+				decodeValue(depth);
+				lua_rawseti(luaState, -2, static_cast<int>(i));
+			}
+
+			for (size_t i = 0; i < pairCount; ++i)
+			{
+				decodeValue(depth);
+
+				if (lua_isnil(luaState, -1) || (lua_type(luaState, -1) == LUA_TNUMBER && lua_tonumber(luaState, -1) != lua_tonumber(luaState, -1)))
+				{
+					fail("Invalid table key!");
+				}
+
+				decodeValue(depth);
+				lua_rawset(luaState, -3);
+			}
+		}
+
+		lua_State* luaState;
+		const char* position;
+		const char* end;
+		Limits limits;
+
+		int stringsIndex;
+		int tablesIndex;
+		int stringCount;
+		int tableCount;
+	};
+}
+
+namespace luacpp
+{
+	namespace serialize
+	{
+		void write(lua_State* L, int index, Sink& sink, const Limits& limits)
+		{
+			if (index < 0 && index > LUA_REGISTRYINDEX)
+			{
+				index = lua_gettop(L) + index + 1;
+			}
+
+			int top = lua_gettop(L);
+
+			try
+			{
+				Encoder encoder(L, sink, limits);
+				encoder.encode(index);
+			}
+			catch (...)
+			{
+				lua_settop(L, top);
+				throw;
+			}
+
+			lua_settop(L, top);
+		}
+
+		void write(const LuaValue& value, Sink& sink, const Limits& limits)
+		{
+			if (!value.pushValue())
+			{
+				throw LuaException("Value reference is not valid!");
+			}
+
+			lua_State* L = value.luaState;
+
+			try
+			{
+				write(L, -1, sink, limits);
+			}
+			catch (...)
+			{
+				lua_pop(L, 1);
+				throw;
+			}
+
+			lua_pop(L, 1);
+		}
+
+		std::string toString(const LuaValue& value, const Limits& limits)
+		{
+			std::string data;
+			StringSink sink(data);
+
+			write(value, sink, limits);
+
+			return data;
+		}
+
+		void push(lua_State* L, const char* data, size_t length, const Limits& limits)
+		{
+			int top = lua_gettop(L);
+
+			try
+			{
+				Decoder decoder(L, data, length, limits);
+				decoder.decode();
+			}
+			catch (...)
+			{
+				lua_settop(L, top);
+				throw;
+			}
+		}
+
+		LuaValue read(lua_State* L, const std::string& data, const Limits& limits)
+		{
+			push(L, data.data(), data.size(), limits);
+
+			try
+			{
+				return convert::popValue<LuaValue>(L);
+			}
+			catch (...)
+			{
+				lua_pop(L, 1);
+				throw;
+			}
+		}
+	}
+}
@@ -0,0 +1,346 @@
+
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+#include "LuaCpp/LuaSnapshot.hpp"
+#include "LuaCpp/LuaException.hpp"
+
+namespace
+{
+	// Nested tables are copied recursively, deeper tables are rejected before the C stack runs out
+	const size_t SNAPSHOT_MAX_DEPTH = 128;
+}
+
+namespace luacpp
+{
+	/**
+	 * @brief Copies the tables, it is only used while the snapshot is created
+	 */
+	class LuaSnapshot::Builder
+	{
+	public:
+		Builder(LuaSnapshot* snapshot, lua_State* L) : snapshot(snapshot), luaState(L)
+		{
+		}
+
+		/**
+		 * @brief Copies the table at the given absolute stack index and returns its index
+		 */
+		uint32_t addTable(int index, size_t depth)
+		{
+			const void* pointer = lua_topointer(luaState, index);
+
+			std::unordered_map<const void*, uint32_t>::iterator existing = tableIndices.find(pointer);
+
+			if (existing != tableIndices.end())
+			{
+				return existing->second;
+			}
+
+			if (depth > SNAPSHOT_MAX_DEPTH)
+			{
+				throw LuaException("The table is nested too deeply for a snapshot!");
+			}
+
+			if (!lua_checkstack(luaState, 3))
+			{
+				throw LuaException("Not enough stack space to create the snapshot!");
+			}
+
+			checkSize(snapshot->tables.size());
+
+			uint32_t tableIndex = static_cast<uint32_t>(snapshot->tables.size());
+			tableIndices[pointer] = tableIndex;
+
+			snapshot->tables.push_back(detail::SnapshotTable());
+
+			// The array part ends at the first nil value like with ipairs
+			uint32_t arrayLength = 0;
+			uint32_t maxLength = static_cast<uint32_t>(lua_objlen(luaState, index));
+
+			while (arrayLength < maxLength)
+			{
+				lua_rawgeti(luaState, index, static_cast<int>(arrayLength) + 1);
+				bool isNil = lua_isnil(luaState, -1);
+				lua_pop(luaState, 1);
+
+				if (isNil)
+				{
+					break;
+				}
+
+				++arrayLength;
+			}
+
+			checkSize(snapshot->nodes.size() + arrayLength);
+
+			uint32_t arrayStart = static_cast<uint32_t>(snapshot->nodes.size());
+			snapshot->nodes.resize(snapshot->nodes.size() + arrayLength);
+
+			for (uint32_t i = 0; i < arrayLength; ++i)
+			{
+				lua_rawgeti(luaState, index, static_cast<int>(i) + 1);
+
+				// Nested tables append to the node list so only the index is stable
+				detail::SnapshotNode node = toNode(lua_gettop(luaState), depth);
+				snapshot->nodes[arrayStart + i] = node;
+
+				lua_pop(luaState, 1);
+			}
+
+			std::vector<std::pair<uint32_t, detail::SnapshotNode>> fields;
+
+			lua_pushnil(luaState);
+			while (lua_next(luaState, index) != 0)
+			{
+				if (lua_type(luaState, -2) == LUA_TSTRING)
+				{
+					detail::SnapshotNode value = toNode(lua_gettop(luaState), depth);
+
+					if (value.type != detail::SnapshotType::NIL)
+					{
+						fields.push_back(std::make_pair(addString(-2), value));
+					}
+				}
+
+				lua_pop(luaState, 1);
+			}
+
+			// Keep the load factor at or below one half
+			uint32_t slotCount = 0;
+
+			if (!fields.empty())
+			{
+				slotCount = 1;
+
+				while (slotCount < fields.size() * 2)
+				{
+					slotCount *= 2;
+				}
+			}
+
+			checkSize(snapshot->slots.size() + slotCount);
+
+			uint32_t slotStart = static_cast<uint32_t>(snapshot->slots.size());
+
+			detail::SnapshotSlot emptySlot;
+			emptySlot.key = EMPTY_SLOT;
+			snapshot->slots.resize(snapshot->slots.size() + slotCount, emptySlot);
+
+			for (std::vector<std::pair<uint32_t, detail::SnapshotNode>>::iterator iter = fields.begin(); iter != fields.end(); ++iter)
+			{
+				uint32_t position = snapshot->strings[iter->first].hash & (slotCount - 1);
+
+				while (snapshot->slots[slotStart + position].key != EMPTY_SLOT)
+				{
+					position = (position + 1) & (slotCount - 1);
+				}
+
+				snapshot->slots[slotStart + position].key = iter->first;
+				snapshot->slots[slotStart + position].value = iter->second;
+			}
+
+			detail::SnapshotTable& table = snapshot->tables[tableIndex];
+			table.arrayStart = arrayStart;
+			table.arrayLength = arrayLength;
+			table.slotStart = slotStart;
+			table.slotCount = slotCount;
+			table.fieldCount = static_cast<uint32_t>(fields.size());
+
+			return tableIndex;
+		}
+
+	private:
+		void checkSize(size_t size)
+		{
+			if (size >= std::numeric_limits<uint32_t>::max())
+			{
+				throw LuaException("The table is too large for a snapshot!");
+			}
+		}
+
+		detail::SnapshotNode toNode(int index, size_t depth)
+		{
+			detail::SnapshotNode node;
+
+			switch (lua_type(luaState, index))
+			{
+			case LUA_TBOOLEAN:
+				node.type = detail::SnapshotType::BOOLEAN;
+				node.boolean = lua_toboolean(luaState, index) != 0;
+				break;
+			case LUA_TNUMBER:
+				node.type = detail::SnapshotType::NUMBER;
+				node.number = lua_tonumber(luaState, index);
+				break;
+			case LUA_TSTRING:
+				node.type = detail::SnapshotType::STRING;
+				node.index = addString(index);
+				break;
+			case LUA_TTABLE:
+				node.type = detail::SnapshotType::TABLE;
+				node.index = addTable(index, depth + 1);
+				break;
+			default:
+				// Functions, userdata and threads can not be copied
+				break;
+			}
+
+			return node;
+		}
+
+		uint32_t addString(int index)
+		{
+			size_t length;
+			const char* string = lua_tolstring(luaState, index, &length);
+
+			std::string key(string, length);
+
+			std::unordered_map<std::string, uint32_t>::iterator existing = stringIndices.find(key);
+
+			if (existing != stringIndices.end())
+			{
+				return existing->second;
+			}
+
+			checkSize(snapshot->characters.size() + length + 1);
+
+			detail::SnapshotString entry;
+			entry.offset = static_cast<uint32_t>(snapshot->characters.size());
+			entry.length = static_cast<uint32_t>(length);
+			entry.hash = hashString(string, length);
+
+			snapshot->characters.insert(snapshot->characters.end(), string, string + length);
+			snapshot->characters.push_back('\0');
+
+			uint32_t stringIndex = static_cast<uint32_t>(snapshot->strings.size());
+			snapshot->strings.push_back(entry);
+
+			stringIndices.insert(std::make_pair(key, stringIndex));
+
+			return stringIndex;
+		}
+
+		LuaSnapshot* snapshot;
+		lua_State* luaState;
+
+		std::unordered_map<const void*, uint32_t> tableIndices;
+		std::unordered_map<std::string, uint32_t> stringIndices;
+	};
+
+	LuaSnapshotPtr LuaSnapshot::create(const LuaTable& table)
+	{
+		if (!table.pushValue())
+		{
+			throw LuaException("Table reference is not valid!");
+		}
+
+		lua_State* L = table.luaState;
+		int top = lua_gettop(L);
+
+		boost::shared_ptr<LuaSnapshot> snapshot(new LuaSnapshot());
+
+		try
+		{
+			Builder builder(snapshot.get(), L);
+			builder.addTable(top, 0);
+		}
+		catch (...)
+		{
+			lua_settop(L, top - 1);
+			throw;
+		}
+
+		lua_settop(L, top - 1);
+
+		return snapshot;
+	}
+
+	LuaSnapshot::LuaSnapshot()
+	{
+		std::memset(&emptyTable, 0, sizeof(emptyTable));
+	}
+
+	uint32_t LuaSnapshot::hashString(const char* string, size_t length)
+	{
+		// FNV-1a
+		uint32_t hash = 2166136261u;
+
+		for (size_t i = 0; i < length; ++i)
+		{
+			hash ^= static_cast<unsigned char>(string[i]);
+			hash *= 16777619u;
+		}
+
+		return hash;
+	}
+
+	const char* LuaSnapshot::Value::toString(size_t* length) const
+	{
+		if (!isString())
+		{
+			return nullptr;
+		}
+
+		if (length != nullptr)
+		{
+			*length = snapshot->strings[node->index].length;
+		}
+
+		return snapshot->getString(node->index);
+	}
+
+	LuaSnapshot::Table LuaSnapshot::Value::toTable() const
+	{
+		if (!isTable())
+		{
+			return Table(snapshot, &snapshot->emptyTable);
+		}
+
+		return Table(snapshot, &snapshot->tables[node->index]);
+	}
+
+	LuaSnapshot::Value LuaSnapshot::Table::get(size_t index) const
+	{
+		if (index < 1 || index > table->arrayLength)
+		{
+			return Value(snapshot, &snapshot->nilNode);
+		}
+
+		return Value(snapshot, &snapshot->nodes[table->arrayStart + index - 1]);
+	}
+
+	LuaSnapshot::Value LuaSnapshot::Table::get(const char* key, size_t length) const
+	{
+		if (table->slotCount == 0)
+		{
+			return Value(snapshot, &snapshot->nilNode);
+		}
+
+		uint32_t hash = hashString(key, length);
+		uint32_t mask = table->slotCount - 1;
+		uint32_t position = hash & mask;
+
+		// The load factor is at most one half so there is always an empty slot which ends the search
+		while (true)
+		{
+			const detail::SnapshotSlot& slot = snapshot->slots[table->slotStart + position];
+
+			if (slot.key == EMPTY_SLOT)
+			{
+				return Value(snapshot, &snapshot->nilNode);
+			}
+
+			const detail::SnapshotString& string = snapshot->strings[slot.key];
+
+			if (string.hash == hash && string.length == length &&
+				std::memcmp(snapshot->getString(slot.key), key, length) == 0)
+			{
+				return Value(snapshot, &slot.value);
+			}
+
+			position = (position + 1) & mask;
+		}
+	}
+}
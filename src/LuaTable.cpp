@@ -3,11 +3,11 @@
 
 namespace luacpp
 {
-	LuaTable LuaTable::create(lua_State* state)
+	LuaTable LuaTable::create(lua_State* state, int arraySize, int hashSize)
 	{
 		LuaTable table;
 
-		lua_newtable(state);
+		lua_createtable(state, arraySize, hashSize);
 
 		table.setReference(LuaReference::create(state));
 
@@ -81,6 +81,125 @@ namespace luacpp
 		return LuaTableIterator(this);
 	}
 
+	LuaTable::Accessor::Accessor(const LuaTable& table) : luaState(table.luaState), stackIndex(0)
+	{
+		if (!table.pushValue())
+		{
+			throw LuaException("Table reference is not valid!");
+		}
+
+		stackIndex = lua_gettop(luaState);
+	}
+
+	LuaTable::Accessor::~Accessor()
+	{
+		lua_settop(luaState, stackIndex - 1);
+	}
+
+	LuaTableRange LuaTable::pairs() const
+	{
+		return LuaTableRange(*this, false);
+	}
+
+	LuaTableRange LuaTable::ipairs() const
+	{
+		return LuaTableRange(*this, true);
+	}
+
+	LuaTableRange::LuaTableRange(const LuaTable& table, bool arrayOnly) :
+		luaState(table.luaState), tableIndex(0), arrayOnly(arrayOnly)
+	{
+		if (!table.pushValue())
+		{
+			throw LuaException("Table reference is not valid!");
+		}
+
+		tableIndex = lua_gettop(luaState);
+	}
+
+	LuaTableRange::LuaTableRange(LuaTableRange&& other) :
+		luaState(other.luaState), tableIndex(other.tableIndex), arrayOnly(other.arrayOnly)
+	{
+		other.luaState = nullptr;
+	}
+
+	LuaTableRange::~LuaTableRange()
+	{
+		if (luaState != nullptr)
+		{
+			lua_settop(luaState, tableIndex - 1);
+		}
+	}
+
+	LuaTableRange::iterator LuaTableRange::begin()
+	{
+		lua_settop(luaState, tableIndex);
+
+		return iterator(this, false);
+	}
+
+	LuaTableRange::iterator LuaTableRange::end()
+	{
+		return iterator(this, true);
+	}
+
+	LuaTableRange::iterator::iterator(LuaTableRange* range, bool done) :
+		range(range), entry(range->luaState, range->tableIndex + 1), arrayIndex(0), done(done)
+	{
+		if (!done)
+		{
+			if (!range->arrayOnly)
+			{
+				// Start the iteration with a nil key
+				lua_pushnil(range->luaState);
+			}
+
+			next();
+		}
+	}
+
+	LuaTableRange::iterator& LuaTableRange::iterator::operator++()
+	{
+		if (range->arrayOnly)
+		{
+			// The next key is computed, the stack only contains the table
+			lua_settop(range->luaState, range->tableIndex);
+		}
+		else
+		{
+			// Keep the key for lua_next
+			lua_settop(range->luaState, range->tableIndex + 1);
+		}
+
+		next();
+
+		return *this;
+	}
+
+	void LuaTableRange::iterator::next()
+	{
+		lua_State* L = range->luaState;
+
+		if (range->arrayOnly)
+		{
+			++arrayIndex;
+
+			lua_pushinteger(L, arrayIndex);
+			lua_rawgeti(L, range->tableIndex, arrayIndex);
+
+			if (lua_isnil(L, -1))
+			{
+				lua_pop(L, 2);
+				done = true;
+			}
+		}
+		else if (lua_next(L, range->tableIndex) == 0)
+		{
+			// lua_next has removed the key
+			done = true;
+		}
+	}
+
 	LuaTableIterator::LuaTableIterator(LuaTable* parent) : parent(parent)
 	{
 		// Prepare the iteration
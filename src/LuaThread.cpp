@@ -0,0 +1,229 @@
+#include "LuaCpp/LuaThread.hpp"
+#include "LuaCpp/LuaException.hpp"
+
+#include "LuaCpp/LuaHeaders.hpp"
+
+namespace luacpp
+{
+	LuaThread LuaThread::create(lua_State* L, const LuaFunction& function)
+	{
+		LuaThread thread = create(L);
+
+		thread.setFunction(function);
+
+		return thread;
+	}
+
+	LuaThread LuaThread::create(lua_State* L)
+	{
+		LuaThread thread;
+
+		lua_newthread(L);
+
+		thread.setReference(LuaReference::create(L));
+
+		lua_pop(L, 1);
+
+		return thread;
+	}
+
+	LuaThread::LuaThread() : LuaValue(), thread(nullptr)
+	{
+	}
+
+	LuaThread::LuaThread(const LuaThread& other) : LuaValue(other), thread(other.thread)
+	{
+	}
+
+	LuaThread::~LuaThread()
+	{
+	}
+
+	void LuaThread::setReference(LuaReferencePtr reference)
+	{
+		reference->pushValue();
+
+		lua_State* L = reference->getState();
+
+		if (lua_type(L, -1) != LUA_TTHREAD)
+		{
+			lua_pop(L, 1);
+			throw LuaException("Reference does not refere to a thread!");
+		}
+		else
+		{
+			thread = lua_tothread(L, -1);
+
+			lua_pop(L, 1);
+			LuaValue::setReference(reference);
+		}
+	}
+
+	ThreadStatus LuaThread::getStatus() const
+	{
+		if (thread == nullptr)
+		{
+			return ThreadStatus::ERRORED;
+		}
+
+		switch (lua_status(thread))
+		{
+		case LUA_YIELD:
+			return ThreadStatus::SUSPENDED;
+		case 0:
+		{
+			lua_Debug ar;
+			if (lua_getstack(thread, 0, &ar) > 0)
+			{
+				// The thread has an active call so it is either running or it resumed another coroutine
+				return ThreadStatus::RUNNING;
+			}
+			else if (lua_gettop(thread) == 0)
+			{
+				return ThreadStatus::FINISHED;
+			}
+			else
+			{
+				// The function was set but the thread was not started yet
+				return ThreadStatus::SUSPENDED;
+			}
+		}
+		default:
+			return ThreadStatus::ERRORED;
+		}
+	}
+
+	bool LuaThread::setFunction(const LuaFunction& function)
+	{
+		if (getStatus() != ThreadStatus::FINISHED)
+		{
+			return false;
+		}
+
+		function.pushValue();
+		lua_xmove(luaState, thread, 1);
+
+		return true;
+	}
+
+	LuaValueList LuaThread::resume(const LuaValueList& args)
+	{
+		int top = lua_gettop(luaState);
+
+		for (LuaValueList::const_iterator iter = args.begin(); iter != args.end(); ++iter)
+		{
+			iter->pushValue();
+		}
+
+		int numResults = resumeInternal(static_cast<int>(args.size()));
+
+		LuaValueList values;
+		values.resize(numResults);
+
+		try
+		{
+			for (int i = 0; i < numResults; ++i)
+			{
+				values[i].setReference(LuaReference::create(luaState, top + 1 + i));
+			}
+		}
+		catch (...)
+		{
+			lua_settop(luaState, top);
+			throw;
+		}
+
+		lua_settop(luaState, top);
+
+		return values;
+	}
+
+	int LuaThread::resumeInternal(int numArgs)
+	{
+		if (getStatus() != ThreadStatus::SUSPENDED)
+		{
+			lua_pop(luaState, numArgs);
+			throw LuaException("Thread is not suspended!");
+		}
+
+		lua_xmove(luaState, thread, numArgs);
+
+		int err = lua_resume(thread, numArgs);
+
+		if (err == 0 || err == LUA_YIELD)
+		{
+			int numResults = lua_gettop(thread);
+
+			if (!lua_checkstack(luaState, numResults))
+			{
+				lua_settop(thread, 0);
+				throw LuaException("Not enough stack space for the results of the coroutine!");
+			}
+
+			lua_xmove(thread, luaState, numResults);
+
+			return numResults;
+		}
+		else
+		{
+			// The error object is on top of the thread stack
+			lua_xmove(thread, luaState, 1);
+
+			LuaValue value;
+
+			try
+			{
+				value.setReference(LuaReference::create(luaState));
+			}
+			catch (...)
+			{
+				lua_pop(luaState, 1);
+				throw;
+			}
+
+			lua_pop(luaState, 1);
+
+			throw LuaException(LuaError(CallStatus::RUNTIME_ERROR, value).getMessage());
+		}
+	}
+
+	LuaThreadPool::LuaThreadPool(lua_State* L, size_t maxIdle) : luaState(L), maxIdle(maxIdle)
+	{
+		if (L == nullptr)
+		{
+			throw LuaException("Need a valid lua state!");
+		}
+	}
+
+	LuaThread LuaThreadPool::acquire(const LuaFunction& function)
+	{
+		if (idle.empty())
+		{
+			return LuaThread::create(luaState, function);
+		}
+
+		LuaThread thread = idle.back();
+		idle.pop_back();
+
+		thread.setFunction(function);
+
+		return thread;
+	}
+
+	bool LuaThreadPool::release(const LuaThread& thread)
+	{
+		if (idle.size() >= maxIdle)
+		{
+			return false;
+		}
+
+		if (thread.getStatus() != ThreadStatus::FINISHED)
+		{
+			return false;
+		}
+
+		idle.push_back(thread);
+
+		return true;
+	}
+}
@@ -1,6 +1,190 @@
 
 #include "LuaCpp/LuaUtil.hpp"
 
+#include "LuaCpp/LuaHeaders.hpp"
+
+namespace
+{
+	// The address is used as the registry key of the default traceback flag
+	char tracebackKey;
+
+	// The number of frames printed at the start and the end of a long traceback, same as the lua standard library
+	const int TRACEBACK_FIRST_LEVELS = 12;
+	const int TRACEBACK_LAST_LEVELS = 10;
+
+	// Nesting deeper than this is most likely a mistake and would overflow the C stack
+	const size_t TRANSFER_MAX_DEPTH = 200;
+
+	/**
+	 * @brief Copies values from one state to another
+	 */
+	class Transfer
+	{
+	public:
+		Transfer(lua_State* source, lua_State* destination, const luacpp::util::TransferHook& hook) :
+			source(source), destination(destination), hook(hook), seenIndex(0)
+		{
+		}
+
+		void copy(int index)
+		{
+			if (!lua_checkstack(destination, 4))
+			{
+				throw luacpp::LuaException("Not enough stack space to transfer the value!");
+			}
+
+			// Maps the addresses of the source tables to their copies
+			lua_newtable(destination);
+			seenIndex = lua_gettop(destination);
+
+			copyValue(index, 0);
+
+			lua_remove(destination, seenIndex);
+		}
+
+	private:
+		void copyValue(int index, size_t depth)
+		{
+			switch (lua_type(source, index))
+			{
+			case LUA_TNIL:
+				lua_pushnil(destination);
+				break;
+			case LUA_TBOOLEAN:
+				lua_pushboolean(destination, lua_toboolean(source, index));
+				break;
+			case LUA_TNUMBER:
+				lua_pushnumber(destination, lua_tonumber(source, index));
+				break;
+			case LUA_TSTRING:
+			{
+				size_t length;
+				const char* string = lua_tolstring(source, index, &length);
+
+				lua_pushlstring(destination, string, length);
+				break;
+			}
+			case LUA_TTABLE:
+				copyTable(index, depth + 1);
+				break;
+			default:
+				copyOther(index);
+				break;
+			}
+		}
+
+		void copyOther(int index)
+		{
+			int top = lua_gettop(destination);
+
+			if (!hook || !hook(source, index, destination))
+			{
+				lua_settop(destination, top);
+
+				throw luacpp::LuaException(std::string("Values of type ") + lua_typename(source, lua_type(source, index)) +
+					" can not be transferred!");
+			}
+
+			if (lua_gettop(destination) != top + 1)
+			{
+				throw luacpp::LuaException("The transfer hook must push exactly one value!");
+			}
+		}
+
+		void copyTable(int index, size_t depth)
+		{
+			void* address = const_cast<void*>(lua_topointer(source, index));
+
+			lua_pushlightuserdata(destination, address);
+			lua_rawget(destination, seenIndex);
+
+			if (!lua_isnil(destination, -1))
+			{
+				return;
+			}
+
+			lua_pop(destination, 1);
+
+			if (depth > TRANSFER_MAX_DEPTH)
+			{
+				throw luacpp::LuaException("The value is nested too deeply to be transferred!");
+			}
+
+			if (!lua_checkstack(source, 3) || !lua_checkstack(destination, 4))
+			{
+				throw luacpp::LuaException("Not enough stack space to transfer the value!");
+			}
+
+			// Count the pairs so the copy can be created with the right size
+			int count = 0;
+
+			lua_pushnil(source);
+			while (lua_next(source, index) != 0)
+			{
+				lua_pop(source, 1);
+				++count;
+			}
+
+			int arraySize = static_cast<int>(lua_objlen(source, index));
+
+			if (arraySize > count)
+			{
+				arraySize = count;
+			}
+
+			lua_createtable(destination, arraySize, count - arraySize);
+
+			lua_pushlightuserdata(destination, address);
+			lua_pushvalue(destination, -2);
+			lua_rawset(destination, seenIndex);
+
+			lua_pushnil(source);
+			while (lua_next(source, index) != 0)
+			{
+				int top = lua_gettop(source);
+
+				copyValue(top - 1, depth);
+
+				// The hook may turn a key into a value which can not be a table key
+				if (lua_isnil(destination, -1) ||
+					(lua_type(destination, -1) == LUA_TNUMBER && lua_tonumber(destination, -1) != lua_tonumber(destination, -1)))
+				{
+					throw luacpp::LuaException("The transfer hook returned an invalid table key!");
+				}
+
+				copyValue(top, depth);
+
+				lua_rawset(destination, -3);
+
+				lua_pop(source, 1);
+			}
+		}
+
+		lua_State* source;
+		lua_State* destination;
+		const luacpp::util::TransferHook& hook;
+
+		int seenIndex;
+	};
+
+	/**
+	 * @brief Checks if the states share their global state, then values can be moved between them
+	 */
+	bool isSameGlobalState(lua_State* first, lua_State* second)
+	{
+		// All threads of a state share the registry
+		lua_pushvalue(first, LUA_REGISTRYINDEX);
+		lua_pushvalue(second, LUA_REGISTRYINDEX);
+
+		bool same = lua_topointer(first, -1) == lua_topointer(second, -1);
+
+		lua_pop(first, 1);
+		lua_pop(second, 1);
+
+		return same;
+	}
+}
+
 namespace luacpp
 {
 	namespace util
@@ -22,5 +206,184 @@ namespace luacpp
 			default: return "unknown";
 			}
 		}
+
+		int traceback(lua_State* L)
+		{
+			if (!lua_isstring(L, 1))
+			{
+				// Keep other error objects so they can be inspected by the caller
+				lua_settop(L, 1);
+				return 1;
+			}
+
+			lua_settop(L, 1);
+
+			luaL_Buffer buffer;
+			luaL_buffinit(L, &buffer);
+
+			lua_pushvalue(L, 1);
+			luaL_addvalue(&buffer);
+			luaL_addstring(&buffer, "\nstack traceback:");
+
+			lua_Debug ar;
+			bool firstPart = true;
+
+			// Level 0 is this function
+			int level = 1;
+			while (lua_getstack(L, level++, &ar))
+			{
+				if (level > TRACEBACK_FIRST_LEVELS && firstPart)
+				{
+					if (!lua_getstack(L, level + TRACEBACK_LAST_LEVELS, &ar))
+					{
+						// Not enough frames left to skip any
+						--level;
+					}
+					else
+					{
+						luaL_addstring(&buffer, "\n\t...");
+
+						while (lua_getstack(L, level + TRACEBACK_LAST_LEVELS, &ar))
+						{
+							++level;
+						}
+					}
+
+					firstPart = false;
+					continue;
+				}
+
+				lua_getinfo(L, "Snl", &ar);
+
+				luaL_addstring(&buffer, "\n\t");
+				luaL_addstring(&buffer, ar.short_src);
+
+				if (ar.currentline > 0)
+				{
+					lua_pushfstring(L, ":%d:", ar.currentline);
+					luaL_addvalue(&buffer);
+				}
+				else
+				{
+					luaL_addchar(&buffer, ':');
+				}
+
+				if (*ar.namewhat != '\0')
+				{
+					lua_pushfstring(L, " in function '%s'", ar.name);
+					luaL_addvalue(&buffer);
+				}
+				else if (*ar.what == 'm')
+				{
+					luaL_addstring(&buffer, " in main chunk");
+				}
+				else if (*ar.what == 'C' || *ar.what == 't')
+				{
+					luaL_addstring(&buffer, " ?");
+				}
+				else
+				{
+					lua_pushfstring(L, " in function <%s:%d>", ar.short_src, ar.linedefined);
+					luaL_addvalue(&buffer);
+				}
+			}
+
+			luaL_pushresult(&buffer);
+
+			return 1;
+		}
+
+		void setDefaultTraceback(lua_State* L, bool enable)
+		{
+			lua_pushlightuserdata(L, &tracebackKey);
+
+			if (enable)
+			{
+				lua_pushboolean(L, 1);
+			}
+			else
+			{
+				lua_pushnil(L);
+			}
+
+			lua_rawset(L, LUA_REGISTRYINDEX);
+		}
+
+		bool isDefaultTracebackEnabled(lua_State* L)
+		{
+			lua_pushlightuserdata(L, &tracebackKey);
+			lua_rawget(L, LUA_REGISTRYINDEX);
+
+			bool enabled = lua_toboolean(L, -1) != 0;
+
+			lua_pop(L, 1);
+
+			return enabled;
+		}
+
+		void transfer(lua_State* source, int index, lua_State* destination, const TransferHook& hook)
+		{
+			if (index < 0 && index > LUA_REGISTRYINDEX)
+			{
+				index = lua_gettop(source) + index + 1;
+			}
+
+			if (source == destination)
+			{
+				lua_pushvalue(source, index);
+				return;
+			}
+
+			if (isSameGlobalState(source, destination))
+			{
+				if (!lua_checkstack(destination, 1))
+				{
+					throw LuaException("Not enough stack space to transfer the value!");
+				}
+
+				lua_pushvalue(source, index);
+				lua_xmove(source, destination, 1);
+				return;
+			}
+
+			int sourceTop = lua_gettop(source);
+			int destinationTop = lua_gettop(destination);
+
+			try
+			{
+				Transfer copier(source, destination, hook);
+				copier.copy(index);
+			}
+			catch (...)
+			{
+				lua_settop(source, sourceTop);
+				lua_settop(destination, destinationTop);
+				throw;
+			}
+		}
+
+		LuaValue transfer(const LuaValue& value, lua_State* destination, const TransferHook& hook)
+		{
+			if (!value.pushValue())
+			{
+				throw LuaException("Value reference is not valid!");
+			}
+
+			lua_State* source = value.luaState;
+
+			try
+			{
+				transfer(source, -1, destination, hook);
+			}
+			catch (...)
+			{
+				lua_pop(source, 1);
+				throw;
+			}
+
+			lua_pop(source, 1);
+
+			return convert::popValue<LuaValue>(destination);
+		}
 	}
 }
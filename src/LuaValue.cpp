@@ -46,6 +46,8 @@ namespace luacpp
 
 		val.setReference(LuaReference::create(L));
 
+		lua_pop(L, 1);
+
 		return val;
 	}
 
@@ -57,7 +59,7 @@ namespace luacpp
 		}
 	}
 
-	LuaValue::LuaValue(const LuaValue& other) : luaState(other.luaState)
+	LuaValue::LuaValue(const LuaValue& other) : luaState(other.luaState), luaType(ValueType::NONE)
 	{
 		// Just copy the reference object from the other
 		this->setReference(other.reference);
@@ -71,7 +73,7 @@ namespace luacpp
 	{
 		this->reference = reference;
 
-		if (this->reference->isValid())
+		if (this->reference && this->reference->isValid())
 		{
 			this->reference->pushValue();
 
@@ -94,7 +96,7 @@ namespace luacpp
 
 	bool LuaValue::pushValue() const
 	{
-		if (this->reference->isValid())
+		if (this->isValid())
 		{
 			this->reference->pushValue();
 			return true;
@@ -30,3 +30,78 @@ TEST_F(LuaArgumentTest, GetArgs)
 		lua_pop(L, 1);
 	}
 }
+
+namespace
+{
+	int scale(lua_State* L)
+	{
+		double value;
+		double factor;
+		const char* unit;
+
+		ArgumentStatus status = checkArgs(L, value, defaultValue(factor, 2.0), defaultValue(unit, "m"));
+
+		if (!status.isOk())
+		{
+			return raiseError(L, status);
+		}
+
+		lua_pushnumber(L, value * factor);
+		lua_pushstring(L, unit);
+
+		return 2;
+	}
+}
+
+TEST_F(LuaArgumentTest, CheckArgs)
+{
+	{
+		ScopedLuaStackTest stackTest(L);
+
+		lua_pushnumber(L, 4.0);
+		lua_pushliteral(L, "text");
+		lua_pushboolean(L, 1);
+
+		double number;
+		std::string text;
+		bool flag;
+		int missing = 0;
+
+		ArgumentStatus status = checkArgs(L, number, text, flag, defaultValue(missing, 7));
+
+		ASSERT_TRUE(status.isOk());
+		ASSERT_DOUBLE_EQ(4.0, number);
+		ASSERT_EQ(std::string("text"), text);
+		ASSERT_TRUE(flag);
+		ASSERT_EQ(7, missing);
+
+		status = checkArgs(L, number, number);
+
+		ASSERT_FALSE(status.isOk());
+		ASSERT_EQ(2, status.index);
+		ASSERT_STREQ("number", status.expected);
+
+		status = checkArgs(L, number, text, flag, number);
+
+		ASSERT_EQ(4, status.index);
+
+		lua_pop(L, 3);
+	}
+	{
+		ScopedLuaStackTest stackTest(L);
+
+		lua_pushcfunction(L, &scale);
+		lua_setglobal(L, "scale");
+
+		luaL_loadstring(L, "return scale(3)");
+		ASSERT_EQ(0, lua_pcall(L, 0, 2, 0));
+		ASSERT_DOUBLE_EQ(6.0, lua_tonumber(L, -2));
+		ASSERT_STREQ("m", lua_tostring(L, -1));
+		lua_pop(L, 2);
+
+		luaL_loadstring(L, "return scale(3, 'x')");
+		ASSERT_NE(0, lua_pcall(L, 0, 2, 0));
+		ASSERT_NE(std::string::npos, std::string(lua_tostring(L, -1)).find("bad argument #2 to 'scale' (number expected, got string)"));
+		lua_pop(L, 1);
+	}
+}
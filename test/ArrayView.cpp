@@ -0,0 +1,127 @@
+#include <limits>
+#include <vector>
+
+#include "TestUtil.hpp"
+
+#include "LuaCpp/LuaArrayView.hpp"
+#include "LuaCpp/LuaFunction.hpp"
+
+using namespace luacpp;
+
+class LuaArrayViewTest : public LuaStateTest
+{
+};
+
+TEST_F(LuaArrayViewTest, ReadWrite)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	std::vector<float> buffer = { 1.0f, 2.0f, 3.0f };
+
+	ArrayView<float>::push(L, buffer.data(), buffer.size());
+	lua_setglobal(L, "buffer");
+
+	LuaValueList values = LuaFunction::createFromCode(L,
+		"local sum = 0\n"
+		"for i = 1, #buffer do sum = sum + buffer[i]; buffer[i] = buffer[i] * 2 end\n"
+		"return sum, #buffer").call();
+
+	ASSERT_DOUBLE_EQ(6.0, values[0].getValue<double>());
+	ASSERT_EQ(3, values[1].getValue<int>());
+
+	// The buffer was modified in place
+	ASSERT_FLOAT_EQ(2.0f, buffer[0]);
+	ASSERT_FLOAT_EQ(6.0f, buffer[2]);
+
+	ASSERT_THROW(LuaFunction::createFromCode(L, "return buffer[0]").call(), LuaException);
+	ASSERT_THROW(LuaFunction::createFromCode(L, "return buffer[4]").call(), LuaException);
+	ASSERT_THROW(LuaFunction::createFromCode(L, "return buffer[1.5]").call(), LuaException);
+	ASSERT_THROW(LuaFunction::createFromCode(L, "buffer[1] = 'x'").call(), LuaException);
+
+	lua_getglobal(L, "buffer");
+
+	size_t length;
+	ASSERT_EQ(buffer.data(), ArrayView<float>::get(L, -1, &length));
+	ASSERT_EQ(3, length);
+	ASSERT_TRUE(ArrayView<double>::get(L, -1) == nullptr);
+
+	lua_pop(L, 1);
+
+	lua_pushnil(L);
+	lua_setglobal(L, "buffer");
+}
+
+TEST_F(LuaArrayViewTest, ReadOnly)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	const int values[] = { 4, 5, 6 };
+
+	ArrayView<int>::push(L, values, 3);
+	lua_setglobal(L, "values");
+
+	ASSERT_EQ(5, LuaFunction::createFromCode(L, "return values[2]").call()[0].getValue<int>());
+	ASSERT_THROW(LuaFunction::createFromCode(L, "values[2] = 1").call(), LuaException);
+	ASSERT_EQ(5, values[1]);
+
+	lua_pushnil(L);
+	lua_setglobal(L, "values");
+}
+
+TEST_F(LuaArrayViewTest, IntegerValues)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	int values[] = { 1, 2 };
+	unsigned char bytes[] = { 0 };
+
+	ArrayView<int>::push(L, values, 2);
+	lua_setglobal(L, "values");
+
+	ArrayView<unsigned char>::push(L, bytes, 1);
+	lua_setglobal(L, "bytes");
+
+	LuaFunction::createFromCode(L, "values[1] = -2147483648; values[2] = 2147483647; bytes[1] = 255").call();
+	ASSERT_EQ(std::numeric_limits<int>::min(), values[0]);
+	ASSERT_EQ(std::numeric_limits<int>::max(), values[1]);
+	ASSERT_EQ(255, bytes[0]);
+
+	// Values which can not be represented exactly are rejected
+	ASSERT_THROW(LuaFunction::createFromCode(L, "values[1] = 1.5").call(), LuaException);
+	ASSERT_THROW(LuaFunction::createFromCode(L, "values[1] = 1e20").call(), LuaException);
+	ASSERT_THROW(LuaFunction::createFromCode(L, "values[1] = 2147483648").call(), LuaException);
+	ASSERT_THROW(LuaFunction::createFromCode(L, "values[1] = 0/0").call(), LuaException);
+	ASSERT_THROW(LuaFunction::createFromCode(L, "values[1] = math.huge").call(), LuaException);
+	ASSERT_THROW(LuaFunction::createFromCode(L, "bytes[1] = 256").call(), LuaException);
+	ASSERT_THROW(LuaFunction::createFromCode(L, "bytes[1] = -1").call(), LuaException);
+
+	ASSERT_EQ(std::numeric_limits<int>::min(), values[0]);
+	ASSERT_EQ(255, bytes[0]);
+
+	lua_pushnil(L);
+	lua_setglobal(L, "values");
+	lua_pushnil(L);
+	lua_setglobal(L, "bytes");
+}
+
+TEST_F(LuaArrayViewTest, Owner)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	boost::shared_ptr<std::vector<double>> buffer(new std::vector<double>(100, 1.0));
+	boost::weak_ptr<std::vector<double>> weak = buffer;
+
+	ArrayView<double>::push(L, buffer->data(), buffer->size(), false, buffer);
+	lua_setglobal(L, "buffer");
+
+	buffer.reset();
+	ASSERT_FALSE(weak.expired());
+
+	ASSERT_EQ(100, LuaFunction::createFromCode(L, "return #buffer").call()[0].getValue<int>());
+
+	lua_pushnil(L);
+	lua_setglobal(L, "buffer");
+	lua_gc(L, LUA_GCCOLLECT, 0);
+
+	ASSERT_TRUE(weak.expired());
+}
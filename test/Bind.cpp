@@ -0,0 +1,176 @@
+
+#include <memory>
+#include <functional>
+#include <stdexcept>
+
+#include "TestUtil.hpp"
+
+#include "LuaCpp/LuaBind.hpp"
+#include "LuaCpp/LuaUsertype.hpp"
+
+using namespace luacpp;
+
+namespace
+{
+	int add(int a, int b)
+	{
+		return a + b;
+	}
+
+	std::tuple<std::string, int> describe(const std::string& name, int count)
+	{
+		return std::make_tuple(name + "!", count * 2);
+	}
+}
+
+class LuaBindTest : public LuaStateTest
+{
+};
+
+TEST_F(LuaBindTest, Wrap)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	lua_pushcfunction(L, (&bind::wrap<decltype(add), &add>));
+	lua_setglobal(L, "add");
+
+	lua_pushcfunction(L, (&bind::wrap<decltype(describe), &describe>));
+	lua_setglobal(L, "describe");
+
+	LuaValueList values = LuaFunction::createFromCode(L, "return add(1, 2), describe('abc', 4)").call();
+
+	ASSERT_EQ(3, values.size());
+	ASSERT_EQ(3, values[0].getValue<int>());
+	ASSERT_EQ(std::string("abc!"), values[1].getValue<std::string>());
+	ASSERT_EQ(8, values[2].getValue<int>());
+}
+
+TEST_F(LuaBindTest, Callables)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	int calls = 0;
+	LuaFunction counter = bind::createFunction(L, [&calls](int step) { calls += step; });
+
+	counter.call({ LuaValue::createValue(L, 2) });
+	counter.call({ LuaValue::createValue(L, 3) });
+	ASSERT_EQ(5, calls);
+
+	std::function<std::string(std::string)> repeat = [](std::string str) { return str + str; };
+	LuaFunction repeatFunc = bind::createFunction(L, repeat);
+
+	LuaValueList values = repeatFunc.call({ LuaValue::createValue(L, "ab") });
+	ASSERT_EQ(std::string("abab"), values[0].getValue<std::string>());
+}
+
+TEST_F(LuaBindTest, CStrings)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaFunction literal = bind::createFunction(L, []() -> const char* { return "literal"; });
+	LuaFunction length = bind::createFunction(L, [](const char* str) { return std::string(str).size(); });
+
+	LuaValueList values = literal.call();
+	ASSERT_EQ(1, values.size());
+	ASSERT_EQ(std::string("literal"), values[0].getValue<std::string>());
+
+	values = length.call({ LuaValue::createValue(L, "abcd") });
+	ASSERT_EQ(1, values.size());
+	ASSERT_EQ(4, values[0].getValue<int>());
+
+	ASSERT_THROW(length.call({ LuaValue::createValue(L, true) }), LuaException);
+}
+
+TEST_F(LuaBindTest, Errors)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	bind::pushFunction(L, &add);
+	lua_setglobal(L, "add");
+
+	LuaFunction thrower = bind::createFunction(L, []() -> int { throw std::runtime_error("Thrown error"); });
+
+	try
+	{
+		LuaFunction::createFromCode(L, "return add(1, 'x')").call();
+		FAIL();
+	}
+	catch (const LuaException& err)
+	{
+		ASSERT_NE(std::string::npos, std::string(err.what()).find("bad argument #2 to 'add'"));
+	}
+
+	ASSERT_THROW(LuaFunction::createFromCode(L, "return add(1)").call(), LuaException);
+
+	try
+	{
+		thrower.call();
+		FAIL();
+	}
+	catch (const LuaException& err)
+	{
+		ASSERT_STREQ("Thrown error", err.what());
+	}
+}
+
+TEST_F(LuaBindTest, Overloads)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	bind::pushFunction(L, bind::overload(
+		[](int value) { return std::string("number ") + std::to_string(value); },
+		[](const std::string& value) { return std::string("string ") + value; },
+		[](bool value) { return std::string("boolean ") + (value ? "true" : "false"); },
+		&add,
+		[](const std::string& a, int b) { return a + std::to_string(b); }));
+	lua_setglobal(L, "describe");
+
+	LuaValueList values = LuaFunction::createFromCode(L,
+		"return describe(1), describe('a'), describe(true), describe(1, 2), describe('a', 2)").call();
+
+	ASSERT_EQ(5, values.size());
+	ASSERT_EQ(std::string("number 1"), values[0].getValue<std::string>());
+	ASSERT_EQ(std::string("string a"), values[1].getValue<std::string>());
+	ASSERT_EQ(std::string("boolean true"), values[2].getValue<std::string>());
+	ASSERT_EQ(3, values[3].getValue<int>());
+	ASSERT_EQ(std::string("a2"), values[4].getValue<std::string>());
+
+	ASSERT_THROW(LuaFunction::createFromCode(L, "return describe({})").call(), LuaException);
+	ASSERT_THROW(LuaFunction::createFromCode(L, "return describe(1, 2, 3)").call(), LuaException);
+}
+
+TEST_F(LuaBindTest, StdFunction)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaFunction::createFromCode(L, "return function(a, b) return a * b end").call()[0].pushValue();
+
+	std::function<int(int, int)> multiply = convert::popValue<std::function<int(int, int)>>(L);
+
+	ASSERT_EQ(12, multiply(3, 4));
+	ASSERT_EQ(30, multiply(5, 6));
+
+	std::function<void(std::string)> fail = [](std::string) {};
+	LuaFunction::createFromCode(L, "return function() error('failed') end").call()[0].pushValue();
+	fail = convert::popValue<std::function<void(std::string)>>(L);
+
+	ASSERT_THROW(fail("abc"), LuaException);
+
+	auto owner = std::make_shared<int>(0);
+	std::weak_ptr<int> weak = owner;
+
+	std::function<int(int)> increment = [owner](int value) { return value + 1 + *owner; };
+	convert::pushValue(L, increment);
+	lua_setglobal(L, "increment");
+
+	owner.reset();
+	increment = nullptr;
+
+	ASSERT_EQ(3, LuaFunction::createFromCode(L, "return increment(2)").call()[0].getValue<int>());
+
+	lua_pushnil(L);
+	lua_setglobal(L, "increment");
+	lua_gc(L, LUA_GCCOLLECT, 0);
+
+	ASSERT_TRUE(weak.expired());
+}
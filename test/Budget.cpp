@@ -0,0 +1,176 @@
+
+#include "TestUtil.hpp"
+
+#include "LuaCpp/LuaFunction.hpp"
+#include "LuaCpp/LuaThread.hpp"
+
+using namespace luacpp;
+
+class LuaBudgetTest : public LuaStateTest
+{
+};
+
+TEST_F(LuaBudgetTest, Instructions)
+{
+	{
+		ScopedLuaStackTest stackTest(L);
+
+		LuaFunction func = LuaFunction::createFromCode(L, "while true do end");
+
+		ExecutionBudget budget;
+		budget.maxInstructions = 10000;
+		budget.checkInterval = 100;
+
+		ASSERT_THROW(func.callWithBudget(budget), BudgetExceededException);
+
+		// The hook is removed again
+		ASSERT_TRUE(lua_gethook(L) == nullptr);
+	}
+	{
+		ScopedLuaStackTest stackTest(L);
+
+		LuaFunction func = LuaFunction::createFromCode(L, "local x = 0; for i = 1, 10 do x = x + i end; return x");
+
+		ExecutionBudget budget;
+		budget.maxInstructions = 10000;
+		budget.checkInterval = 100;
+
+		LuaValueList values = func.callWithBudget(budget);
+
+		ASSERT_EQ(1, values.size());
+		ASSERT_EQ(55, values[0].getValue<int>());
+	}
+	{
+		ScopedLuaStackTest stackTest(L);
+
+		// Catching the error does not help
+		LuaFunction func = LuaFunction::createFromCode(L, "while true do pcall(function() while true do end end) end");
+
+		ExecutionBudget budget;
+		budget.maxInstructions = 10000;
+
+		ASSERT_THROW(func.callWithBudget(budget), BudgetExceededException);
+	}
+	{
+		ScopedLuaStackTest stackTest(L);
+
+		LuaFunction func = LuaFunction::createFromCode(L, "error('TestError')");
+
+		ExecutionBudget budget;
+		budget.maxInstructions = 10000;
+
+		try
+		{
+			func.callWithBudget(budget);
+			FAIL();
+		}
+		catch (const BudgetExceededException&)
+		{
+			FAIL();
+		}
+		catch (const LuaException& err)
+		{
+			ASSERT_TRUE(std::string(err.what()).find("TestError") != std::string::npos);
+		}
+	}
+}
+
+TEST_F(LuaBudgetTest, ExceededInCoroutine)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaFunction func = LuaFunction::createFromCode(L,
+		"co = coroutine.create(function() while true do end end)\n"
+		"coroutine.resume(co)\n"
+		"while true do end");
+
+	ExecutionBudget budget;
+	budget.maxInstructions = 10000;
+
+	ASSERT_THROW(func.callWithBudget(budget), BudgetExceededException);
+
+	lua_getglobal(L, "co");
+	lua_State* coroutine = lua_tothread(L, -1);
+	ASSERT_TRUE(coroutine != nullptr);
+
+	// The coroutine does not keep the hook of the budget
+	ASSERT_TRUE(lua_gethook(coroutine) == nullptr);
+	ASSERT_TRUE(lua_gethook(L) == nullptr);
+
+	lua_pop(L, 1);
+}
+
+TEST_F(LuaBudgetTest, InheritedByCoroutine)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	// The first coroutine runs long enough to be seen by the budget, the second one only starts
+	LuaFunction func = LuaFunction::createFromCode(L,
+		"busy = coroutine.create(function() for i = 1, 10000 do end; coroutine.yield(); return 1 end)\n"
+		"idle = coroutine.create(function() coroutine.yield(); for i = 1, 10000 do end; return 2 end)\n"
+		"coroutine.resume(busy)\n"
+		"coroutine.resume(idle)");
+
+	ExecutionBudget budget;
+	budget.maxInstructions = 1000000;
+	budget.checkInterval = 100;
+
+	func.callWithBudget(budget);
+
+	lua_getglobal(L, "busy");
+	lua_State* busy = lua_tothread(L, -1);
+	lua_getglobal(L, "idle");
+	lua_State* idle = lua_tothread(L, -1);
+
+	ASSERT_TRUE(lua_gethook(busy) == nullptr);
+
+	// Resuming the coroutine after the budget removes the hook it inherited
+	ASSERT_EQ(0, luaL_dostring(L, "local ok, value = coroutine.resume(idle); return ok and value == 2"));
+	ASSERT_TRUE(lua_toboolean(L, -1) != 0);
+	ASSERT_TRUE(lua_gethook(idle) == nullptr);
+
+	ASSERT_EQ(0, luaL_dostring(L, "local ok, value = coroutine.resume(busy); return ok and value == 1"));
+	ASSERT_TRUE(lua_toboolean(L, -1) != 0);
+
+	lua_pop(L, 4);
+}
+
+TEST_F(LuaBudgetTest, Time)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaFunction func = LuaFunction::createFromCode(L, "while true do end");
+
+	ExecutionBudget budget;
+	budget.maxTime = std::chrono::milliseconds(10);
+
+	ASSERT_THROW(func.callWithBudget(budget), BudgetExceededException);
+}
+
+TEST_F(LuaBudgetTest, Coroutine)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaFunction func = LuaFunction::createFromCode(L, "local x = 0; for i = 1, 100000 do x = x + 1 end; return x");
+	LuaThread thread = LuaThread::create(L, func);
+
+	ExecutionBudget budget;
+	budget.maxInstructions = 10000;
+	budget.checkInterval = 100;
+	budget.yieldInCoroutine = true;
+
+	ScopedBudget scope(thread.getThreadState(), budget);
+
+	int slices = 0;
+	LuaValueList values;
+	do
+	{
+		values = thread.resume();
+		++slices;
+	} while (thread.getStatus() == ThreadStatus::SUSPENDED);
+
+	ASSERT_FALSE(scope.isExceeded());
+	ASSERT_GT(slices, 1);
+	ASSERT_EQ(1, values.size());
+	ASSERT_EQ(100000, values[0].getValue<int>());
+}
@@ -4,6 +4,7 @@
 #include "LuaCpp/LuaFunction.hpp"
 #include "LuaCpp/LuaException.hpp"
 #include "LuaCpp/LuaConvert.hpp"
+#include "LuaCpp/LuaUtil.hpp"
 
 using namespace luacpp;
 
@@ -167,3 +168,211 @@ TEST_F(LuaFunctionTest, SetReference)
 		lua_pop(L, 1);
 	}
 }
+
+TEST_F(LuaFunctionTest, CallBatch)
+{
+	{
+		ScopedLuaStackTest stackTest(L);
+
+		LuaFunction func = LuaFunction::createFromCode(L, "local a, b = ...; return a * b");
+
+		std::vector<std::tuple<double, double>> args = { std::make_tuple(1.0, 2.0), std::make_tuple(3.0, 4.0), std::make_tuple(5.0, 6.0) };
+		std::vector<double> results(args.size());
+
+		BatchResult result = func.callBatch(args.data(), args.size(), results.data());
+
+		ASSERT_EQ(3, result.succeeded);
+		ASSERT_EQ(0, result.failed);
+		ASSERT_DOUBLE_EQ(2.0, results[0]);
+		ASSERT_DOUBLE_EQ(12.0, results[1]);
+		ASSERT_DOUBLE_EQ(30.0, results[2]);
+	}
+	{
+		ScopedLuaStackTest stackTest(L);
+
+		LuaFunction func = LuaFunction::createFromCode(L, "local a = ...; if a == 2 then error('Invalid') end; return a");
+
+		std::vector<std::tuple<int>> args = { std::make_tuple(1), std::make_tuple(2), std::make_tuple(3) };
+		std::vector<int> results(args.size(), -1);
+
+		ASSERT_THROW(func.callBatch(args.data(), args.size(), results.data()), LuaException);
+		ASSERT_EQ(1, results[0]);
+		ASSERT_EQ(-1, results[2]);
+
+		BatchResult skipped = func.callBatch(args.data(), args.size(), results.data(), BatchErrorPolicy::SKIP);
+
+		ASSERT_EQ(2, skipped.succeeded);
+		ASSERT_EQ(1, skipped.failed);
+		ASSERT_TRUE(skipped.errors.empty());
+		ASSERT_EQ(3, results[2]);
+
+		BatchResult recorded = func.callBatch(args.data(), args.size(), results.data(), BatchErrorPolicy::RECORD);
+
+		ASSERT_EQ(1, recorded.failed);
+		ASSERT_EQ(1, recorded.errors.size());
+		ASSERT_EQ(1, recorded.errors[0].index);
+		ASSERT_TRUE(recorded.errors[0].message.find("Invalid") != std::string::npos);
+	}
+}
+
+TEST_F(LuaFunctionTest, TryCall)
+{
+	{
+		ScopedLuaStackTest stackTest(L);
+
+		LuaFunction func = LuaFunction::createFromCode(L, "return 'abc', 5");
+
+		LuaCallResult result = func.tryCall();
+
+		ASSERT_TRUE(result.isOk());
+		ASSERT_EQ(CallStatus::OK, result.getError().getStatus());
+		ASSERT_EQ(2, result.getValues().size());
+		ASSERT_STREQ("abc", result.getValues()[0].getValue<std::string>().c_str());
+		ASSERT_EQ(5, result.getValues()[1].getValue<int>());
+	}
+	{
+		ScopedLuaStackTest stackTest(L);
+
+		LuaFunction func = LuaFunction::createFromCode(L, "error('TestError', 0)");
+
+		LuaCallResult result;
+		ASSERT_NO_THROW(result = func.tryCall());
+
+		ASSERT_FALSE(result.isOk());
+		ASSERT_TRUE(result.getValues().empty());
+		ASSERT_EQ(CallStatus::RUNTIME_ERROR, result.getError().getStatus());
+		ASSERT_EQ(ValueType::STRING, result.getError().getValue().getValueType());
+		ASSERT_STREQ("TestError", result.getError().getMessage().c_str());
+	}
+	{
+		ScopedLuaStackTest stackTest(L);
+
+		LuaFunction func = LuaFunction::createFromCode(L, "error({})");
+
+		LuaCallResult result = func.tryCall();
+
+		ASSERT_FALSE(result.isOk());
+		ASSERT_EQ(ValueType::TABLE, result.getError().getValue().getValueType());
+		ASSERT_STREQ("Error object is a table value!", result.getError().getMessage().c_str());
+	}
+	{
+		ScopedLuaStackTest stackTest(L);
+
+		LuaFunction func = LuaFunction::createFromCode(L, "invalid()");
+		func.setErrorFunction(LuaFunction::createFromCFunction(L, &testErrorFunction));
+
+		LuaCallResult result = func.tryCall();
+
+		ASSERT_FALSE(result.isOk());
+		ASSERT_STREQ("TestError", result.getError().getMessage().c_str());
+	}	{
+		ScopedLuaStackTest stackTest(L);
+
+		LuaCallResult result;
+		ASSERT_NO_THROW(result = LuaFunction::createFromCode(L, "return nil").tryCall());
+
+		ASSERT_TRUE(result.isOk());
+		ASSERT_EQ(1, result.getValues().size());
+		ASSERT_EQ(ValueType::NIL, result.getValues()[0].getValueType());
+
+		ASSERT_NO_THROW(result = LuaFunction::createFromCode(L, "return 1, nil, 'x'").tryCall());
+
+		ASSERT_TRUE(result.isOk());
+		ASSERT_EQ(3, result.getValues().size());
+		ASSERT_EQ(1, result.getValues()[0].getValue<int>());
+		ASSERT_EQ(ValueType::NIL, result.getValues()[1].getValueType());
+		ASSERT_EQ(std::string("x"), result.getValues()[2].getValue<std::string>());
+
+		ASSERT_EQ(2, LuaFunction::createFromCode(L, "return nil, nil").call().size());
+	}
+	{
+		ScopedLuaStackTest stackTest(L);
+
+		LuaCallResult result;
+		ASSERT_NO_THROW(result = LuaFunction::createFromCode(L, "error()").tryCall());
+
+		ASSERT_FALSE(result.isOk());
+		ASSERT_EQ(CallStatus::RUNTIME_ERROR, result.getError().getStatus());
+		ASSERT_EQ(ValueType::NIL, result.getError().getValue().getValueType());
+		ASSERT_STREQ("Error object is a nil value!", result.getError().getMessage().c_str());
+
+		ASSERT_NO_THROW(result = LuaFunction::createFromCode(L, "error(nil)").tryCall());
+
+		ASSERT_FALSE(result.isOk());
+		ASSERT_EQ(ValueType::NIL, result.getError().getValue().getValueType());
+	}
+}
+
+TEST_F(LuaFunctionTest, Traceback)
+{
+	{
+		ScopedLuaStackTest stackTest(L);
+
+		LuaFunction func = LuaFunction::createFromCode(L,
+			"local function inner() error('failed') end\n"
+			"inner()", "script");
+
+		ASSERT_FALSE(func.hasTracebackHandler());
+
+		LuaCallResult result = func.tryCall();
+		ASSERT_EQ(std::string::npos, result.getError().getMessage().find("stack traceback:"));
+
+		func.setTracebackHandler(true);
+
+		result = func.tryCall();
+		ASSERT_FALSE(result.isOk());
+
+		std::string message = result.getError().getMessage();
+		ASSERT_EQ(0, message.find("[string \"script\"]:1: failed\nstack traceback:"));
+		ASSERT_NE(std::string::npos, message.find("in function 'inner'"));
+		ASSERT_NE(std::string::npos, message.find("in main chunk"));
+
+		// An explicit error function takes precedence
+		func.setErrorFunction(LuaFunction::createFromCFunction(L, &testErrorFunction));
+		ASSERT_EQ(std::string("TestError"), func.tryCall().getError().getMessage());
+	}
+	{
+		ScopedLuaStackTest stackTest(L);
+
+		util::setDefaultTraceback(L, true);
+		ASSERT_TRUE(util::isDefaultTracebackEnabled(L));
+
+		LuaFunction func = LuaFunction::createFromCode(L, "error({})");
+		ASSERT_TRUE(func.hasTracebackHandler());
+
+		// Error objects which are no strings are passed through
+		LuaCallResult result = func.tryCall();
+		ASSERT_EQ(ValueType::TABLE, result.getError().getValue().getValueType());
+
+		// An explicit setting is kept when the function gets a new reference
+		func.setTracebackHandler(false);
+
+		luaL_loadstring(L, "return 1");
+		func.setReference(LuaReference::create(L));
+		lua_pop(L, 1);
+
+		ASSERT_FALSE(func.hasTracebackHandler());
+
+		util::setDefaultTraceback(L, false);
+		ASSERT_FALSE(LuaFunction::createFromCode(L, "return 1").hasTracebackHandler());
+	}
+}
+
+TEST_F(LuaFunctionTest, CallTyped)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaFunction func = LuaFunction::createFromCode(L, "local a, b = ...; result = a .. b; return result");
+
+	ASSERT_EQ(std::string("ab1"), func.callTyped<std::string>("ab", 1));
+
+	func.callTyped(std::string("x"), std::string("y"));
+
+	lua_getglobal(L, "result");
+	ASSERT_STREQ("xy", lua_tostring(L, -1));
+	lua_pop(L, 1);
+
+	// The result is no number
+	ASSERT_THROW(func.callTyped<double>("a", "b"), LuaException);
+	ASSERT_THROW(func.callTyped<std::string>(), LuaException);
+}
@@ -0,0 +1,119 @@
+
+#include "TestUtil.hpp"
+
+#include "LuaCpp/LuaJson.hpp"
+#include "LuaCpp/LuaTable.hpp"
+
+using namespace luacpp;
+
+class LuaJsonTest : public LuaStateTest
+{
+protected:
+	/**
+	 * @brief Runs a lua expression with the decoded value as @c v and checks that it is true
+	 */
+	bool check(const LuaValue& value, const char* expression)
+	{
+		value.pushValue();
+		lua_setglobal(L, "v");
+
+		std::string code = std::string("return ") + expression;
+		luaL_dostring(L, code.c_str());
+
+		bool result = lua_toboolean(L, -1) != 0;
+		lua_pop(L, 1);
+
+		return result;
+	}
+};
+
+TEST_F(LuaJsonTest, Decode)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaValue value = json::decode(L, " { \"name\": \"caf\\u00e9 \\\"x\\\"\", \"list\": [1, -2.5, 1e3, true, false, null, [] ], "
+		"\"empty\": {}, \"emoji\": \"\\ud83d\\ude00\", \"big\": 12345678901234567890, \"none\": null } ");
+
+	ASSERT_TRUE(check(value, "v.name == 'caf\\195\\169 \"x\"'"));
+	ASSERT_TRUE(check(value, "v.list[1] == 1 and v.list[2] == -2.5 and v.list[3] == 1000 and v.list[4] == true"));
+	ASSERT_TRUE(check(value, "v.list[5] == false and v.list[6] == nil and type(v.list[7]) == 'table'"));
+	ASSERT_TRUE(check(value, "next(v.empty) == nil and v.none == nil"));
+	ASSERT_TRUE(check(value, "v.emoji == '\\240\\159\\152\\128'"));
+	ASSERT_TRUE(check(value, "v.big == 12345678901234567890"));
+
+	// Large arrays and objects are filled in several steps
+	std::string text = "[";
+	for (int i = 1; i <= 100; ++i)
+	{
+		text += (i > 1 ? ",{\"i\":" : "{\"i\":") + std::to_string(i) + "}";
+	}
+	text += "]";
+
+	value = json::decode(L, text);
+	ASSERT_TRUE(check(value, "#v == 100 and v[1].i == 1 and v[50].i == 50 and v[100].i == 100"));
+
+	ASSERT_EQ(ValueType::STRING, json::decode(L, "\"text\"").getValueType());
+
+	int top = lua_gettop(L);
+	ASSERT_EQ(ValueType::NIL, json::decode(L, "null").getValueType());
+	ASSERT_EQ(top, lua_gettop(L));
+}
+
+TEST_F(LuaJsonTest, DecodeErrors)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	const char* invalid[] = { "", "[", "[1,]", "{\"a\" 1}", "{a: 1}", "01", "1.", "-", "tru", "\"abc", "\"\\x\"",
+		"\"\\ud800\"", "[1] 2", "\"a\nb\"", "{\"a\":1,}" };
+
+	for (const char* text : invalid)
+	{
+		ASSERT_THROW(json::decode(L, text), LuaException) << text;
+	}
+
+	json::Options options;
+	options.maxDepth = 2;
+
+	ASSERT_NO_THROW(json::decode(L, "[[1]]", options));
+	ASSERT_THROW(json::decode(L, "[[[1]]]", options), LuaException);
+}
+
+TEST_F(LuaJsonTest, Encode)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	ASSERT_EQ(0, luaL_dostring(L, "return { 1, 2.5, 'a\"b\\n', true }"));
+	ASSERT_EQ("[1,2.5,\"a\\\"b\\n\",true]", json::encode(convert::popValue<LuaValue>(L)));
+
+	ASSERT_EQ(0, luaL_dostring(L, "return { key = { [1] = 'x', [3] = 'y' } }"));
+	std::string object = json::encode(convert::popValue<LuaValue>(L));
+	ASSERT_TRUE(object == "{\"key\":{\"1\":\"x\",\"3\":\"y\"}}" || object == "{\"key\":{\"3\":\"y\",\"1\":\"x\"}}") << object;
+
+	ASSERT_EQ(0, luaL_dostring(L, "return { 'a', 'b', key = 1 }"));
+	LuaValue mixed = convert::popValue<LuaValue>(L);
+
+	ASSERT_NE('[', json::encode(mixed)[0]);
+
+	json::Options options;
+	options.arrayDetection = json::ArrayDetection::LENGTH;
+	ASSERT_EQ("[\"a\",\"b\"]", json::encode(mixed, options));
+
+	LuaTable empty = LuaTable::create(L);
+	ASSERT_EQ("{}", json::encode(empty));
+
+	options.emptyTableAsArray = true;
+	ASSERT_EQ("[]", json::encode(empty, options));
+
+	ASSERT_EQ(0, luaL_dostring(L, "local t = {}; t.self = t; return t"));
+	ASSERT_THROW(json::encode(convert::popValue<LuaValue>(L)), LuaException);
+
+	ASSERT_EQ(0, luaL_dostring(L, "return { print }"));
+	ASSERT_THROW(json::encode(convert::popValue<LuaValue>(L)), LuaException);
+
+	ASSERT_EQ(0, luaL_dostring(L, "return { 1 / 0 }"));
+	ASSERT_THROW(json::encode(convert::popValue<LuaValue>(L)), LuaException);
+
+	// Round trip
+	std::string text = "{\"list\":[1,2,{\"nested\":\"\\u0001\"}]}";
+	ASSERT_EQ(text, json::encode(json::decode(L, text)));
+}
@@ -0,0 +1,143 @@
+
+#include "TestUtil.hpp"
+
+#include "LuaCpp/LuaMetrics.hpp"
+#include "LuaCpp/LuaFunction.hpp"
+
+using namespace luacpp;
+
+class LuaMetricsTest : public LuaStateTest
+{
+};
+
+TEST_F(LuaMetricsTest, Histogram)
+{
+	LatencyHistogram histogram;
+
+	ASSERT_EQ(0, histogram.getCount());
+	ASSERT_EQ(0, histogram.getPercentile(0.5));
+
+	for (uint64_t i = 1; i <= 1000; ++i)
+	{
+		histogram.record(i * 1000);
+	}
+
+	ASSERT_EQ(1000, histogram.getCount());
+
+	// The buckets have a relative error of at most 25%
+	uint64_t p50 = histogram.getPercentile(0.5);
+	ASSERT_GE(p50, 500000);
+	ASSERT_LE(p50, 500000 * 5 / 4);
+
+	uint64_t p99 = histogram.getPercentile(0.99);
+	ASSERT_GE(p99, 990000);
+	ASSERT_LE(p99, 990000 * 5 / 4);
+
+	ASSERT_GE(histogram.getPercentile(1.0), 1000000);
+
+	histogram.record(0);
+	histogram.record(static_cast<uint64_t>(-1));
+
+	ASSERT_EQ(static_cast<uint64_t>(-1), histogram.getPercentile(1.0));
+
+	histogram.reset();
+
+	ASSERT_EQ(0, histogram.getCount());
+}
+
+TEST_F(LuaMetricsTest, Function)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	MetricsRegistry& registry = MetricsRegistry::forState(L);
+
+	ASSERT_EQ(&registry, MetricsRegistry::find(L));
+
+	LuaFunction func = LuaFunction::createFromCode(L, "local fail = ...; if fail then error('failed') end");
+	func.setMetrics(registry.get("func"));
+
+	func.call();
+	func.call();
+	ASSERT_FALSE(func.tryCall({ LuaValue::createValue(L, true) }).isOk());
+
+	// Copies record into the same metrics
+	LuaFunction copy(func);
+	copy.call();
+
+	std::vector<MetricsSnapshot> values = registry.snapshot(true);
+
+	ASSERT_EQ(1, values.size());
+	ASSERT_EQ(std::string("func"), values[0].name);
+	ASSERT_EQ(4, values[0].calls);
+	ASSERT_EQ(1, values[0].errors);
+	ASSERT_LE(values[0].p50, values[0].p99);
+	ASSERT_LE(values[0].p99, values[0].p999);
+
+	values = registry.snapshot();
+
+	ASSERT_EQ(0, values[0].calls);
+	ASSERT_EQ(0, values[0].errors);
+
+	func.setMetrics(nullptr);
+	func.call();
+
+	ASSERT_EQ(0, registry.get("func")->snapshot().calls);
+}
+
+TEST_F(LuaMetricsTest, Batch)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	MetricsRegistry& registry = MetricsRegistry::forState(L);
+
+	// The second call returns a value which is no number
+	LuaFunction func = LuaFunction::createFromCode(L, "local a = ...; if a == 2 then return {} end; return a");
+	func.setMetrics(registry.get("batch"));
+
+	std::vector<std::tuple<int>> args = { std::make_tuple(1), std::make_tuple(2), std::make_tuple(3) };
+	std::vector<int> results(args.size());
+
+	BatchResult result = func.callBatch(args.data(), args.size(), results.data(), BatchErrorPolicy::SKIP);
+	ASSERT_EQ(1, result.failed);
+
+	MetricsSnapshot values = registry.get("batch")->snapshot();
+
+	ASSERT_EQ(3, values.calls);
+	ASSERT_EQ(1, values.errors);
+}
+
+TEST_F(LuaMetricsTest, Chunks)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	ASSERT_TRUE(MetricsRegistry::find(L) == nullptr);
+
+	LuaFunction uninstrumented = LuaFunction::createFromCode(L, "return 1", "chunk");
+
+	ASSERT_TRUE(!uninstrumented.getMetrics());
+
+	MetricsRegistry& registry = MetricsRegistry::forState(L);
+	registry.enableChunkInstrumentation(true);
+
+	LuaFunction first = LuaFunction::createFromCode(L, "return 1", "chunk");
+	LuaFunction second = LuaFunction::createFromCode(L, "return 2", "chunk");
+	LuaFunction other = LuaFunction::createFromCode(L, "return 3", "other");
+
+	ASSERT_TRUE(first.getMetrics() == second.getMetrics());
+
+	first.call();
+	second.call();
+	other.call();
+
+	std::vector<MetricsSnapshot> values = registry.snapshot();
+
+	ASSERT_EQ(2, values.size());
+	ASSERT_EQ(std::string("chunk"), values[0].name);
+	ASSERT_EQ(2, values[0].calls);
+	ASSERT_EQ(std::string("other"), values[1].name);
+	ASSERT_EQ(1, values[1].calls);
+
+	registry.reset();
+
+	ASSERT_EQ(0, registry.snapshot()[0].calls);
+}
@@ -0,0 +1,143 @@
+
+#include <vector>
+
+#include "TestUtil.hpp"
+
+#include "LuaCpp/LuaMsgPack.hpp"
+#include "LuaCpp/LuaTable.hpp"
+
+using namespace luacpp;
+
+class LuaMsgPackTest : public LuaStateTest
+{
+protected:
+	std::string encodeCode(const char* code, const msgpack::Options& options = msgpack::Options())
+	{
+		std::string fullCode = std::string("return ") + code;
+		luaL_dostring(L, fullCode.c_str());
+
+		return msgpack::encode(convert::popValue<LuaValue>(L), options);
+	}
+};
+
+TEST_F(LuaMsgPackTest, Encode)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	ASSERT_EQ(std::string("\x93\x01\x02\x03", 4), encodeCode("{ 1, 2, 3 }"));
+	ASSERT_EQ(std::string("\xCD\x01\x2C", 3), encodeCode("300"));
+	ASSERT_EQ(std::string("\xFF", 1), encodeCode("-1"));
+	ASSERT_EQ(std::string("\xD0\xDF", 2), encodeCode("-33"));
+	ASSERT_EQ(std::string("\xCF\x00\x20\x00\x00\x00\x00\x00\x00", 9), encodeCode("2 ^ 53"));
+	ASSERT_EQ(std::string("\xCB\x3F\xF8\x00\x00\x00\x00\x00\x00", 9), encodeCode("1.5"));
+	ASSERT_EQ(std::string("\xA3" "abc", 4), encodeCode("'abc'"));
+	ASSERT_EQ(std::string("\xC4\x01\xFF", 3), encodeCode("'\\255'"));
+	ASSERT_EQ(std::string("\xC2", 1), encodeCode("false"));
+	ASSERT_EQ(std::string("\x81\xA1" "a" "\x01", 4), encodeCode("{ a = 1 }"));
+	ASSERT_EQ(std::string("\x80", 1), encodeCode("{}"));
+
+	msgpack::Options options;
+	options.emptyTableAsArray = true;
+	options.strings = msgpack::StringEncoding::BIN;
+	ASSERT_EQ(std::string("\x90", 1), encodeCode("{}", options));
+	ASSERT_EQ(std::string("\xC4\x01" "a", 3), encodeCode("'a'", options));
+
+	// Long strings are written directly to the sink
+	ASSERT_EQ(3 + 1000, encodeCode("string.rep('x', 1000)").size());
+
+	ASSERT_THROW(encodeCode("{ print }"), LuaException);
+	ASSERT_THROW(encodeCode("(function() local t = {}; t[1] = t; return t end)()"), LuaException);
+}
+
+TEST_F(LuaMsgPackTest, Decode)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	msgpack::push(L, "\xCA\x3F\xC0\x00\x00", 5);
+	ASSERT_DOUBLE_EQ(1.5, lua_tonumber(L, -1));
+	lua_pop(L, 1);
+
+	msgpack::push(L, "\xD1\xFF\x00", 3);
+	ASSERT_DOUBLE_EQ(-256.0, lua_tonumber(L, -1));
+	lua_pop(L, 1);
+
+	int top = lua_gettop(L);
+	ASSERT_EQ(ValueType::NIL, msgpack::decode(L, std::string("\xC0", 1)).getValueType());
+	ASSERT_EQ(top, lua_gettop(L));
+
+	// Round trip of a nested value
+	std::string data = encodeCode("{ list = { 1, -2, 3.25, 'text', true }, [1.5] = 'x', nested = { { } } }");
+
+	LuaValue value = msgpack::decode(L, data);
+	value.pushValue();
+	lua_setglobal(L, "v");
+
+	ASSERT_EQ(0, luaL_dostring(L, "return v.list[1] == 1 and v.list[2] == -2 and v.list[3] == 3.25 and "
+		"v.list[4] == 'text' and v.list[5] == true and v[1.5] == 'x' and next(v.nested[1]) == nil"));
+	ASSERT_TRUE(lua_toboolean(L, -1) != 0);
+	lua_pop(L, 1);
+
+	// Invalid data
+	for (size_t length = 0; length < data.size(); ++length)
+	{
+		ASSERT_THROW(msgpack::decode(L, data.substr(0, length)), LuaException);
+	}
+
+	ASSERT_THROW(msgpack::decode(L, data + '\x01'), LuaException);
+	ASSERT_THROW(msgpack::decode(L, std::string("\xC1", 1)), LuaException);
+	ASSERT_THROW(msgpack::decode(L, std::string("\xD4\x01\x00", 3)), LuaException);
+	ASSERT_THROW(msgpack::decode(L, std::string("\xDD\xFF\xFF\xFF\xFF", 5)), LuaException);
+	ASSERT_THROW(msgpack::decode(L, std::string("\x81\xC0\x01", 3)), LuaException);
+
+	msgpack::Options options;
+	options.maxDepth = 1;
+	ASSERT_NO_THROW(msgpack::decode(L, std::string("\x91\x01", 2), options));
+	ASSERT_THROW(msgpack::decode(L, std::string("\x91\x91\x01", 3), options), LuaException);
+}
+
+TEST_F(LuaMsgPackTest, StreamDecoder)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	std::string stream = encodeCode("{ name = 'first', values = { 1, 2, 3 } }") + encodeCode("2") +
+		encodeCode("string.rep('y', 100)");
+
+	msgpack::StreamDecoder decoder;
+	std::vector<int> types;
+
+	// Feed one byte at a time
+	for (size_t i = 0; i < stream.size(); ++i)
+	{
+		decoder.feed(stream.data() + i, 1);
+
+		while (decoder.next(L))
+		{
+			types.push_back(lua_type(L, -1));
+			lua_pop(L, 1);
+		}
+	}
+
+	ASSERT_EQ(3, types.size());
+	ASSERT_EQ(LUA_TTABLE, types[0]);
+	ASSERT_EQ(LUA_TNUMBER, types[1]);
+	ASSERT_EQ(LUA_TSTRING, types[2]);
+	ASSERT_EQ(0, decoder.getBufferedSize());
+
+	// Everything at once
+	decoder.feed(stream.data(), stream.size());
+
+	int count = 0;
+	while (decoder.next(L))
+	{
+		++count;
+		lua_pop(L, 1);
+	}
+
+	ASSERT_EQ(3, count);
+
+	decoder.feed("\xC1", 1);
+	ASSERT_THROW(decoder.next(L), LuaException);
+
+	decoder.reset();
+	ASSERT_EQ(0, decoder.getBufferedSize());
+}
@@ -0,0 +1,86 @@
+
+#include "TestUtil.hpp"
+
+#include "LuaCpp/LuaPath.hpp"
+
+using namespace luacpp;
+
+class LuaPathTest : public LuaStateTest
+{
+};
+
+TEST_F(LuaPathTest, Create)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaPath path = LuaPath::create(L, "settings.render.shadows.quality");
+
+	ASSERT_EQ(4, path.getLength());
+	ASSERT_EQ(std::string("settings.render.shadows.quality"), path.getPath());
+
+	ASSERT_THROW(LuaPath::create(L, ""), LuaException);
+	ASSERT_THROW(LuaPath::create(L, "a..b"), LuaException);
+	ASSERT_THROW(LuaPath::create(L, "a."), LuaException);
+
+	// Number keys must be exact as lua numbers
+	ASSERT_NO_THROW(LuaPath::create(L, "a.9007199254740992"));
+	ASSERT_THROW(LuaPath::create(L, "a.9007199254740993"), LuaException);
+	ASSERT_THROW(LuaPath::create(L, "a." + std::string(400, '9')), LuaException);
+}
+
+TEST_F(LuaPathTest, GetValue)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	ASSERT_EQ(0, luaL_dostring(L, "settings = { render = { shadows = { quality = 3 } }, items = { { name = 'first' } } }"));
+
+	LuaPath quality = LuaPath::create(L, "settings.render.shadows.quality");
+	LuaPath name = LuaPath::create(L, "settings.items.1.name");
+	LuaPath missing = LuaPath::create(L, "settings.render.missing.quality");
+
+	ASSERT_EQ(3, quality.getValue<int>(LUA_GLOBALSINDEX));
+	ASSERT_EQ(std::string("first"), name.getValue<std::string>(LUA_GLOBALSINDEX));
+
+	// Leading zeros do not change the number key
+	ASSERT_EQ(std::string("first"), LuaPath::create(L, "settings.items.01.name").getValue<std::string>(LUA_GLOBALSINDEX));
+
+	int value = 0;
+	ASSERT_FALSE(missing.getValue(LUA_GLOBALSINDEX, value));
+	ASSERT_THROW(missing.getValue<int>(LUA_GLOBALSINDEX), LuaException);
+
+	lua_getglobal(L, "settings");
+	LuaTable settings = convert::popValue<LuaTable>(L);
+
+	LuaPath relative = LuaPath::create(L, "render.shadows.quality");
+	ASSERT_EQ(3, relative.getValue<int>(settings));
+
+	ASSERT_FALSE(quality.pushValue(settings));
+	ASSERT_TRUE(lua_isnil(L, -1));
+	lua_pop(L, 1);
+}
+
+TEST_F(LuaPathTest, SetValue)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaTable root = LuaTable::create(L);
+
+	LuaPath path = LuaPath::create(L, "render.shadows.quality");
+
+	path.setValue(root, 5);
+	ASSERT_EQ(5, path.getValue<int>(root));
+
+	path.setValue(root, 7);
+	ASSERT_EQ(7, path.getValue<int>(root));
+
+	LuaPath blocked = LuaPath::create(L, "render.shadows.quality.level");
+	ASSERT_THROW(blocked.setValue(root, 1), LuaException);
+
+	lua_pushnumber(L, 1.0);
+	root.pushValue();
+	LuaPath::create(L, "a.b").setValue(-1, "value");
+	lua_pop(L, 1);
+	lua_pop(L, 1);
+
+	ASSERT_EQ(std::string("value"), LuaPath::create(L, "a.b").getValue<std::string>(root));
+}
@@ -0,0 +1,188 @@
+
+#include <algorithm>
+#include <set>
+#include <sstream>
+
+#include "TestUtil.hpp"
+
+#include "LuaCpp/LuaProfiler.hpp"
+#include "LuaCpp/LuaFunction.hpp"
+
+using namespace luacpp;
+
+class LuaProfilerTest : public LuaStateTest
+{
+};
+
+TEST_F(LuaProfilerTest, Sample)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaFunction func = LuaFunction::createFromCode(L,
+		"function hot() local x = 0; for i = 1, 100000 do x = x + i end; return x end\n"
+		"local result = hot()\n"
+		"return result", "script");
+
+	LuaProfiler profiler;
+
+	{
+		LuaProfiler::Scope scope(profiler, L, 100);
+
+		ASSERT_TRUE(profiler.isRunning());
+
+		func.call();
+	}
+
+	ASSERT_FALSE(profiler.isRunning());
+	ASSERT_TRUE(lua_gethook(L) == nullptr);
+
+	ASSERT_GT(profiler.getSampleCount(), 0);
+	ASSERT_EQ(0, profiler.getDroppedCount());
+
+	std::ostringstream out;
+	profiler.writeFolded(out);
+
+	std::string folded = out.str();
+
+	ASSERT_NE(std::string::npos, folded.find("main chunk ([string \"script\"]);hot ([string \"script\"]:1) "));
+
+	profiler.clear();
+
+	ASSERT_EQ(0, profiler.getSampleCount());
+}
+
+TEST_F(LuaProfilerTest, Limits)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaFunction func = LuaFunction::createFromCode(L,
+		"local function a() for i = 1, 10000 do end end\n"
+		"local function b() for i = 1, 10000 do end end\n"
+		"a(); b()");
+
+	LuaProfiler profiler(1);
+
+	{
+		LuaProfiler::Scope scope(profiler, L, 10);
+
+		func.call();
+	}
+
+	ASSERT_GT(profiler.getSampleCount(), 0);
+	ASSERT_GT(profiler.getDroppedCount(), 0);
+
+	std::ostringstream out;
+	profiler.writeFolded(out);
+
+	// Only one stack is recorded
+	std::string folded = out.str();
+	ASSERT_EQ(1, std::count(folded.begin(), folded.end(), '\n'));
+}
+
+TEST_F(LuaProfilerTest, SameChunkName)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	// Both functions are defined on the same line of a chunk with the same name
+	LuaFunction first = LuaFunction::createFromCode(L,
+		"local function first() for i = 1, 100000 do end end; first()", "script");
+	LuaFunction second = LuaFunction::createFromCode(L,
+		"local function second() for i = 1, 100000 do end end; second()", "script");
+
+	LuaProfiler profiler;
+
+	{
+		LuaProfiler::Scope scope(profiler, L, 100);
+
+		first.call();
+		second.call();
+	}
+
+	std::ostringstream out;
+	profiler.writeFolded(out);
+
+	std::string folded = out.str();
+
+	ASSERT_NE(std::string::npos, folded.find("first ([string \"script\"]:1) "));
+	ASSERT_NE(std::string::npos, folded.find("second ([string \"script\"]:1) "));
+}
+
+TEST_F(LuaProfilerTest, Restart)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaFunction func = LuaFunction::createFromCode(L,
+		"local function hot() for i = 1, 100000 do end end; hot()", "script");
+
+	LuaProfiler profiler;
+
+	for (int run = 0; run < 2; ++run)
+	{
+		LuaProfiler::Scope scope(profiler, L, 100);
+
+		func.call();
+	}
+
+	std::ostringstream out;
+	profiler.writeFolded(out);
+
+	// The samples of both runs are merged into the same lines
+	std::istringstream lines(out.str());
+	std::set<std::string> stacks;
+	std::string line;
+
+	while (std::getline(lines, line))
+	{
+		ASSERT_TRUE(stacks.insert(line.substr(0, line.rfind(' '))).second) << line;
+	}
+
+	ASSERT_FALSE(stacks.empty());
+}
+
+TEST_F(LuaProfilerTest, WithBudget)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaFunction func = LuaFunction::createFromCode(L, "while true do end");
+
+	LuaProfiler profiler;
+	LuaProfiler::Scope scope(profiler, L, 100);
+
+	ExecutionBudget budget;
+	budget.maxInstructions = 100000;
+
+	ASSERT_THROW(func.callWithBudget(budget), BudgetExceededException);
+
+	// The profiler kept sampling while the budget was active
+	ASSERT_GT(profiler.getSampleCount(), 0);
+	ASSERT_TRUE(lua_gethook(L) != nullptr);
+}
+
+TEST_F(LuaProfilerTest, StartedInsideBudget)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaFunction func = LuaFunction::createFromCode(L, "while true do end");
+
+	ExecutionBudget budget;
+	budget.maxInstructions = 10000;
+
+	ScopedBudget budgetScope(L, budget);
+	lua_Hook budgetHook = lua_gethook(L);
+
+	LuaProfiler profiler;
+
+	{
+		LuaProfiler::Scope scope(profiler, L, 100);
+		lua_Hook profilerHook = lua_gethook(L);
+
+		ASSERT_THROW(func.call(), LuaException);
+		ASSERT_TRUE(budgetScope.isExceeded());
+
+		// The profiler stays installed and still passes the events on to the budget
+		ASSERT_TRUE(lua_gethook(L) == profilerHook);
+		ASSERT_GT(profiler.getSampleCount(), 0);
+	}
+
+	ASSERT_TRUE(lua_gethook(L) == budgetHook);
+}
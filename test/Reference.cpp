@@ -57,6 +57,26 @@ TEST_F(LuaReferenceTest, IsValid)
 
 		refPtr->removeReference();
 
+		ASSERT_FALSE(refPtr->isValid());
+	}
+	{
+		ScopedLuaStackTest stackTest(L);
+
+		// nil gets no registry slot but is still a valid reference
+		lua_pushnil(L);
+
+		LuaReferencePtr refPtr = LuaReference::create(L);
+
+		lua_pop(L, 1);
+
+		ASSERT_TRUE(refPtr->isValid());
+
+		refPtr->pushValue();
+		ASSERT_TRUE(lua_isnil(L, -1));
+		lua_pop(L, 1);
+
+		refPtr->removeReference();
+
 		ASSERT_FALSE(refPtr->isValid());
 	}
 }
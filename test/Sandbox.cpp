@@ -0,0 +1,95 @@
+
+#include "TestUtil.hpp"
+
+#include "LuaCpp/LuaSandbox.hpp"
+#include "LuaCpp/LuaException.hpp"
+
+using namespace luacpp;
+
+class LuaSandboxTest : public LuaStateTest
+{
+};
+
+TEST_F(LuaSandboxTest, Isolation)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaSandbox sandbox(L);
+
+	LuaFunction first = sandbox.load("first", "counter = (counter or 0) + 1; return counter");
+	LuaFunction second = sandbox.load("second", "counter = (counter or 0) + 1; return counter");
+
+	ASSERT_EQ(1, first.call()[0].getValue<int>());
+	ASSERT_EQ(2, first.call()[0].getValue<int>());
+	ASSERT_EQ(1, second.call()[0].getValue<int>());
+
+	// Nothing leaks into the real globals
+	lua_getglobal(L, "counter");
+	ASSERT_TRUE(lua_isnil(L, -1));
+	lua_pop(L, 1);
+
+	ASSERT_EQ(1, sandbox.load("first", "return counter").call()[0].getValue<int>());
+	ASSERT_EQ(2, sandbox.getTenantCount());
+}
+
+TEST_F(LuaSandboxTest, Whitelist)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaSandbox sandbox(L);
+
+	ASSERT_EQ(std::string("ABC"), sandbox.load("tenant", "return string.upper('abc')").call()[0].getValue<std::string>());
+	ASSERT_EQ(ValueType::NUMBER, sandbox.load("tenant", "return os.time()").call()[0].getValueType());
+
+	ASSERT_EQ(ValueType::NIL, sandbox.load("tenant", "return loadstring").call()[0].getValueType());
+	ASSERT_EQ(ValueType::NIL, sandbox.load("tenant", "return os.execute").call()[0].getValueType());
+	ASSERT_EQ(ValueType::NIL, sandbox.load("tenant", "return io").call()[0].getValueType());
+
+	// Shared tables are read-only
+	ASSERT_THROW(sandbox.load("tenant", "string.upper = nil").call(), LuaException);
+	ASSERT_THROW(sandbox.load("tenant", "os.time = nil").call(), LuaException);
+
+	// Raw accesses can not modify them either
+	ASSERT_THROW(sandbox.load("tenant", "table.insert(string, 'x')").call(), LuaException);
+	ASSERT_THROW(sandbox.load("tenant", "table.sort(math)").call(), LuaException);
+	ASSERT_THROW(sandbox.load("tenant", "rawset(string, 'upper', nil)").call(), LuaException);
+
+	lua_getglobal(L, "string");
+	lua_getfield(L, -1, "upper");
+	ASSERT_TRUE(lua_isfunction(L, -1));
+	lua_rawgeti(L, -2, 1);
+	ASSERT_TRUE(lua_isnil(L, -1));
+	lua_pop(L, 3);
+
+	ASSERT_EQ(ValueType::NIL, sandbox.load("other", "return string[1]").call()[0].getValueType());
+
+	// Globals of the tenant may shadow the base
+	ASSERT_EQ(5, sandbox.load("tenant", "type = 5; return type").call()[0].getValue<int>());
+	ASSERT_EQ(std::string("function"), sandbox.load("other", "return type(type)").call()[0].getValue<std::string>());
+}
+
+TEST_F(LuaSandboxTest, Cache)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaSandbox sandbox(L, LuaSandbox::getDefaultWhitelist(), 2);
+
+	sandbox.load("a", "x = 'a'").call();
+	sandbox.load("b", "x = 'b'").call();
+
+	// Use a so b is the least recently used tenant
+	sandbox.getEnvironment("a");
+	sandbox.load("c", "x = 'c'").call();
+
+	ASSERT_EQ(2, sandbox.getTenantCount());
+	ASSERT_EQ(std::string("a"), sandbox.load("a", "return x").call()[0].getValue<std::string>());
+	ASSERT_EQ(ValueType::NIL, sandbox.load("b", "return x").call()[0].getValueType());
+
+	ASSERT_TRUE(sandbox.reset("a"));
+	ASSERT_EQ(ValueType::NIL, sandbox.load("a", "return x").call()[0].getValueType());
+
+	ASSERT_TRUE(sandbox.evict("a"));
+	ASSERT_FALSE(sandbox.evict("a"));
+	ASSERT_FALSE(sandbox.reset("a"));
+	ASSERT_EQ(1, sandbox.getTenantCount());
+}
@@ -0,0 +1,165 @@
+
+#include <vector>
+
+#include "TestUtil.hpp"
+
+#include "LuaCpp/LuaScheduler.hpp"
+
+using namespace luacpp;
+
+namespace
+{
+	// Stand-in for an I/O service, requests are completed by the test
+	struct PendingRequests
+	{
+		LuaScheduler* scheduler;
+		std::vector<LuaScheduler::TaskId> handles;
+	};
+
+	PendingRequests pending;
+
+	int fetchFunction(lua_State* L)
+	{
+		LuaScheduler::TaskId handle = pending.scheduler->suspend(L);
+
+		if (handle == 0)
+		{
+			return luaL_error(L, "Not a task!");
+		}
+
+		pending.handles.push_back(handle);
+
+		return lua_yield(L, 0);
+	}
+}
+
+class LuaSchedulerTest : public LuaStateTest
+{
+};
+
+TEST_F(LuaSchedulerTest, YieldAndFinish)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaScheduler scheduler(L);
+
+	LuaTable globals;
+	lua_pushvalue(L, LUA_GLOBALSINDEX);
+	ASSERT_TRUE(convert::popValue(L, globals));
+
+	scheduler.registerFunctions(globals);
+
+	LuaFunction func = LuaFunction::createFromCode(L, "local n = ...; for i = 1, n do yield() end; result = (result or 0) + n");
+
+	scheduler.spawn(func, { LuaValue::createValue(L, 2) });
+	scheduler.spawn(func, { LuaValue::createValue(L, 3) });
+
+	ASSERT_EQ(2, scheduler.getTaskCount());
+	ASSERT_EQ(2, scheduler.getQueueDepth());
+
+	size_t batches = 0;
+	while (scheduler.getTaskCount() > 0)
+	{
+		size_t depth = scheduler.getQueueDepth();
+		ASSERT_EQ(depth, scheduler.runOnce());
+		++batches;
+	}
+
+	ASSERT_EQ(4, batches);
+	ASSERT_EQ(7, scheduler.getStats().resumes);
+	ASSERT_GE(scheduler.getStats().totalLatency, scheduler.getStats().maxLatency);
+
+	ASSERT_EQ(5, globals.getValue<int>("result"));
+}
+
+TEST_F(LuaSchedulerTest, SuspendAndResolve)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaScheduler scheduler(L);
+	pending.scheduler = &scheduler;
+	pending.handles.clear();
+
+	lua_register(L, "fetch", &fetchFunction);
+
+	LuaFunction func = LuaFunction::createFromCode(L, "local a = fetch(); local b = fetch(); total = a + b");
+
+	scheduler.spawn(func);
+	scheduler.runOnce();
+
+	ASSERT_EQ(1, pending.handles.size());
+	ASSERT_EQ(0, scheduler.getQueueDepth());
+
+	// Nothing to do while the request is pending
+	ASSERT_EQ(0, scheduler.runOnce());
+
+	ASSERT_TRUE(scheduler.resolve(pending.handles[0], { LuaValue::createValue(L, 40) }));
+	ASSERT_FALSE(scheduler.resolve(pending.handles[0]));
+
+	scheduler.runOnce();
+
+	ASSERT_EQ(2, pending.handles.size());
+	ASSERT_TRUE(scheduler.resolve(pending.handles[1], { LuaValue::createValue(L, 2) }));
+
+	scheduler.runOnce();
+
+	ASSERT_EQ(0, scheduler.getTaskCount());
+
+	lua_getglobal(L, "total");
+	ASSERT_EQ(42, lua_tonumber(L, -1));
+	lua_pop(L, 1);
+}
+
+TEST_F(LuaSchedulerTest, Sleep)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaScheduler scheduler(L);
+
+	LuaTable globals;
+	lua_pushvalue(L, LUA_GLOBALSINDEX);
+	ASSERT_TRUE(convert::popValue(L, globals));
+
+	scheduler.registerFunctions(globals);
+
+	scheduler.spawn(LuaFunction::createFromCode(L, "sleep(1000)"));
+	scheduler.spawn(LuaFunction::createFromCode(L, "sleep(0)"));
+
+	scheduler.runOnce();
+
+	LuaScheduler::Clock::time_point deadline;
+	ASSERT_TRUE(scheduler.getNextDeadline(deadline));
+
+	// The second task can continue, the first one is still sleeping
+	scheduler.runOnce();
+
+	ASSERT_EQ(1, scheduler.getTaskCount());
+	ASSERT_EQ(0, scheduler.getQueueDepth());
+}
+
+TEST_F(LuaSchedulerTest, Errors)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaScheduler scheduler(L);
+
+	std::string message;
+	scheduler.setErrorHandler([&message](LuaScheduler::TaskId, const std::string& err) { message = err; });
+
+	LuaFunction failing = LuaFunction::createFromCode(L, "error('TestError', 0)");
+
+	scheduler.spawn(failing);
+	scheduler.runOnce();
+
+	ASSERT_STREQ("TestError", message.c_str());
+	ASSERT_EQ(0, scheduler.getTaskCount());
+
+	// The slot of the failed task gets a new thread
+	LuaFunction func = LuaFunction::createFromCode(L, "done = true");
+	scheduler.spawn(func);
+	scheduler.runOnce();
+
+	lua_getglobal(L, "done");
+	ASSERT_TRUE(lua_toboolean(L, -1) == 1);
+	lua_pop(L, 1);
+}
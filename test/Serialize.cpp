@@ -0,0 +1,95 @@
+
+#include "TestUtil.hpp"
+
+#include "LuaCpp/LuaSerialize.hpp"
+#include "LuaCpp/LuaTable.hpp"
+
+using namespace luacpp;
+
+class LuaSerializeTest : public LuaStateTest
+{
+};
+
+TEST_F(LuaSerializeTest, RoundTrip)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	ASSERT_EQ(0, luaL_dostring(L, "local shared = { 'shared' }; local t = { 1, -2, 0.5, 'text', 'text', true, false, "
+		"nested = { shared, shared }, [100] = 'sparse', [2.5] = 1e300, [false] = 'key' }; t.self = t; return t"));
+
+	LuaValue value = convert::popValue<LuaValue>(L);
+
+	std::string data = serialize::toString(value);
+
+	LuaValue copy = serialize::read(L, data);
+	ASSERT_EQ(ValueType::TABLE, copy.getValueType());
+
+	copy.pushValue();
+	lua_setglobal(L, "copy");
+
+	ASSERT_EQ(0, luaL_dostring(L, "local c = copy; return c[1] == 1 and c[2] == -2 and c[3] == 0.5 and c[4] == 'text' "
+		"and c[5] == 'text' and c[6] == true and c[7] == false and #c == 7 and c.nested[1] == c.nested[2] "
+		"and c.nested[1][1] == 'shared' and c[100] == 'sparse' and c[2.5] == 1e300 and c[false] == 'key' "
+		"and c.self == c"));
+	ASSERT_TRUE(lua_toboolean(L, -1) != 0);
+	lua_pop(L, 1);
+
+	// A single value
+	lua_pushliteral(L, "abc");
+	std::string stringData;
+	serialize::StringSink sink(stringData);
+	serialize::write(L, -1, sink);
+	lua_pop(L, 1);
+
+	serialize::push(L, stringData.data(), stringData.size());
+	ASSERT_STREQ("abc", lua_tostring(L, -1));
+	lua_pop(L, 1);
+
+	// nil at the top level
+	lua_pushnil(L);
+	std::string nilData;
+	serialize::StringSink nilSink(nilData);
+	serialize::write(L, -1, nilSink);
+	lua_pop(L, 1);
+
+	int top = lua_gettop(L);
+	ASSERT_EQ(ValueType::NIL, serialize::read(L, nilData).getValueType());
+	ASSERT_EQ(top, lua_gettop(L));
+}
+
+TEST_F(LuaSerializeTest, Errors)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	lua_getglobal(L, "print");
+	LuaValue function = convert::popValue<LuaValue>(L);
+	ASSERT_THROW(serialize::toString(function), LuaException);
+
+	ASSERT_EQ(0, luaL_dostring(L, "return { { { { 'deep' } } } }"));
+	LuaValue deep = convert::popValue<LuaValue>(L);
+
+	ASSERT_THROW(serialize::toString(deep, serialize::Limits(2, 1024)), LuaException);
+	ASSERT_THROW(serialize::toString(deep, serialize::Limits(10, 8)), LuaException);
+
+	std::string data = serialize::toString(deep);
+
+	ASSERT_THROW(serialize::read(L, data, serialize::Limits(2, 1024)), LuaException);
+	ASSERT_THROW(serialize::read(L, data, serialize::Limits(10, 8)), LuaException);
+
+	// Truncated data, bad headers and trailing bytes
+	for (size_t length = 0; length < data.size(); ++length)
+	{
+		ASSERT_THROW(serialize::read(L, data.substr(0, length)), LuaException);
+	}
+
+	ASSERT_THROW(serialize::read(L, "XXXX"), LuaException);
+	ASSERT_THROW(serialize::read(L, data + '\0'), LuaException);
+
+	// A table which claims to have more elements than the data contains
+	std::string huge("LCS\x01\x07\xFF\xFF\xFF\xFF\x0F\x00", 11);
+	ASSERT_THROW(serialize::read(L, huge), LuaException);
+
+	// A reference to a string which does not exist
+	std::string badReference("LCS\x01\x06\x00", 6);
+	ASSERT_THROW(serialize::read(L, badReference), LuaException);
+}
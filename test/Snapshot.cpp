@@ -0,0 +1,116 @@
+
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "TestUtil.hpp"
+
+#include "LuaCpp/LuaSnapshot.hpp"
+
+using namespace luacpp;
+
+class LuaSnapshotTest : public LuaStateTest
+{
+};
+
+TEST_F(LuaSnapshotTest, Create)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	ASSERT_EQ(0, luaL_dostring(L, "local t = { 'a', 'b', 3, enabled = true, render = { quality = 2.5, name = 'high' }, "
+		"func = print, [10] = 'sparse' }; t.self = t; return t"));
+
+	LuaTable table = convert::popValue<LuaTable>(L);
+
+	LuaSnapshotPtr snapshot = LuaSnapshot::create(table);
+
+	LuaSnapshot::Table root = snapshot->getRoot();
+
+	ASSERT_EQ(3, root.getLength());
+	ASSERT_STREQ("a", root.get(1).toString());
+	ASSERT_DOUBLE_EQ(3.0, root.get(3).toNumber());
+	ASSERT_TRUE(root.get(4).isNil());
+	ASSERT_TRUE(root.get(0).isNil());
+
+	// The function and the sparse index are skipped
+	ASSERT_EQ(3, root.getFieldCount());
+	ASSERT_TRUE(root["func"].isNil());
+	ASSERT_TRUE(root["missing"].isNil());
+
+	ASSERT_TRUE(root["enabled"].toBoolean());
+	ASSERT_DOUBLE_EQ(2.5, root["render"]["quality"].toNumber());
+
+	size_t length = 0;
+	ASSERT_STREQ("high", root["render"]["name"].toString(&length));
+	ASSERT_EQ(4, length);
+
+	// Cycles are preserved
+	ASSERT_STREQ("b", root["self"]["self"].toTable().get(2).toString());
+
+	// Wrong types return defaults
+	ASSERT_EQ(nullptr, root["enabled"].toString());
+	ASSERT_DOUBLE_EQ(-1.0, root["render"].toNumber(-1.0));
+	ASSERT_EQ(0, root["enabled"].toTable().getLength());
+
+	int fields = 0;
+	root.forEachField([&](const char* key, const LuaSnapshot::Value& value) { ++fields; });
+	ASSERT_EQ(3, fields);
+}
+
+TEST_F(LuaSnapshotTest, DepthLimit)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	ASSERT_EQ(0, luaL_dostring(L, "local t = {}; for i = 1, 100000 do t = { t } end; return t"));
+	LuaTable deep = convert::popValue<LuaTable>(L);
+
+	ASSERT_THROW(LuaSnapshot::create(deep), LuaException);
+
+	ASSERT_EQ(0, luaL_dostring(L, "local t = {}; for i = 1, 100 do t = { t } end; return t"));
+	LuaTable nested = convert::popValue<LuaTable>(L);
+
+	LuaSnapshotPtr snapshot = LuaSnapshot::create(nested);
+	ASSERT_EQ(1, snapshot->getRoot().getLength());
+}
+
+TEST_F(LuaSnapshotTest, Holder)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaSnapshotHolder holder;
+	ASSERT_FALSE(holder.get());
+
+	LuaTable table = LuaTable::create(L);
+	table.addValue("version", 1);
+
+	holder.publish(LuaSnapshot::create(table));
+
+	std::vector<std::thread> readers;
+	for (int i = 0; i < 4; ++i)
+	{
+		readers.push_back(std::thread([&holder]()
+		{
+			for (int j = 0; j < 1000; ++j)
+			{
+				LuaSnapshotPtr snapshot = holder.get();
+				double version = snapshot->getRoot()["version"].toNumber();
+
+				if (version != 1.0 && version != 2.0)
+				{
+					std::abort();
+				}
+			}
+		}));
+	}
+
+	table.addValue("version", 2);
+	LuaSnapshotPtr previous = holder.exchange(LuaSnapshot::create(table));
+
+	for (std::vector<std::thread>::iterator iter = readers.begin(); iter != readers.end(); ++iter)
+	{
+		iter->join();
+	}
+
+	ASSERT_DOUBLE_EQ(1.0, previous->getRoot()["version"].toNumber());
+	ASSERT_DOUBLE_EQ(2.0, holder.get()->getRoot()["version"].toNumber());
+}
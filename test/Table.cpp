@@ -1,4 +1,6 @@
 
+#include <vector>
+
 #include "TestUtil.hpp"
 
 #include "LuaCpp/LuaTable.hpp"
@@ -158,3 +160,146 @@ TEST_F(LuaTableTest, Iterator)
 		++i;
 	}
 }
+
+TEST_F(LuaTableTest, Accessor)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaTable table = LuaTable::create(L);
+
+	{
+		LuaTable::Accessor access(table);
+
+		ASSERT_EQ(lua_gettop(L), access.getStackIndex());
+
+		access.set("x", 1.5);
+		access.rawSet(1, "first");
+
+		ASSERT_TRUE(access.has("x"));
+		ASSERT_FALSE(access.has("y"));
+
+		double x = 0.0;
+		ASSERT_TRUE(access.get("x", x));
+		ASSERT_DOUBLE_EQ(1.5, x);
+
+		std::string first;
+		ASSERT_TRUE(access.rawGet(1, first));
+		ASSERT_EQ(std::string("first"), first);
+
+		ASSERT_FALSE(access.get("missing", x));
+		ASSERT_THROW(access.get<double>("missing"), LuaException);
+
+		// Values left on the stack are removed with the table
+		lua_pushnil(L);
+	}
+
+	ASSERT_EQ(1.5, table.getValue<double>("x"));
+
+	LuaTable metatable = LuaTable::create(L);
+	metatable.addValue("__index", static_cast<const LuaValue&>(table));
+
+	LuaTable derived = LuaTable::create(L);
+	derived.setMetatable(metatable);
+
+	{
+		LuaTable::Accessor access(derived);
+
+		double x = 0.0;
+		ASSERT_TRUE(access.get("x", x));
+		ASSERT_FALSE(access.rawGet("x", x));
+	}
+
+	LuaTable invalid;
+	ASSERT_THROW(LuaTable::Accessor access(invalid), LuaException);
+}
+
+TEST_F(LuaTableTest, RawAccess)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	// Counts the calls of the metamethods
+	ASSERT_EQ(0, luaL_dostring(L, "calls = 0; return setmetatable({}, {"
+		"__index = function() calls = calls + 1 end, "
+		"__newindex = function() calls = calls + 1 end })"));
+
+	LuaTable table = convert::popValue<LuaTable>(L);
+
+	table.rawSet("key", "value");
+	table.rawSetI(1, 2.5);
+
+	std::string value;
+	ASSERT_TRUE(table.rawGet("key", value));
+	ASSERT_EQ(std::string("value"), value);
+
+	ASSERT_DOUBLE_EQ(2.5, table.rawGetI<double>(1));
+	ASSERT_FALSE(table.rawGetI(2, value));
+	ASSERT_THROW(table.rawGet<std::string>("missing"), LuaException);
+
+	lua_getglobal(L, "calls");
+	ASSERT_EQ(0, lua_tointeger(L, -1));
+	lua_pop(L, 1);
+
+	table.getValue("missing", value);
+
+	lua_getglobal(L, "calls");
+	ASSERT_EQ(1, lua_tointeger(L, -1));
+	lua_pop(L, 1);
+}
+
+TEST_F(LuaTableTest, Pairs)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	ASSERT_EQ(0, luaL_dostring(L, "return { 'a', 'b', 'c', nil, 'e', x = 1, y = 2 }"));
+	LuaTable table = convert::popValue<LuaTable>(L);
+
+	int pairCount = 0;
+	int numberKeys = 0;
+
+	for (const LuaTableEntry& entry : table.pairs())
+	{
+		++pairCount;
+
+		if (entry.getKeyType() == LUA_TNUMBER)
+		{
+			// Converting the key to a string must not affect the iteration
+			ASSERT_FALSE(entry.key<std::string>().empty());
+			++numberKeys;
+		}
+		else
+		{
+			ASSERT_EQ(LUA_TNUMBER, entry.getValueType());
+		}
+
+		// Values left in the loop body are removed by the iterator
+		lua_pushnil(L);
+	}
+
+	ASSERT_EQ(6, pairCount);
+	ASSERT_EQ(4, numberKeys);
+
+	std::vector<std::string> values;
+
+	for (const LuaTableEntry& entry : table.ipairs())
+	{
+		ASSERT_EQ(static_cast<int>(values.size()) + 1, entry.key<int>());
+		values.push_back(entry.value<std::string>());
+	}
+
+	ASSERT_EQ(3, values.size());
+	ASSERT_EQ(std::string("c"), values[2]);
+
+	// Leaving the loop early restores the stack
+	for (const LuaTableEntry& entry : table.pairs())
+	{
+		ASSERT_THROW(entry.value<LuaTable>(), LuaException);
+		break;
+	}
+
+	LuaTable empty = LuaTable::create(L);
+
+	for (const LuaTableEntry& entry : empty.ipairs())
+	{
+		FAIL() << "Empty table has entry with key type " << entry.getKeyType();
+	}
+}
@@ -0,0 +1,130 @@
+
+#include "TestUtil.hpp"
+
+#include "LuaCpp/LuaThread.hpp"
+
+using namespace luacpp;
+
+class LuaThreadTest : public LuaStateTest
+{
+};
+
+TEST_F(LuaThreadTest, Resume)
+{
+	{
+		ScopedLuaStackTest stackTest(L);
+
+		LuaFunction func = LuaFunction::createFromCode(L, "local a = ...; local b = coroutine.yield(a + 1); return b * 2");
+		LuaThread thread = LuaThread::create(L, func);
+
+		ASSERT_EQ(ValueType::THREAD, thread.getValueType());
+		ASSERT_EQ(ThreadStatus::SUSPENDED, thread.getStatus());
+
+		LuaValueList yielded = thread.resume({ LuaValue::createValue(L, 1) });
+
+		ASSERT_EQ(1, yielded.size());
+		ASSERT_EQ(2, yielded[0].getValue<int>());
+		ASSERT_EQ(ThreadStatus::SUSPENDED, thread.getStatus());
+
+		LuaValueList returned = thread.resume({ LuaValue::createValue(L, 5) });
+
+		ASSERT_EQ(1, returned.size());
+		ASSERT_EQ(10, returned[0].getValue<int>());
+		ASSERT_EQ(ThreadStatus::FINISHED, thread.getStatus());
+
+		ASSERT_THROW(thread.resume(), LuaException);
+	}
+	{
+		ScopedLuaStackTest stackTest(L);
+
+		LuaFunction func = LuaFunction::createFromCode(L, "local a, b = ...; local c = coroutine.yield(a .. b); return c + 1");
+		LuaThread thread = LuaThread::create(L, func);
+
+		ASSERT_STREQ("abcdef", thread.resumeTyped<std::string>("abc", "def").c_str());
+		ASSERT_EQ(42, thread.resumeTyped<int>(41));
+	}
+	{
+		ScopedLuaStackTest stackTest(L);
+
+		LuaFunction func = LuaFunction::createFromCode(L, "coroutine.yield(); error('TestError', 0)");
+		LuaThread thread = LuaThread::create(L, func);
+
+		thread.resume();
+
+		try
+		{
+			thread.resume();
+			FAIL();
+		}
+		catch (const LuaException& err)
+		{
+			ASSERT_STREQ("TestError", err.what());
+		}
+
+		ASSERT_EQ(ThreadStatus::ERRORED, thread.getStatus());
+	}
+	{
+		ScopedLuaStackTest stackTest(L);
+
+		LuaFunction func = LuaFunction::createFromCode(L, "coroutine.yield(nil, 1); return nil");
+		LuaThread thread = LuaThread::create(L, func);
+
+		LuaValueList yielded = thread.resume();
+
+		ASSERT_EQ(2, yielded.size());
+		ASSERT_EQ(ValueType::NIL, yielded[0].getValueType());
+		ASSERT_EQ(1, yielded[1].getValue<int>());
+
+		LuaValueList returned = thread.resume();
+
+		ASSERT_EQ(1, returned.size());
+		ASSERT_EQ(ValueType::NIL, returned[0].getValueType());
+	}
+}
+
+TEST_F(LuaThreadTest, SetReference)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaThread thread = LuaThread::create(L);
+
+	ASSERT_EQ(ThreadStatus::FINISHED, thread.getStatus());
+
+	lua_pushliteral(L, "abc");
+	ASSERT_THROW(thread.setReference(LuaReference::create(L)), LuaException);
+
+	lua_pop(L, 1);
+}
+
+TEST_F(LuaThreadTest, Pool)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	LuaThreadPool pool(L, 1);
+
+	LuaFunction func = LuaFunction::createFromCode(L, "return (...) * 2");
+
+	LuaThread first = pool.acquire(func);
+	lua_State* firstState = first.getThreadState();
+
+	ASSERT_EQ(4, first.resumeTyped<int>(2));
+	ASSERT_TRUE(pool.release(first));
+	ASSERT_EQ(1, pool.getIdleCount());
+
+	LuaThread second = pool.acquire(func);
+
+	// The stack of the finished thread is reused
+	ASSERT_EQ(firstState, second.getThreadState());
+	ASSERT_EQ(0, pool.getIdleCount());
+
+	LuaFunction yielding = LuaFunction::createFromCode(L, "coroutine.yield()");
+	LuaThread suspended = pool.acquire(yielding);
+	suspended.resume();
+
+	// Suspended threads can not be reused
+	ASSERT_FALSE(pool.release(suspended));
+
+	ASSERT_EQ(6, second.resumeTyped<int>(3));
+	ASSERT_TRUE(pool.release(second));
+	ASSERT_FALSE(pool.release(LuaThread::create(L)));
+}
@@ -0,0 +1,141 @@
+
+#include <cstring>
+
+#include "TestUtil.hpp"
+
+#include "LuaCpp/LuaUsertype.hpp"
+
+using namespace luacpp;
+
+namespace
+{
+	struct Counter
+	{
+		static int instances;
+
+		int value;
+		std::string name;
+
+		Counter() : value(0) { ++instances; }
+		Counter(const Counter& other) : value(other.value), name(other.name) { ++instances; }
+		~Counter() { --instances; }
+
+		int add(int step) { value += step; return value; }
+
+		std::string describe() const { return name + ": " + std::to_string(value); }
+	};
+
+	int Counter::instances = 0;
+
+	int getValue(Counter* counter)
+	{
+		return counter->value;
+	}
+}
+
+class LuaUsertypeTest : public LuaStateTest
+{
+};
+
+TEST_F(LuaUsertypeTest, Methods)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	ASSERT_FALSE(Usertype<Counter>::isRegistered(L));
+
+	Usertype<Counter>(L, "Counter")
+		.addMethod("add", &Counter::add)
+		.addMethod("describe", &Counter::describe);
+
+	ASSERT_TRUE(Usertype<Counter>::isRegistered(L));
+
+	Counter counter;
+	counter.name = "counter";
+	Usertype<Counter>::push(L, counter);
+	lua_setglobal(L, "counter");
+
+	LuaValueList values = LuaFunction::createFromCode(L, "counter:add(2); counter:add(3); return counter:describe()").call();
+
+	ASSERT_EQ(std::string("counter: 5"), values[0].getValue<std::string>());
+
+	// The pushed value is a copy
+	ASSERT_EQ(0, counter.value);
+
+	lua_getglobal(L, "counter");
+	ASSERT_EQ(5, Usertype<Counter>::check(L, -1).value);
+	lua_pop(L, 1);
+
+	ASSERT_THROW(LuaFunction::createFromCode(L, "counter.add({}, 1)").call(), LuaException);
+	ASSERT_THROW(LuaFunction::createFromCode(L, "counter:add('x')").call(), LuaException);
+
+	lua_pushnil(L);
+	lua_setglobal(L, "counter");
+	lua_gc(L, LUA_GCCOLLECT, 0);
+
+	ASSERT_EQ(1, Counter::instances);
+}
+
+TEST_F(LuaUsertypeTest, Properties)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	Usertype<Counter>(L, "Counter")
+		.addMethod("add", &Counter::add)
+		.addProperty("value", &Counter::value)
+		.addProperty("name", &Counter::name, false);
+
+	Counter counter;
+	counter.name = "referenced";
+	Usertype<Counter>::pushReference(L, &counter);
+	lua_setglobal(L, "counter");
+
+	LuaValueList values = LuaFunction::createFromCode(L, "counter.value = 10; counter:add(1); return counter.value, counter.name").call();
+
+	ASSERT_EQ(11, values[0].getValue<int>());
+	ASSERT_EQ(std::string("referenced"), values[1].getValue<std::string>());
+	ASSERT_EQ(11, counter.value);
+
+	ASSERT_THROW(LuaFunction::createFromCode(L, "counter.name = 'x'").call(), LuaException);
+	ASSERT_THROW(LuaFunction::createFromCode(L, "counter.unknown = 1").call(), LuaException);
+	ASSERT_THROW(LuaFunction::createFromCode(L, "counter.value = 'x'").call(), LuaException);
+
+	lua_pushnil(L);
+	lua_setglobal(L, "counter");
+}
+
+TEST_F(LuaUsertypeTest, Conversion)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	Usertype<Counter>(L, "Counter");
+
+	Counter counter;
+	counter.value = 42;
+
+	LuaFunction func = bind::createFunction(L, &getValue);
+
+	Usertype<Counter>::pushReference(L, &counter);
+	LuaValue value;
+	value.setReference(LuaReference::create(L));
+	lua_pop(L, 1);
+
+	ASSERT_EQ(42, func.call({ value })[0].getValue<int>());
+	ASSERT_THROW(func.call({ LuaValue::createValue(L, 1) }), LuaException);
+
+	// Non-const references refer to the object itself
+	LuaFunction increment = bind::createFunction(L, [](Counter& target, int step) { return target.add(step); });
+
+	ASSERT_EQ(45, increment.call({ value, LuaValue::createValue(L, 3) })[0].getValue<int>());
+	ASSERT_EQ(45, counter.value);
+	ASSERT_THROW(increment.call({ LuaValue::createValue(L, 1), LuaValue::createValue(L, 3) }), LuaException);
+
+	lua_pushinteger(L, 1);
+	ASSERT_TRUE(Usertype<Counter>::get(L, -1) == nullptr);
+	lua_pop(L, 1);
+
+	// Userdata of other types are rejected by the type tag
+	std::memset(lua_newuserdata(L, 64), 0, 64);
+	ASSERT_TRUE(Usertype<Counter>::get(L, -1) == nullptr);
+	ASSERT_TRUE(Usertype<std::string>::get(L, -1) == nullptr);
+	lua_pop(L, 1);
+}
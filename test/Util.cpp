@@ -60,3 +60,114 @@ TEST_F(LuaUtilTest, GetValueName)
 	ASSERT_STREQ("userdata", luacpp::util::getValueName(ValueType::USERDATA));
 	ASSERT_STREQ("thread", luacpp::util::getValueName(ValueType::THREAD));
 }
+
+TEST_F(LuaUtilTest, ListToTable)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	std::vector<std::string> values = { "a", "b", "c" };
+
+	LuaTable table = util::listToTable(L, values);
+
+	ASSERT_EQ(3, table.getLength());
+	ASSERT_EQ(std::string("b"), table.getValue<std::string>(2));
+
+	std::vector<std::string> roundTrip;
+	util::tableToList(table, roundTrip);
+	ASSERT_TRUE(values == roundTrip);
+
+	std::vector<std::pair<std::string, int>> pairs = { std::make_pair("x", 1), std::make_pair("y", 2) };
+
+	table = util::pairsToTable(L, pairs);
+
+	ASSERT_EQ(0, table.getLength());
+	ASSERT_EQ(2, table.getValue<int>("y"));
+}
+
+TEST_F(LuaUtilTest, Transfer)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	lua_State* other = luaL_newstate();
+	luaL_openlibs(other);
+
+	ASSERT_EQ(0, luaL_dostring(L, "local shared = { 'shared' }; local t = { 1, 'two', true, a = shared, b = shared, "
+		"[2.5] = { x = 'y' } }; t.self = t; return t"));
+	LuaValue value = convert::popValue<LuaValue>(L);
+
+	LuaValue copy = util::transfer(value, other);
+	ASSERT_EQ(ValueType::TABLE, copy.getValueType());
+
+	copy.pushValue();
+	lua_setglobal(other, "v");
+
+	ASSERT_EQ(0, luaL_dostring(other, "return v[1] == 1 and v[2] == 'two' and v[3] == true and v.a == v.b "
+		"and v.a[1] == 'shared' and v[2.5].x == 'y' and v.self == v"));
+	ASSERT_TRUE(lua_toboolean(other, -1) != 0);
+	lua_pop(other, 1);
+
+	// Functions need a hook
+	ASSERT_EQ(0, luaL_dostring(L, "return { f = print }"));
+	LuaValue withFunction = convert::popValue<LuaValue>(L);
+
+	int otherTop = lua_gettop(other);
+	ASSERT_THROW(util::transfer(withFunction, other), LuaException);
+	ASSERT_EQ(otherTop, lua_gettop(other));
+
+	util::TransferHook hook = [](lua_State* source, int index, lua_State* destination)
+	{
+		if (lua_type(source, index) != LUA_TFUNCTION)
+		{
+			return false;
+		}
+
+		lua_pushliteral(destination, "function");
+		return true;
+	};
+
+	LuaValue converted = util::transfer(withFunction, other, hook);
+	converted.pushValue();
+	lua_setglobal(other, "f");
+
+	ASSERT_EQ(0, luaL_dostring(other, "return f.f"));
+	ASSERT_STREQ("function", lua_tostring(other, -1));
+	lua_pop(other, 1);
+
+	// Keys which the hook turns into nil can not be set
+	ASSERT_EQ(0, luaL_dostring(L, "return { [print] = 1 }"));
+	LuaValue functionKey = convert::popValue<LuaValue>(L);
+
+	util::TransferHook nilHook = [](lua_State*, int, lua_State* destination)
+	{
+		lua_pushnil(destination);
+		return true;
+	};
+
+	otherTop = lua_gettop(other);
+	ASSERT_THROW(util::transfer(functionKey, other, nilHook), LuaException);
+	ASSERT_EQ(otherTop, lua_gettop(other));
+
+	converted = LuaValue();
+	copy = LuaValue();
+
+	lua_close(other);
+}
+
+TEST_F(LuaUtilTest, TransferToCoroutine)
+{
+	ScopedLuaStackTest stackTest(L);
+
+	lua_State* thread = lua_newthread(L);
+
+	ASSERT_EQ(0, luaL_dostring(L, "return { print, 1 }"));
+
+	// Threads of the same state get the value itself, no copy is made and no hook is needed
+	util::transfer(L, -1, thread);
+
+	ASSERT_EQ(1, lua_gettop(thread));
+	ASSERT_EQ(LUA_TTABLE, lua_type(thread, -1));
+	ASSERT_TRUE(lua_topointer(thread, -1) == lua_topointer(L, -1));
+
+	lua_pop(thread, 1);
+	lua_pop(L, 2);
+}